@@ -1,127 +1,61 @@
 #pragma once
 
-#include <iostream>
-#include <sstream>
-#include <optional>
-#include <cassert>
-#include <algorithm>
-#include <exception>
-#include "StringStream.h"
+#include "BasicTuringMachine.h"
 
 namespace trmch {
 
-enum Move {
-    LEFT, RIGHT
-};
-
+/// Machine whose transitions are given by overriding oneStep
+/// Each step is a virtual call: prefer deriving from BasicTuringMachine when the machine type is known at compile time.
 template<
         class State = int,
         class InputSymbol = char,
         class TapeSymbol = char,
         class Input = std::string,
         class Tape = std::string>
-class AbstractTuringMachine {
+class AbstractTuringMachine
+        : public BasicTuringMachine<AbstractTuringMachine<State, InputSymbol, TapeSymbol, Input, Tape>,
+                                    State, InputSymbol, TapeSymbol, Input, Tape> {
+    using Base = BasicTuringMachine<AbstractTuringMachine, State, InputSymbol, TapeSymbol, Input, Tape>;
+
 public:
-    struct NextStep {
-        State nextState;
-        TapeSymbol writeSymbol;
-        Move whereToMove;
-    };
+    using NextStep = typename Base::NextStep;
 
     virtual ~AbstractTuringMachine() = default;
 
     AbstractTuringMachine(State q0, State qA, State qR)
-            : initialState(q0),
-              acceptState(qA),
-              rejectState(qR) {}
-
-    void checkAccept(std::initializer_list<Input> shouldAccept, std::initializer_list<Input> shouldReject) {
-        using std::cerr;
-        using std::endl;
-
-        for (auto &in : shouldAccept)
-            if (!accept(in)) {
-                cerr << "Error" << endl;
-            }
-
-        for (auto &in : shouldReject)
-            if (!reject(in)) {
-                cerr << "Error" << endl;
-            }
-    }
-
-    void debug(const Input &input) const {
-        Tape finalTape;
-
-        bool accepted = accept(input, &finalTape);
-
-        std::cout << "Execution of " << quote(input) << ":" << std::endl;
-        std::cout << (accepted ? "Accepted" : "Rejected") << ", final tape: " << quote(finalTape) << std::endl;
-    }
-
-    [[nodiscard]] bool reject(const Input &input, Tape *finalTape = nullptr) const {
-        return !accept(input, finalTape);
-    }
-
-    [[nodiscard]] bool accept(const Input &input, Tape *finalTape = nullptr) const {
-        std::optional<bool> ret;
-        Tape tape;
-        State currentState = initialState;
-        std::size_t currentSymbol = 0;
+            : Base(q0, qA, qR) {}
 
-        // First copy input to tape
-        tape = {input.begin(), input.end()};
-
-        while (!ret.has_value()) {
-            if (currentSymbol >= tape.size()) {
-                // Expand tape
-
-                tape.resize(currentSymbol + 1, blankSymbol);
-            }
-
-            NextStep nextStep;
-            nextStep.whereToMove = Move::RIGHT; /* Arbitrarly advance to right by default */
-            nextStep.writeSymbol = tape[currentSymbol]; /* By default don't overwrite anything */
-            nextStep.nextState = rejectState; /* If no transition found, reject */
-
-            oneStep(currentState, tape[currentSymbol], nextStep);
-
-            tape[currentSymbol] = nextStep.writeSymbol;
-
-            switch (nextStep.whereToMove) {
-                case Move::LEFT:
-                    if (currentSymbol != 0) --currentSymbol;
-                    break;
-
-                case Move::RIGHT:
-                    ++currentSymbol;
-                    break;
-            }
+protected:
+    virtual void oneStep(State currentState, TapeSymbol currentSymbol, NextStep &nextStep) const = 0;
+};
 
-            currentState = nextStep.nextState;
+/// Adapter exposing any machine through the virtual AbstractTuringMachine interface
+template<class Machine>
+class VirtualTuringMachine
+        : public AbstractTuringMachine<typename Machine::StateType, typename Machine::InputSymbolType,
+                                       typename Machine::TapeSymbolType, typename Machine::InputType,
+                                       typename Machine::TapeType> {
+    using Base = AbstractTuringMachine<typename Machine::StateType, typename Machine::InputSymbolType,
+                                       typename Machine::TapeSymbolType, typename Machine::InputType,
+                                       typename Machine::TapeType>;
 
-            if (currentState == acceptState) {
-                ret = true;
-            } else if (currentState == rejectState) {
-                ret = false;
-            }
-        }
+public:
+    using typename Base::NextStep;
 
-        if (finalTape) {
-            *finalTape = tape;
-        }
+    explicit VirtualTuringMachine(Machine machine)
+            : Base(machine.q0(), machine.qA(), machine.qR()),
+              m_machine(std::move(machine)) {}
 
-        return ret.value();
-    }
+    const Machine &machine() const { return m_machine; }
 
 protected:
-    virtual void oneStep(State currentState, TapeSymbol currentSymbol, NextStep &nextStep) const = 0;
+    void oneStep(typename Base::StateType currentState, typename Base::TapeSymbolType currentSymbol,
+                 NextStep &nextStep) const override {
+        callOneStep(m_machine, currentState, currentSymbol, nextStep);
+    }
 
 private:
-    State acceptState;
-    State rejectState;
-    State initialState;
-    TapeSymbol blankSymbol = ' ';
+    Machine m_machine;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <optional>
+#include <cassert>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "StringStream.h"
+#include "RunLimits.h"
+#include "ThreadPool.h"
+#include "TwoWayTape.h"
+#include "StepObserver.h"
+#include "LoopDetector.h"
+#include "Configuration.h"
+#include "RunWorkspace.h"
+
+namespace trmch {
+
+enum Move {
+    LEFT, RIGHT
+};
+
+template<class State, class TapeSymbol>
+struct BasicNextStep {
+    State nextState;
+    TapeSymbol writeSymbol;
+    Move whereToMove;
+};
+
+/// Calls machine.oneStep(), which may be protected as a virtual override would be:
+/// a class deriving from the machine can name it
+template<class Machine, class State, class TapeSymbol, class NextStep>
+void callOneStep(const Machine &machine, State currentState, TapeSymbol currentSymbol, NextStep &nextStep) {
+    if constexpr (requires { machine.oneStep(currentState, currentSymbol, nextStep); }) {
+        machine.oneStep(currentState, currentSymbol, nextStep);
+    } else {
+        struct Access : Machine {
+            static auto function() { return &Access::oneStep; }
+        };
+
+        (machine.*Access::function())(currentState, currentSymbol, nextStep);
+    }
+}
+
+/// Base of the machines, dispatching oneStep at compile time
+/// Derived implements `void oneStep(State, TapeSymbol, NextStep&) const`, public or protected, and the run loop
+/// calls it directly: there is no virtual call per step and the transition logic can be inlined into the loop.
+template<
+        class Derived,
+        class State = int,
+        class InputSymbol = char,
+        class TapeSymbol = char,
+        class Input = std::string,
+        class Tape = std::string>
+class BasicTuringMachine {
+public:
+    using StateType = State;
+    using InputSymbolType = InputSymbol;
+    using TapeSymbolType = TapeSymbol;
+    using InputType = Input;
+    using TapeType = Tape;
+
+    using NextStep = BasicNextStep<State, TapeSymbol>;
+    using ConfigurationType = Configuration<State, TapeSymbol>;
+
+    BasicTuringMachine(State q0, State qA, State qR)
+            : acceptState(qA),
+              rejectState(qR),
+              initialState(q0) {}
+
+    State q0() const { return initialState; }
+    State qA() const { return acceptState; }
+    State qR() const { return rejectState; }
+    TapeSymbol blank() const { return blankSymbol; }
+
+    struct CheckReport {
+        struct Failure {
+            Input input;
+            Verdict expected;
+            RunResult result;
+        };
+
+        std::size_t checked = 0;
+        std::vector<Failure> failures;
+
+        bool passed() const { return failures.empty(); }
+    };
+
+    /// Runs every input as a batch and reports the ones whose verdict is not the expected one
+    [[nodiscard]] CheckReport checkAccept(std::initializer_list<Input> shouldAccept,
+                                          std::initializer_list<Input> shouldReject,
+                                          const BatchOptions &options = {}) const {
+        std::vector<Input> inputs;
+        inputs.reserve(shouldAccept.size() + shouldReject.size());
+        inputs.insert(inputs.end(), shouldAccept.begin(), shouldAccept.end());
+        inputs.insert(inputs.end(), shouldReject.begin(), shouldReject.end());
+
+        const std::vector<RunResult> results = acceptBatch(inputs, options);
+
+        CheckReport report;
+        report.checked = inputs.size();
+
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            const Verdict expected = i < shouldAccept.size() ? Verdict::Accepted : Verdict::Rejected;
+
+            if (results[i].verdict != expected) {
+                report.failures.push_back({inputs[i], expected, results[i]});
+            }
+        }
+
+        return report;
+    }
+
+    /// Runs every input on a work-stealing pool
+    /// Inputs viewable as a span of symbols, such as std::string, run in the RunWorkspace of each worker thread.
+    /// @return The result of each input, in the same order as the inputs
+    [[nodiscard]] std::vector<RunResult> acceptBatch(std::span<const Input> inputs, const BatchOptions &options = {}) const {
+        assert(options.maxSteps.empty() || options.maxSteps.size() == inputs.size());
+
+        std::vector<RunResult> results(inputs.size());
+
+        std::optional<ThreadPool> ownPool;
+        ThreadPool *pool = options.pool;
+
+        if (!pool) {
+            pool = &ownPool.emplace(options.threads);
+        }
+
+        pool->parallelFor(inputs.size(), [&](std::size_t i) {
+            RunLimits limits = options.limits;
+
+            if (!options.maxSteps.empty()) {
+                limits.maxSteps = options.maxSteps[i];
+            }
+
+            if constexpr (std::is_convertible_v<const Input &, std::span<const InputSymbol>>) {
+                results[i] = run(RunWorkspace<State, TapeSymbol>::local(), inputs[i], limits);
+            } else {
+                results[i] = run(inputs[i], limits);
+            }
+        }, std::max<std::size_t>(1, inputs.size() / (pool->size() * 64)));
+
+        return results;
+    }
+
+    void debug(const Input &input) const {
+        Tape finalTape;
+
+        bool accepted = accept(input, &finalTape);
+
+        std::cout << "Execution of " << quote(input) << ":" << std::endl;
+        std::cout << (accepted ? "Accepted" : "Rejected") << ", final tape: " << quote(finalTape) << std::endl;
+    }
+
+    [[nodiscard]] bool reject(const Input &input, Tape *finalTape = nullptr) const {
+        return !accept(input, finalTape);
+    }
+
+    /// Runs until the machine halts. Never returns if the machine loops: see run() to bound the execution.
+    [[nodiscard]] bool accept(const Input &input, Tape *finalTape = nullptr) const {
+        return run(input, {}, finalTape).accepted();
+    }
+
+    /// Runs until the machine halts or one of the limits is reached
+    /// The tape is infinite in both directions, finalTape receives its cells from the first to the last non-blank one.
+    [[nodiscard]] RunResult run(const Input &input, const RunLimits &limits, Tape *finalTape = nullptr) const {
+        ConfigurationType configuration = start(input);
+        return resume(configuration, limits, finalTape);
+    }
+
+    /// Runs like run() on the tape of workspace, reset to input
+    /// The tape keeps its storage from one run to the next, so runs in a warmed-up workspace make no heap
+    /// allocation, unless loops must be detected. The final tape stays in the workspace: see RunWorkspace::finalTape().
+    [[nodiscard]] RunResult run(RunWorkspace<State, TapeSymbol> &workspace, std::span<const InputSymbol> input,
+                                const RunLimits &limits = {}) const {
+        ConfigurationType &configuration = workspace.configuration();
+
+        if (configuration.tape.blank() != blankSymbol) {
+            configuration.tape = TwoWayTape<TapeSymbol>(blankSymbol);
+        }
+
+        configuration.state = initialState;
+        configuration.head = 0;
+        configuration.steps = 0;
+        configuration.tape.assign(input.begin(), input.end());
+
+        return resume(configuration, limits);
+    }
+
+    /// The configuration before the first step on input
+    [[nodiscard]] ConfigurationType start(const Input &input) const {
+        ConfigurationType configuration(initialState, blankSymbol);
+        configuration.tape.assign(input.begin(), input.end());
+        return configuration;
+    }
+
+    /// Continues a run from configuration, which is left at the step where the run stopped
+    /// Pausing a run is stopping it with a limit: the configuration can then be saved (see saveConfiguration)
+    /// and resumed later. limits.maxSteps bounds the total steps of the run, the ones before configuration included.
+    [[nodiscard]] RunResult resume(ConfigurationType &configuration, const RunLimits &limits, Tape *finalTape = nullptr) const {
+        if (limits.detectLoops) {
+            LoopDetector<State, TapeSymbol> detector;
+            return resumeObserved(configuration, limits, detector, finalTape);
+        }
+
+        NoObserver observer;
+        return resumeObserved(configuration, limits, observer, finalTape);
+    }
+
+    /// Runs like run(), reporting the steps to observer (see NoObserver)
+    template<class Observer>
+    [[nodiscard]] RunResult runObserved(const Input &input, const RunLimits &limits, Observer &observer,
+                                        Tape *finalTape = nullptr) const {
+        ConfigurationType configuration = start(input);
+        return resumeObserved(configuration, limits, observer, finalTape);
+    }
+
+    /// Continues a run like resume(), reporting the steps to observer (see NoObserver)
+    /// The limits are checked in chunks of steps, so the step loop itself only tests for halting. At each check
+    /// configuration is up to date, and given to observer.onCheck() if the observer has one (see Checkpointer).
+    template<class Observer>
+    [[nodiscard]] RunResult resumeObserved(ConfigurationType &configuration, const RunLimits &limits, Observer &observer,
+                                           Tape *finalTape = nullptr) const {
+        using Clock = RunLimits::Clock;
+
+        std::optional<Verdict> ret;
+        TwoWayTape<TapeSymbol> &tape = configuration.tape;
+        State currentState = configuration.state;
+        std::ptrdiff_t currentSymbol = configuration.head;
+        std::size_t steps = configuration.steps;
+
+        observer.onStart(tape, currentState, currentSymbol);
+
+        while (!ret.has_value()) {
+            configuration.state = currentState;
+            configuration.head = currentSymbol;
+            configuration.steps = steps;
+
+            if constexpr (requires { observer.onCheck(configuration); }) {
+                observer.onCheck(configuration);
+            }
+
+            if (limits.stopToken.stop_requested()) {
+                ret = Verdict::Cancelled;
+                break;
+            }
+
+            // A resumed configuration may already be past the budget
+            if (steps >= limits.maxSteps || (limits.deadline && Clock::now() >= *limits.deadline)) {
+                ret = Verdict::OutOfFuel;
+                break;
+            }
+
+            const std::size_t chunkEnd = steps + std::min(limits.maxSteps - steps, RunLimits::checkInterval);
+
+            while (steps != chunkEnd && !ret.has_value()) {
+                if (currentSymbol < tape.first() || currentSymbol >= tape.last()) {
+                    // Expand tape
+
+                    tape.reserve(currentSymbol);
+                }
+
+                // The head moves by one cell per step, so it can't leave the allocated cells before that many steps
+                TapeSymbol *cells = tape.data();
+                std::ptrdiff_t cell = tape.origin() + currentSymbol;
+                const auto safeSteps = static_cast<std::size_t>(std::min<std::ptrdiff_t>(cell, tape.capacity() - 1 - cell) + 1);
+                const std::size_t stop = steps + std::min(chunkEnd - steps, safeSteps);
+
+                while (steps != stop) {
+                    const State previousState = currentState;
+                    const TapeSymbol read = cells[cell];
+
+                    NextStep nextStep;
+                    nextStep.whereToMove = Move::RIGHT; /* Arbitrarly advance to right by default */
+                    nextStep.writeSymbol = read; /* By default don't overwrite anything */
+                    nextStep.nextState = rejectState; /* If no transition found, reject */
+
+                    step(currentState, read, nextStep);
+
+                    cells[cell] = nextStep.writeSymbol;
+
+                    switch (nextStep.whereToMove) {
+                        case Move::LEFT:
+                            --cell;
+                            break;
+
+                        case Move::RIGHT:
+                            ++cell;
+                            break;
+                    }
+
+                    currentState = nextStep.nextState;
+                    ++steps;
+
+                    if constexpr (Observer::observesSteps) {
+                        const std::ptrdiff_t head = cell - tape.origin() - direction(nextStep.whereToMove);
+                        ret = observer.onStep(StepEvent<State, TapeSymbol>{
+                            steps, previousState, read, head, currentState, nextStep.writeSymbol,
+                            direction(nextStep.whereToMove)}, tape);
+                    }
+
+                    if (currentState == acceptState) {
+                        ret = Verdict::Accepted;
+                        break;
+                    } else if (currentState == rejectState) {
+                        ret = Verdict::Rejected;
+                        break;
+                    } else if (ret.has_value()) {
+                        break;
+                    }
+
+                    // A self-loop keeps applying to the following cells as long as they hold a swept symbol:
+                    // cross all of them at once, each one still counting as a step
+                    if constexpr (!Observer::observesSteps && requires { derived().sweepRule(currentState, nextStep.whereToMove); }) {
+                        if (currentState == previousState && nextStep.writeSymbol == read) {
+                            if (const auto *rule = derived().sweepRule(currentState, nextStep.whereToMove)) {
+                                const int direction = BasicTuringMachine::direction(nextStep.whereToMove);
+                                const std::ptrdiff_t allocated = direction > 0 ? std::ptrdiff_t(tape.capacity()) - cell : cell + 1;
+                                const std::size_t limit = std::min(chunkEnd - steps, static_cast<std::size_t>(std::max<std::ptrdiff_t>(allocated, 0)));
+                                const std::size_t swept = rule->scan(cells, cell, direction, limit);
+
+                                if (swept != 0) {
+                                    cell += direction * static_cast<std::ptrdiff_t>(swept);
+                                    steps += swept;
+                                    break; /* The head may now be anywhere: recompute how far it can go safely */
+                                }
+                            }
+                        }
+                    }
+                }
+
+                currentSymbol = cell - tape.origin();
+            }
+        }
+
+        configuration.state = currentState;
+        configuration.head = currentSymbol;
+        configuration.steps = steps;
+
+        if (finalTape) {
+            tape.contentsInto(*finalTape);
+        }
+
+        return {ret.value(), steps, currentSymbol};
+    }
+
+private:
+    static int direction(Move move) {
+        return move == Move::LEFT ? -1 : 1;
+    }
+
+    const Derived &derived() const {
+        return static_cast<const Derived &>(*this);
+    }
+
+    void step(State currentState, TapeSymbol currentSymbol, NextStep &nextStep) const {
+        callOneStep(derived(), currentState, currentSymbol, nextStep);
+    }
+
+    State acceptState;
+    State rejectState;
+    State initialState;
+    TapeSymbol blankSymbol = ' ';
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include "TuringMachine.h"
+#include "ThreadPool.h"
+#include "TwoWayTape.h"
+#include "LoopDetector.h"
+
+namespace trmch {
+
+/// Machine of a busy beaver search: up to maxStates states and maxSymbols symbols, symbol 0 being blank
+///
+/// The transitions live in a fixed array, so machines are copied and modified without allocating.
+/// A transition is undefined or halts, or writes a symbol, moves and goes to a state.
+class EnumeratedMachine
+{
+public:
+    static constexpr unsigned maxStates = 8;
+    static constexpr unsigned maxSymbols = 8;
+    static constexpr std::uint8_t undefined = 0xFF;
+    static constexpr std::uint8_t halt = 0xFE;
+
+    struct Transition {
+        std::uint8_t write = 0;
+        std::int8_t move = 1;               ///< -1 for LEFT, 1 for RIGHT
+        std::uint8_t next = undefined;      ///< State, undefined or halt
+    };
+
+    EnumeratedMachine() = default;
+
+    /// @throw std::invalid_argument If there are too many states or symbols
+    EnumeratedMachine(unsigned states, unsigned symbols)
+        : m_states(static_cast<std::uint8_t>(states)),
+          m_symbols(static_cast<std::uint8_t>(symbols))
+    {
+        if(states == 0 || states > maxStates || symbols < 2 || symbols > maxSymbols) {
+            throw std::invalid_argument(StringStream() << "Machines have 1 to " << maxStates << " states and 2 to "
+                                                       << maxSymbols << " symbols");
+        }
+    }
+
+    unsigned states() const { return m_states; }
+    unsigned symbols() const { return m_symbols; }
+
+    Transition& operator()(unsigned state, unsigned symbol) { return m_table[state * maxSymbols + symbol]; }
+    const Transition& operator()(unsigned state, unsigned symbol) const { return m_table[state * maxSymbols + symbol]; }
+
+    /// Standard text form, such as 1RB1LB_1LA1RZ for the 2-state champion: states are letters from A, halting
+    /// is Z and an undefined transition is ---
+    std::string toString() const
+    {
+        std::string text;
+
+        for(unsigned state = 0; state < m_states; ++state) {
+            if(state != 0) {
+                text += '_';
+            }
+
+            for(unsigned symbol = 0; symbol < m_symbols; ++symbol) {
+                const Transition& transition = (*this)(state, symbol);
+
+                if(transition.next == undefined) {
+                    text += "---";
+                } else {
+                    text += static_cast<char>('0' + transition.write);
+                    text += transition.move < 0 ? 'L' : 'R';
+                    text += transition.next == halt ? 'Z' : static_cast<char>('A' + transition.next);
+                }
+            }
+        }
+
+        return text;
+    }
+
+    /// The same machine on the runtime engine: state i is i, symbol 0 is ' ' and symbol k is '0' + k,
+    /// halting accepts in state states() and undefined transitions reject
+    TuringMachine<> toTuringMachine() const
+    {
+        const auto symbol = [](unsigned code) { return code == 0 ? ' ' : static_cast<char>('0' + code); };
+        std::vector<TuringMachine<>::Transition> transitions;
+
+        for(unsigned state = 0; state < m_states; ++state) {
+            for(unsigned code = 0; code < m_symbols; ++code) {
+                const Transition& transition = (*this)(state, code);
+
+                if(transition.next != undefined) {
+                    transitions.push_back({static_cast<int>(state), symbol(code), {
+                        transition.next == halt ? static_cast<int>(m_states) : transition.next,
+                        symbol(transition.write), transition.move < 0 ? LEFT : RIGHT}});
+                }
+            }
+        }
+
+        return {0, static_cast<int>(m_states), -1, transitions};
+    }
+
+private:
+    std::uint8_t m_states = 0;
+    std::uint8_t m_symbols = 0;
+    std::array<Transition, maxStates * maxSymbols> m_table{};
+};
+
+struct BusyBeaverOptions {
+    unsigned states = 2;
+    unsigned symbols = 2;
+    std::size_t maxSteps = 1000;        ///< Machines still running after that many steps are holdouts, unless proven to loop
+    std::size_t maxHoldouts = 1000;     ///< Holdouts listed in the result, the others are only counted
+    std::size_t maxChampions = 16;      ///< Ties listed in the result for each record
+    unsigned threads = 0;               ///< Workers of the pool created for the search, 0 for one per hardware thread
+    ThreadPool* pool = nullptr;         ///< Pool to reuse instead of creating one, threads is then ignored
+};
+
+struct BusyBeaverResult {
+    std::uint64_t machines = 0;     ///< Machines run, each standing for every machine only differing by unreached transitions
+    std::uint64_t halting = 0;
+    std::uint64_t nonHalting = 0;   ///< Proven not to halt: pruned, or found looping by LoopDetector
+    std::uint64_t holdouts = 0;     ///< Undecided within maxSteps
+
+    std::size_t maxSteps = 0;       ///< S: most steps of a halting machine, the halting step included
+    std::size_t maxOnes = 0;        ///< Sigma: most non-blank cells left by a halting machine
+    std::vector<EnumeratedMachine> stepsChampions;
+    std::vector<EnumeratedMachine> onesChampions;
+    std::vector<EnumeratedMachine> holdoutMachines;
+};
+
+/// Runs every machine of options.states states and options.symbols symbols in tree normal form, from a blank tape
+///
+/// Machines start with no transition and are run until they reach an undefined one. That machine halts there if
+/// the transition halts, and is extended with each other choice for it. Choices that only rename states or symbols
+/// are skipped by only allowing the next unused state or symbol, the first move is to the right by mirror symmetry,
+/// and machines running away on blank cells through a cycle of states are stopped as soon as they start to.
+/// So each machine run stands for all the machines agreeing on the transitions it reaches.
+///
+/// The first levels of the tree are expanded on the calling thread, then the subtrees are explored depth-first by the
+/// workers of a pool, which steal subtrees from each other. Each subtree reuses the same tape, loop detector and
+/// machine storage, so that machines don't allocate once the tape has grown: only holdouts are copied to be listed.
+/// Machines still running at the end of their budget are run again under LoopDetector to prove that they loop.
+class BusyBeaverSearch
+{
+public:
+    /// @throw std::invalid_argument If there are too many states or symbols
+    explicit BusyBeaverSearch(const BusyBeaverOptions& options)
+        : m_options(options),
+          m_root(options.states, options.symbols) {}
+
+    BusyBeaverResult run() const
+    {
+        BusyBeaverResult result;
+
+        std::optional<ThreadPool> ownPool;
+        ThreadPool* pool = m_options.pool;
+
+        if(!pool) {
+            pool = &ownPool.emplace(m_options.threads);
+        }
+
+        /* Breadth-first until there are enough subtrees to balance the workers */
+        std::vector<Node> frontier{{m_root, 0, 1, 1}};
+        Workspace workspace;
+
+        while(!frontier.empty() && frontier.size() < std::size_t(pool->size()) * 64) {
+            std::vector<Node> next;
+
+            for(const Node& node : frontier) {
+                expand(node, workspace, result, [&next](const Node& child) { next.push_back(child); });
+            }
+
+            frontier = std::move(next);
+        }
+
+        std::mutex mutex;
+
+        pool->parallelFor(frontier.size(), [&](std::size_t i) {
+            BusyBeaverResult partial;
+            Workspace subtreeWorkspace;
+            explore(frontier[i], subtreeWorkspace, partial);
+
+            std::lock_guard lock(mutex);
+            merge(result, std::move(partial));
+        });
+
+        return result;
+    }
+
+private:
+    /// A machine of the tree with the number of transitions, states and symbols it uses
+    struct Node {
+        EnumeratedMachine machine;
+        unsigned defined;
+        unsigned usedStates;
+        unsigned usedSymbols;
+    };
+
+    /// Tape and loop detector reused by every run of a subtree: only the cells visited by the previous run are cleared
+    struct Workspace {
+        TwoWayTape<std::uint8_t> tape{0};
+        std::ptrdiff_t visitedMin = 0;
+        std::ptrdiff_t visitedMax = -1;
+        LoopDetector<unsigned, std::uint8_t> detector;
+
+        void reset()
+        {
+            if(tape.capacity() == 0) {
+                tape.assignBlank(0, 1, 0);
+            }
+
+            for(std::ptrdiff_t position = visitedMin; position <= visitedMax; ++position) {
+                tape[position] = 0;
+            }
+
+            visitedMin = visitedMax = 0;
+        }
+    };
+
+    /// How a run stopped: on an undefined transition after steps steps, proven to loop, or out of budget
+    struct Stop {
+        Verdict verdict;    ///< Rejected for an undefined transition
+        std::size_t steps;
+        unsigned state;
+        unsigned symbol;
+        std::ptrdiff_t head;
+    };
+
+    /// Whether state, on a cell beyond which the tape is blank toward direction, keeps moving that way on blank cells
+    /// through a cycle of states: the machine then never halts
+    static bool escapes(const EnumeratedMachine& machine, unsigned state, int direction)
+    {
+        std::uint32_t seen = 0;
+
+        while(!(seen >> state & 1)) {
+            seen |= std::uint32_t(1) << state;
+            const EnumeratedMachine::Transition& transition = machine(state, 0);
+
+            if(transition.next >= machine.states() || transition.move != direction) {
+                return false;
+            }
+
+            state = transition.next;
+        }
+
+        return true;
+    }
+
+    /// Runs from a blank tape, reporting each step to observer if it observes steps (see NoObserver)
+    template<class Observer>
+    Stop simulate(const EnumeratedMachine& machine, Workspace& workspace, Observer& observer) const
+    {
+        workspace.reset();
+
+        TwoWayTape<std::uint8_t>& tape = workspace.tape;
+        std::ptrdiff_t head = 0;
+        unsigned state = 0;
+
+        observer.onStart(tape, state, head);
+
+        for(std::size_t steps = 0;; ++steps) {
+            const unsigned symbol = tape[head];
+            const EnumeratedMachine::Transition& transition = machine(state, symbol);
+
+            if(transition.next == EnumeratedMachine::undefined) {
+                return {Verdict::Rejected, steps, state, symbol, head};
+            }
+
+            if(steps == m_options.maxSteps) {
+                return {Verdict::OutOfFuel, steps, state, symbol, head};
+            }
+
+            tape[head] = transition.write;
+            head += transition.move;
+
+            if(head < tape.first() || head >= tape.last()) {
+                tape.reserve(head);
+            }
+
+            if(head < workspace.visitedMin || head > workspace.visitedMax) {
+                workspace.visitedMin = std::min(workspace.visitedMin, head);
+                workspace.visitedMax = std::max(workspace.visitedMax, head);
+
+                if(escapes(machine, transition.next, transition.move)) {
+                    return {Verdict::Loops, steps + 1, transition.next, 0, head};
+                }
+            }
+
+            if constexpr (Observer::observesSteps) {
+                const StepEvent<unsigned, std::uint8_t> event{steps + 1, state, static_cast<std::uint8_t>(symbol),
+                                                              head - transition.move, transition.next,
+                                                              transition.write, transition.move};
+
+                if(observer.onStep(event, tape) == Verdict::Loops) {
+                    return {Verdict::Loops, steps + 1, transition.next, 0, head};
+                }
+            }
+
+            state = transition.next;
+        }
+    }
+
+    /// Runs the machine of node, records how it ends, and calls visit with each extension
+    template<class Visitor>
+    void expand(const Node& node, Workspace& workspace, BusyBeaverResult& result, const Visitor& visit) const
+    {
+        ++result.machines;
+
+        NoObserver observer;
+        const Stop stop = simulate(node.machine, workspace, observer);
+
+        if(stop.verdict == Verdict::Loops) {
+            ++result.nonHalting;
+            return;
+        }
+
+        if(stop.verdict == Verdict::OutOfFuel) {
+            decide(node.machine, workspace, result);
+            return;
+        }
+
+        /* Halting on the undefined transition, which writes a 1 as busy beavers do */
+        {
+            EnumeratedMachine halting = node.machine;
+            halting(stop.state, stop.symbol) = {1, 1, EnumeratedMachine::halt};
+
+            std::size_t ones = stop.symbol == 0 ? 1 : 0;
+
+            for(std::ptrdiff_t position = workspace.visitedMin; position <= workspace.visitedMax; ++position) {
+                ones += workspace.tape[position] != 0;
+            }
+
+            ++result.halting;
+            record(result.maxSteps, result.stepsChampions, stop.steps + 1, halting);
+            record(result.maxOnes, result.onesChampions, ones, halting);
+        }
+
+        /* The last transition can only halt */
+        if(node.defined + 1 == m_root.states() * m_root.symbols()) {
+            return;
+        }
+
+        /* Whether the head is on the leftmost or rightmost visited cell, before children reuse the workspace */
+        const bool leftmost = stop.head <= workspace.visitedMin;
+        const bool rightmost = stop.head >= workspace.visitedMax;
+        const bool first = node.defined == 0;
+        const unsigned states = std::min(node.usedStates + 1, m_root.states());
+        const unsigned symbols = std::min(node.usedSymbols + 1, m_root.symbols());
+
+        for(unsigned next = 0; next < states; ++next) {
+            for(unsigned write = 0; write < symbols; ++write) {
+                for(const std::int8_t move : {std::int8_t(-1), std::int8_t(1)}) {
+                    if(first && move < 0) {
+                        continue;
+                    }
+
+                    /* Reading blank, writing and moving on to blank in the same state forever */
+                    if(next == stop.state && stop.symbol == 0 && (move > 0 ? rightmost : leftmost)) {
+                        ++result.machines;
+                        ++result.nonHalting;
+                        continue;
+                    }
+
+                    Node child = node;
+                    child.machine(stop.state, stop.symbol) = {static_cast<std::uint8_t>(write), move, static_cast<std::uint8_t>(next)};
+                    child.defined = node.defined + 1;
+                    child.usedStates = std::max(node.usedStates, next + 1);
+                    child.usedSymbols = std::max(node.usedSymbols, write + 1);
+                    visit(child);
+                }
+            }
+        }
+    }
+
+    void explore(const Node& node, Workspace& workspace, BusyBeaverResult& result) const
+    {
+        expand(node, workspace, result, [&](const Node& child) { explore(child, workspace, result); });
+    }
+
+    /// Machines out of budget are run again with the same budget under LoopDetector
+    void decide(const EnumeratedMachine& machine, Workspace& workspace, BusyBeaverResult& result) const
+    {
+        if(simulate(machine, workspace, workspace.detector).verdict == Verdict::Loops) {
+            ++result.nonHalting;
+            return;
+        }
+
+        ++result.holdouts;
+
+        if(result.holdoutMachines.size() < m_options.maxHoldouts) {
+            result.holdoutMachines.push_back(machine);
+        }
+    }
+
+    void record(std::size_t& best, std::vector<EnumeratedMachine>& champions, std::size_t value,
+                const EnumeratedMachine& machine) const
+    {
+        if(value > best) {
+            best = value;
+            champions.clear();
+        }
+
+        if(value == best && champions.size() < m_options.maxChampions) {
+            champions.push_back(machine);
+        }
+    }
+
+    void merge(BusyBeaverResult& result, BusyBeaverResult&& partial) const
+    {
+        result.machines += partial.machines;
+        result.halting += partial.halting;
+        result.nonHalting += partial.nonHalting;
+        result.holdouts += partial.holdouts;
+
+        for(const EnumeratedMachine& machine : partial.stepsChampions) {
+            record(result.maxSteps, result.stepsChampions, partial.maxSteps, machine);
+        }
+
+        for(const EnumeratedMachine& machine : partial.onesChampions) {
+            record(result.maxOnes, result.onesChampions, partial.maxOnes, machine);
+        }
+
+        for(const EnumeratedMachine& machine : partial.holdoutMachines) {
+            if(result.holdoutMachines.size() < m_options.maxHoldouts) {
+                result.holdoutMachines.push_back(machine);
+            }
+        }
+    }
+
+    BusyBeaverOptions m_options;
+    EnumeratedMachine m_root;
+};
+
+}
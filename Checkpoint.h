@@ -0,0 +1,368 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <fstream>
+#include <utility>
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <type_traits>
+#include "StringStream.h"
+#include "StepObserver.h"
+#include "Configuration.h"
+
+namespace trmch {
+
+/// Checkpoint file, all integers in the byte order of the machine that wrote it:
+///   "TRMCHCK1", u32 sizeof(State), u32 sizeof(TapeSymbol), State state, i64 head, u64 steps,
+///   TapeSymbol blank, u64 input size, i64 first non-blank position, u64 run count, the runs
+/// A run is u8 0 and u64 length for blank cells, or u8 1, u64 length and the cells.
+namespace checkpoint {
+    inline constexpr std::array<char, 8> magic{'T', 'R', 'M', 'C', 'H', 'C', 'K', '1'};
+
+    /// Blank areas at least this long are stored as a run length
+    inline constexpr std::size_t minimumBlankRun = 16;
+
+    /// Tapes loaded by loadConfiguration() span at most this many cells unless told otherwise
+    inline constexpr std::size_t defaultMaximumCells = std::size_t(1) << 28;
+}
+
+/// Writes configuration to out, blank areas of the tape being run-length encoded
+template<class State, class TapeSymbol>
+void saveConfiguration(std::ostream& out, const Configuration<State, TapeSymbol>& configuration)
+{
+    static_assert(std::is_trivially_copyable_v<State> && std::is_trivially_copyable_v<TapeSymbol>,
+                  "Checkpoints store states and symbols as raw bytes");
+
+    const auto write = [&out](const auto& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    const TwoWayTape<TapeSymbol>& tape = configuration.tape;
+    std::ptrdiff_t first = tape.first();
+    std::ptrdiff_t last = tape.last();
+
+    while(first < last && tape[first] == tape.blank()) ++first;
+    while(last > first && tape[last - 1] == tape.blank()) --last;
+
+    /* Runs as [begin, end) positions, blank or not */
+    std::vector<std::pair<std::ptrdiff_t, std::ptrdiff_t>> runs;
+
+    for(std::ptrdiff_t position = first; position < last;) {
+        std::ptrdiff_t end = position;
+
+        while(end < last && tape[end] == tape.blank()) ++end;
+
+        if(end - position >= static_cast<std::ptrdiff_t>(checkpoint::minimumBlankRun)) {
+            runs.emplace_back(position, end);
+            position = end;
+            continue;
+        }
+
+        /* Cells up to the next long blank area */
+        end = position;
+        std::ptrdiff_t blanks = 0;
+
+        while(end < last && blanks < static_cast<std::ptrdiff_t>(checkpoint::minimumBlankRun)) {
+            blanks = tape[end] == tape.blank() ? blanks + 1 : 0;
+            ++end;
+        }
+
+        if(blanks >= static_cast<std::ptrdiff_t>(checkpoint::minimumBlankRun)) {
+            end -= blanks;
+        }
+
+        runs.emplace_back(position, end);
+        position = end;
+    }
+
+    out.write(checkpoint::magic.data(), checkpoint::magic.size());
+    write(static_cast<std::uint32_t>(sizeof(State)));
+    write(static_cast<std::uint32_t>(sizeof(TapeSymbol)));
+    write(configuration.state);
+    write(static_cast<std::int64_t>(configuration.head));
+    write(static_cast<std::uint64_t>(configuration.steps));
+    write(tape.blank());
+    write(static_cast<std::uint64_t>(tape.inputSize()));
+    write(static_cast<std::int64_t>(first));
+    write(static_cast<std::uint64_t>(runs.size()));
+
+    for(const auto& [begin, end] : runs) {
+        const bool blank = tape[begin] == tape.blank();
+
+        write(static_cast<std::uint8_t>(blank ? 0 : 1));
+        write(static_cast<std::uint64_t>(end - begin));
+
+        if(!blank) {
+            out.write(reinterpret_cast<const char*>(&tape[begin]), static_cast<std::streamsize>((end - begin) * sizeof(TapeSymbol)));
+        }
+    }
+}
+
+/// Every length and position is checked before anything is allocated for it: the tape of a corrupt file can't
+/// span more than maximumCells cells, nor hold more stored cells than the stream has bytes left when in can seek.
+/// @throw std::runtime_error If in doesn't hold a checkpoint for these State and TapeSymbol types, or its tape
+///                           spans more than maximumCells cells
+template<class State, class TapeSymbol>
+Configuration<State, TapeSymbol> loadConfiguration(std::istream& in, std::size_t maximumCells = checkpoint::defaultMaximumCells)
+{
+    const auto read = [&in]<class T>(T& value) {
+        in.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+        if(!in) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+    };
+
+    std::array<char, checkpoint::magic.size()> magic{};
+    std::uint32_t stateSize = 0;
+    std::uint32_t symbolSize = 0;
+
+    in.read(magic.data(), magic.size());
+    read(stateSize);
+    read(symbolSize);
+
+    if(magic != checkpoint::magic || stateSize != sizeof(State) || symbolSize != sizeof(TapeSymbol)) {
+        throw std::runtime_error("Not a checkpoint of a machine with these state and symbol types");
+    }
+
+    State state;
+    std::int64_t head;
+    std::uint64_t steps;
+    TapeSymbol blank;
+    std::uint64_t inputSize;
+    std::int64_t first;
+    std::uint64_t runCount;
+
+    read(state);
+    read(head);
+    read(steps);
+    read(blank);
+    read(inputSize);
+    read(first);
+    read(runCount);
+
+    const auto maximum = static_cast<std::uint64_t>(maximumCells);
+    const auto isWithin = [maximum](std::int64_t position) {
+        return position >= -static_cast<std::int64_t>(maximum) && position <= static_cast<std::int64_t>(maximum);
+    };
+
+    if(!isWithin(head) || !isWithin(first) || inputSize > maximum) {
+        throw std::runtime_error("Corrupt checkpoint: the tape is too long");
+    }
+
+    /* Bytes left in the stream, to refuse stored runs longer than the file before allocating them */
+    std::optional<std::uint64_t> streamEnd;
+
+    if(const std::istream::pos_type position = in.tellg(); position != std::istream::pos_type(-1)) {
+        in.seekg(0, std::ios::end);
+        const std::istream::pos_type end = in.tellg();
+        in.seekg(position);
+
+        if(end != std::istream::pos_type(-1) && in) {
+            streamEnd = static_cast<std::uint64_t>(end);
+        }
+    }
+
+    Configuration<State, TapeSymbol> configuration(state, blank);
+    configuration.head = static_cast<std::ptrdiff_t>(head);
+    configuration.steps = static_cast<std::size_t>(steps);
+
+    std::vector<TapeSymbol> cells;
+
+    for(std::uint64_t run = 0; run < runCount; ++run) {
+        std::uint8_t kind;
+        std::uint64_t length;
+
+        read(kind);
+        read(length);
+
+        if(length > maximum - cells.size()) {
+            throw std::runtime_error("Corrupt checkpoint: the tape is too long");
+        }
+
+        if(kind != 0 && streamEnd && length > (*streamEnd - static_cast<std::uint64_t>(in.tellg())) / sizeof(TapeSymbol)) {
+            throw std::runtime_error("Truncated checkpoint");
+        }
+
+        const std::size_t offset = cells.size();
+        cells.resize(offset + length, blank);
+
+        if(kind != 0) {
+            in.read(reinterpret_cast<char*>(cells.data() + offset), static_cast<std::streamsize>(length * sizeof(TapeSymbol)));
+
+            if(!in) {
+                throw std::runtime_error("Truncated checkpoint");
+            }
+        }
+    }
+
+    const std::int64_t begin = std::min<std::int64_t>({first, head, 0});
+    const std::int64_t end = std::max<std::int64_t>({first + static_cast<std::int64_t>(cells.size()), head + 1,
+                                                     static_cast<std::int64_t>(inputSize)});
+
+    if(static_cast<std::uint64_t>(end - begin) > maximum) {
+        throw std::runtime_error("Corrupt checkpoint: the tape is too long");
+    }
+
+    TwoWayTape<TapeSymbol>& tape = configuration.tape;
+    tape.assignBlank(std::min<std::ptrdiff_t>(first, configuration.head),
+                     std::max<std::ptrdiff_t>(first + static_cast<std::ptrdiff_t>(cells.size()), configuration.head + 1),
+                     static_cast<std::size_t>(inputSize));
+
+    if(!cells.empty()) {
+        std::copy(cells.begin(), cells.end(), &tape[static_cast<std::ptrdiff_t>(first)]);
+    }
+
+    return configuration;
+}
+
+/// Writes configuration to a temporary file renamed over path, so path always holds a complete checkpoint
+/// @throw std::runtime_error If the file can't be written
+template<class State, class TapeSymbol>
+void saveConfiguration(const std::filesystem::path& path, const Configuration<State, TapeSymbol>& configuration)
+{
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        saveConfiguration(out, configuration);
+        out.close();
+
+        if(!out) {
+            throw std::runtime_error(StringStream() << "Cannot write the checkpoint " << temporary);
+        }
+    }
+
+    std::filesystem::rename(temporary, path);
+}
+
+/// @throw std::runtime_error If path doesn't hold a checkpoint for these State and TapeSymbol types, see above
+template<class State, class TapeSymbol>
+Configuration<State, TapeSymbol> loadConfiguration(const std::filesystem::path& path,
+                                                   std::size_t maximumCells = checkpoint::defaultMaximumCells)
+{
+    std::ifstream in(path, std::ios::binary);
+
+    if(!in) {
+        throw std::runtime_error(StringStream() << "Cannot open the checkpoint " << path);
+    }
+
+    return loadConfiguration<State, TapeSymbol>(in, maximumCells);
+}
+
+/// Observer saving the configuration of a run to a file periodically, see BasicTuringMachine::resumeObserved
+///
+/// The run loop only copies the cells from the first to the last non-blank one into a snapshot kept from one
+/// checkpoint to the next, so a checkpoint costs the run a copy of the written cells but no allocation once the
+/// snapshot has grown. The file is written on a background thread. If the previous checkpoint is still being
+/// written when the next one is due, that one is skipped instead of stalling the run.
+/// Errors of the background writes never interrupt the run: the first one is kept and rethrown by wait().
+template<class State, class TapeSymbol>
+class Checkpointer
+{
+public:
+    static constexpr bool observesSteps = false;
+
+    /// @param everySteps Steps between two checkpoints, rounded up to RunLimits::checkInterval
+    Checkpointer(std::filesystem::path path, std::size_t everySteps)
+        : m_path(std::move(path)),
+          m_everySteps(std::max<std::size_t>(everySteps, 1)) {}
+
+    ~Checkpointer()
+    {
+        if(m_pending.valid()) {
+            m_pending.wait();
+        }
+    }
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    void onStart(const TwoWayTape<TapeSymbol>&, State, std::ptrdiff_t) {}
+
+    std::optional<Verdict> onStep(const StepEvent<State, TapeSymbol>&, const TwoWayTape<TapeSymbol>&) { return std::nullopt; }
+
+    /// Called by the run loop each time it checks the limits
+    void onCheck(const Configuration<State, TapeSymbol>& configuration)
+    {
+        if(m_next == 0) {
+            m_next = configuration.steps + m_everySteps;
+        }
+
+        if(configuration.steps < m_next) {
+            return;
+        }
+
+        if(m_pending.valid()) {
+            if(m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return;
+            }
+
+            collect();
+        }
+
+        /* The previous write is over, so the snapshot is free */
+        if(!m_snapshot) {
+            m_snapshot.emplace(configuration.state, configuration.tape.blank());
+        }
+
+        m_snapshot->state = configuration.state;
+        m_snapshot->head = configuration.head;
+        m_snapshot->steps = configuration.steps;
+        m_snapshot->tape.assignContents(configuration.tape);
+
+        m_next = configuration.steps + m_everySteps;
+        m_pending = std::async(std::launch::async, [this] {
+            saveConfiguration(m_path, *m_snapshot);
+        });
+        ++m_saved;
+    }
+
+    /// Waits for the checkpoint being written, if any
+    /// @throw std::runtime_error If a checkpoint could not be written
+    void wait()
+    {
+        if(m_pending.valid()) {
+            collect();
+        }
+
+        if(m_error) {
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+        }
+    }
+
+    /// Number of checkpoints started
+    std::size_t saved() const { return m_saved; }
+
+private:
+    /// Takes the result of the finished write, keeping its error for wait()
+    void collect()
+    {
+        try {
+            m_pending.get();
+        }
+        catch(...) {
+            if(!m_error) {
+                m_error = std::current_exception();
+            }
+        }
+    }
+
+    std::filesystem::path m_path;
+    std::size_t m_everySteps;
+    std::size_t m_next = 0;
+    std::size_t m_saved = 0;
+    std::optional<Configuration<State, TapeSymbol>> m_snapshot;
+    std::future<void> m_pending;
+    std::exception_ptr m_error;
+};
+
+}
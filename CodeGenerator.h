@@ -0,0 +1,290 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <type_traits>
+#include "TuringMachine.h"
+
+namespace trmch {
+
+/// Generates C++ interpreters specialized for given machines
+///
+/// Each machine becomes a function `RunResult name(std::string_view input, const RunLimits& limits, std::string* finalTape)`
+/// with the same results as BasicTuringMachine::run. Each state is a basic block switching on the scanned symbol
+/// and jumping to the block of the next state, so a step costs no table lookup. The limits and the tape bounds are checked
+/// in chunks of steps as in the interpreter, the blocks resuming through a computed goto where the compiler supports it.
+///
+/// Typically used from a small program given to trmch_add_generated_machine() in CMake:
+///
+///     int main(int argc, char** argv) {
+///         return trmch::InterpreterGenerator("Machines").add("increment", machine).main(argc, argv);
+///     }
+class InterpreterGenerator
+{
+public:
+    /// @param name Base name of the generated files
+    /// @param namespaceName Namespace of the generated functions
+    explicit InterpreterGenerator(std::string name, std::string namespaceName = "generated")
+        : m_name(std::move(name)),
+          m_namespace(std::move(namespaceName)) {}
+
+    template<class State, class InputSymbol, class Input, class Tape>
+    InterpreterGenerator& add(const std::string& function, const TuringMachine<State, InputSymbol, char, Input, Tape>& machine)
+    {
+        const auto transitions = machine.deltaFunction();
+
+        /* Every state that can be the current one gets a block, halting states don't */
+        std::vector<State> states{machine.q0()};
+
+        for(const auto& transition : transitions) {
+            states.push_back(transition.stateFrom);
+
+            if(transition.nextStep.nextState != machine.qA() && transition.nextStep.nextState != machine.qR()) {
+                states.push_back(transition.nextStep.nextState);
+            }
+        }
+
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+
+        const auto label = [&](const State& state) {
+            return std::lower_bound(states.begin(), states.end(), state) - states.begin();
+        };
+
+        std::ostringstream out;
+
+        out << "trmch::RunResult " << function << "(std::string_view input, const trmch::RunLimits &limits, std::string *finalTape)\n"
+            << "{\n"
+            << "    using Clock = trmch::RunLimits::Clock;\n"
+            << "\n"
+            << "    trmch::TwoWayTape<char> tape(' ');\n"
+            << "    tape.assign(input.begin(), input.end());\n"
+            << "\n"
+            << "    char *cells = tape.data();\n"
+            << "    std::ptrdiff_t cell = tape.origin();\n"
+            << "    std::ptrdiff_t position = 0;\n"
+            << "    std::size_t steps = 0;\n"
+            << "    std::size_t chunkEnd = 0;\n"
+            << "    std::size_t stop = 0;\n"
+            << "    std::size_t resume = " << label(machine.q0()) << ";\n"
+            << "    trmch::Verdict verdict = trmch::Verdict::Rejected;\n"
+            << "\n"
+            << "refill:\n"
+            << "    position = cell - tape.origin();\n"
+            << "\n"
+            << "    if (steps == chunkEnd) {\n"
+            << "        if (limits.stopToken.stop_requested()) {\n"
+            << "            verdict = trmch::Verdict::Cancelled;\n"
+            << "            goto done;\n"
+            << "        }\n"
+            << "\n"
+            << "        if (steps == limits.maxSteps || (limits.deadline && Clock::now() >= *limits.deadline)) {\n"
+            << "            verdict = trmch::Verdict::OutOfFuel;\n"
+            << "            goto done;\n"
+            << "        }\n"
+            << "\n"
+            << "        chunkEnd = steps + std::min(limits.maxSteps - steps, trmch::RunLimits::checkInterval);\n"
+            << "    }\n"
+            << "\n"
+            << "    if (position < tape.first() || position >= tape.last()) {\n"
+            << "        tape.reserve(position);\n"
+            << "    }\n"
+            << "\n"
+            << "    cells = tape.data();\n"
+            << "    cell = tape.origin() + position;\n"
+            << "    stop = steps + std::min<std::size_t>(chunkEnd - steps,\n"
+            << "        static_cast<std::size_t>(std::min<std::ptrdiff_t>(cell, std::ptrdiff_t(tape.capacity()) - 1 - cell) + 1));\n"
+            << "\n"
+            << "#if TRMCH_COMPUTED_GOTO\n"
+            << "    {\n"
+            << "        static void *const blocks[] = {";
+
+        for(std::size_t i = 0; i < states.size(); ++i) {
+            out << (i ? ", " : "") << "&&state_" << i;
+        }
+
+        out << "};\n"
+            << "        goto *blocks[resume];\n"
+            << "    }\n"
+            << "#else\n"
+            << "    switch (resume) {\n";
+
+        for(std::size_t i = 0; i < states.size(); ++i) {
+            out << "        case " << i << ": goto state_" << i << ";\n";
+        }
+
+        out << "    }\n"
+            << "#endif\n";
+
+        for(std::size_t i = 0; i < states.size(); ++i) {
+            out << "\n"
+                << "state_" << i << ": /* " << states[i] << " */\n"
+                << "    if (steps == stop) {\n"
+                << "        resume = " << i << ";\n"
+                << "        goto refill;\n"
+                << "    }\n"
+                << "\n"
+                << "    ++steps;\n"
+                << "\n"
+                << "    switch (cells[cell]) {\n";
+
+            for(const auto& transition : transitions) {
+                if(transition.stateFrom != states[i]) {
+                    continue;
+                }
+
+                const auto& next = transition.nextStep;
+
+                out << "        case " << literal(transition.symbolOriginal) << ":\n";
+
+                if(next.writeSymbol != transition.symbolOriginal) {
+                    out << "            cells[cell] = " << literal(next.writeSymbol) << ";\n";
+                }
+
+                out << "            " << (next.whereToMove == LEFT ? "--cell;" : "++cell;") << "\n";
+
+                if(next.nextState == machine.qA()) {
+                    out << "            verdict = trmch::Verdict::Accepted;\n"
+                        << "            goto done;\n";
+                }
+                else if(next.nextState == machine.qR()) {
+                    out << "            verdict = trmch::Verdict::Rejected;\n"
+                        << "            goto done;\n";
+                }
+                else {
+                    out << "            goto state_" << label(next.nextState) << ";\n";
+                }
+            }
+
+            /* No transition: the default step moves right and rejects */
+            out << "        default:\n"
+                << "            ++cell;\n"
+                << "            verdict = trmch::Verdict::Rejected;\n"
+                << "            goto done;\n"
+                << "    }\n";
+        }
+
+        out << "\n"
+            << "done:\n"
+            << "    if (finalTape) {\n"
+            << "        *finalTape = tape.contents<std::string>();\n"
+            << "    }\n"
+            << "\n"
+            << "    return {verdict, steps, cell - tape.origin()};\n"
+            << "}\n";
+
+        m_functions.push_back({function, out.str()});
+        return *this;
+    }
+
+    void writeHeader(std::ostream& out) const
+    {
+        out << "// Generated by trmch::InterpreterGenerator, do not edit\n"
+            << "#pragma once\n"
+            << "\n"
+            << "#include <string>\n"
+            << "#include <string_view>\n"
+            << "#include \"RunLimits.h\"\n"
+            << "\n"
+            << "namespace " << m_namespace << " {\n"
+            << "\n";
+
+        for(const Function& function : m_functions) {
+            out << "trmch::RunResult " << function.name
+                << "(std::string_view input, const trmch::RunLimits &limits = {}, std::string *finalTape = nullptr);\n";
+        }
+
+        out << "\n"
+            << "}\n";
+    }
+
+    void writeSource(std::ostream& out) const
+    {
+        out << "// Generated by trmch::InterpreterGenerator, do not edit\n"
+            << "#include \"" << m_name << ".h\"\n"
+            << "\n"
+            << "#include <algorithm>\n"
+            << "#include \"TwoWayTape.h\"\n"
+            << "\n"
+            << "#if defined(__GNUC__) || defined(__clang__)\n"
+            << "#define TRMCH_COMPUTED_GOTO 1\n"
+            << "#else\n"
+            << "#define TRMCH_COMPUTED_GOTO 0\n"
+            << "#endif\n"
+            << "\n"
+            << "namespace " << m_namespace << " {\n";
+
+        for(const Function& function : m_functions) {
+            out << "\n" << function.source;
+        }
+
+        out << "\n"
+            << "}\n";
+    }
+
+    /// Writes <name>.h and <name>.cpp in directory
+    void write(const std::filesystem::path& directory) const
+    {
+        std::filesystem::create_directories(directory);
+
+        std::ofstream header(directory / (m_name + ".h"));
+        writeHeader(header);
+
+        std::ofstream source(directory / (m_name + ".cpp"));
+        writeSource(source);
+
+        if(!header || !source) {
+            throw std::runtime_error(StringStream() << "Cannot write the generated machine to " << directory);
+        }
+    }
+
+    /// Entry point of a generator program: writes the files in the directory given as first argument
+    int main(int argc, char** argv) const
+    {
+        if(argc != 2) {
+            std::cerr << "Usage: " << argv[0] << " <output directory>" << std::endl;
+            return 1;
+        }
+
+        try {
+            write(argv[1]);
+        }
+        catch(const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+private:
+    struct Function {
+        std::string name;
+        std::string source;
+    };
+
+    static std::string literal(char symbol)
+    {
+        if(symbol == '\'' || symbol == '\\') {
+            return StringStream() << "'\\" << symbol << "'";
+        }
+
+        if(symbol >= ' ' && symbol <= '~') {
+            return StringStream() << "'" << symbol << "'";
+        }
+
+        return StringStream() << "static_cast<char>(" << static_cast<int>(symbol) << ")";
+    }
+
+    std::string m_name;
+    std::string m_namespace;
+    std::vector<Function> m_functions;
+};
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include "TwoWayTape.h"
+
+namespace trmch {
+
+/// Everything a run needs to go on: resuming a configuration gives the same result as a run that never stopped
+template<class State, class TapeSymbol>
+struct Configuration {
+    Configuration(State state, TapeSymbol blank)
+        : state(state),
+          tape(blank) {}
+
+    State state;
+    std::ptrdiff_t head = 0;
+    std::size_t steps = 0;
+    TwoWayTape<TapeSymbol> tape;
+};
+
+}
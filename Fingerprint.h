@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+namespace trmch {
+
+/// 64-bit hash of a sequence of values, stable across runs and platforms of the same byte order
+/// Trivially copyable values are hashed by their bytes, others by std::hash.
+class Fingerprint
+{
+public:
+    template<class T>
+    Fingerprint& add(const T& value)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+
+            for(unsigned char byte : bytes) {
+                m_hash = (m_hash ^ byte) * 0x100000001B3ull;
+            }
+        } else {
+            mixIn(static_cast<std::uint64_t>(std::hash<T>()(value)));
+        }
+
+        return *this;
+    }
+
+    /// Adds every element of range, then its size so that concatenations differ
+    template<class Range>
+    Fingerprint& addRange(const Range& range)
+    {
+        std::uint64_t size = 0;
+
+        for(const auto& value : range) {
+            add(value);
+            ++size;
+        }
+
+        return add(size);
+    }
+
+    std::uint64_t value() const
+    {
+        /* splitmix64 finalizer, so that close sequences give distant hashes */
+        std::uint64_t value = m_hash;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+private:
+    void mixIn(std::uint64_t value)
+    {
+        for(int i = 0; i < 8; ++i, value >>= 8) {
+            m_hash = (m_hash ^ (value & 0xFF)) * 0x100000001B3ull;
+        }
+    }
+
+    std::uint64_t m_hash = 0xCBF29CE484222325ull;   ///< FNV-1a
+};
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <type_traits>
+#include "MappedFile.h"
+
+namespace trmch {
+
+/// Input of a run read as the head reaches it, see PagedTape
+///
+/// The head moves one cell at a time, so the input is always read in order, a page at a time: a source is a stream.
+template<class Symbol>
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+
+    /// Reads the next symbols of the input into out
+    /// @return The number of symbols read, fewer than out.size() only at the end of the input
+    virtual std::size_t read(std::span<Symbol> out) = 0;
+
+    /// The whole input if it is in memory already, such as a mapped file, to read in place; empty otherwise
+    virtual std::span<const Symbol> mapped() const { return {}; }
+};
+
+/// A file mapped in memory (see MappedFile), a byte per symbol
+/// The pages of the file are read in place: only the pages the head reaches are loaded, and only the ones it writes
+/// to are copied.
+template<class Symbol = char>
+class MappedInput : public InputSource<Symbol>
+{
+    static_assert(sizeof(Symbol) == 1 && std::is_trivially_copyable_v<Symbol>, "A mapped file holds a byte per symbol");
+
+public:
+    /// @throw std::runtime_error If the file can't be opened or mapped
+    explicit MappedInput(const std::filesystem::path& path)
+        : m_file(path) {}
+
+    std::size_t read(std::span<Symbol> out) override
+    {
+        const std::size_t count = std::min(out.size(), m_file.size() - m_position);
+        std::memcpy(out.data(), m_file.data() + m_position, count);
+        m_position += count;
+        return count;
+    }
+
+    std::span<const Symbol> mapped() const override
+    {
+        return {reinterpret_cast<const Symbol*>(m_file.data()), m_file.size()};
+    }
+
+private:
+    MappedFile m_file;
+    std::size_t m_position = 0;
+};
+
+/// Symbols read from a stream, a byte per symbol
+template<class Symbol = char>
+class StreamInput : public InputSource<Symbol>
+{
+    static_assert(sizeof(Symbol) == 1 && std::is_trivially_copyable_v<Symbol>, "A stream holds a byte per symbol");
+
+public:
+    /// @param in Read as the run goes, must outlive the run
+    explicit StreamInput(std::istream& in)
+        : m_in(in) {}
+
+    std::size_t read(std::span<Symbol> out) override
+    {
+        m_in.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size()));
+        return static_cast<std::size_t>(m_in.gcount());
+    }
+
+private:
+    std::istream& m_in;
+};
+
+/// Symbols produced by a callback, which fills a buffer like InputSource::read()
+template<class Symbol>
+class GeneratorInput : public InputSource<Symbol>
+{
+public:
+    using Generator = std::function<std::size_t(std::span<Symbol>)>;
+
+    explicit GeneratorInput(Generator generator)
+        : m_generator(std::move(generator)) {}
+
+    std::size_t read(std::span<Symbol> out) override { return m_generator(out); }
+
+private:
+    Generator m_generator;
+};
+
+}
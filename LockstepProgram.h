@@ -0,0 +1,379 @@
+#pragma once
+
+#include <bit>
+#include <span>
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include "RunLimits.h"
+#include "BasicTuringMachine.h"
+#include "PackedTape.h"
+#include "TransitionTable.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace trmch {
+
+/// A transition table compiled to run many inputs of one machine in lockstep, see TuringMachine::acceptLockstep()
+///
+/// The configurations of the runs are laid out by field rather than by run: the table row, the tape cell and the
+/// budget of each lane sit in their own arrays, and the tape of each lane is a fixed window of byte cells. A round
+/// applies one step to every lane, which with AVX2 is two gathers per 8 lanes: the cells under the heads, then
+/// their table entries. A lane whose run halts or runs out of fuel takes the next input, and a lane whose head
+/// leaves its window hands its input over to the scalar engine. Inputs longer than maxLaneInput go to the scalar
+/// engine without taking a lane, so that the window, cleared for every input, stays short.
+///
+/// The gathers are only used when compiling for AVX2 (-mavx2 or -march=native), otherwise the lanes are stepped one
+/// after another in a plain loop, which still overlaps the table lookups of independent runs.
+template<class State, class TapeSymbol>
+class LockstepProgram
+{
+public:
+    static constexpr std::size_t lanes = 16;
+
+    /// Longest input run in a lane: the window of the lanes is at most twice as long
+    static constexpr std::size_t maxLaneInput = 256;
+
+    LockstepProgram() = default;
+
+    /// @param table Transitions of the machine, with nextStep.nextState, writeSymbol and whereToMove
+    template<class NextStep>
+    LockstepProgram(const TransitionTable<State, TapeSymbol, NextStep>& table, State q0, State qA, State qR, TapeSymbol blank)
+    {
+        std::vector<TapeSymbol> symbols = table.symbols().keys();
+        table.forEach([&](std::uint32_t, TapeSymbol, const NextStep& nextStep) {
+            symbols.push_back(nextStep.writeSymbol);
+        });
+
+        m_alphabet = TapeAlphabet<TapeSymbol>(blank, std::move(symbols));
+        m_codes = static_cast<std::uint32_t>(m_alphabet.size() + 1);
+
+        /* Rows of the table states, then rows for the other states, accept, reject and the idle lanes */
+        const auto stateCount = static_cast<std::uint32_t>(table.states().size());
+        const std::uint32_t rows = stateCount + 4;
+
+        if(m_codes > 256 || std::uint64_t(rows) * m_codes >= (std::uint64_t(1) << 22)) {
+            return;
+        }
+
+        const std::uint32_t dead = stateCount * m_codes;
+        m_accept = dead + m_codes;
+        m_reject = m_accept + m_codes;
+        m_idle = m_reject + m_codes;
+
+        const auto rowOf = [&](const State& state) {
+            if(state == qA) return m_accept;
+            if(state == qR) return m_reject;
+
+            const std::uint32_t index = table.states()[state];
+            return index == CompactIndex<State>::npos ? dead : index * m_codes;
+        };
+
+        /* The first step applies the transitions of q0 even if it is qA or qR, as BasicTuringMachine does */
+        const std::uint32_t initialIndex = table.states()[q0];
+        m_initial = initialIndex == CompactIndex<State>::npos ? dead : initialIndex * m_codes;
+        m_entries.resize(rows * m_codes);
+
+        for(std::uint32_t row = 0; row < rows * m_codes; row += m_codes) {
+            for(std::uint32_t code = 0; code < m_codes; ++code) {
+                /* Missing transitions reject like BasicTuringMachine does, halted and idle lanes stay still */
+                m_entries[row + code] = row < m_accept ? entry(m_reject, code, 2) : entry(row, code, 1);
+            }
+        }
+
+        table.forEach([&](std::uint32_t state, TapeSymbol symbol, const NextStep& nextStep) {
+            m_entries[state * m_codes + m_alphabet.code(symbol)] =
+                    entry(rowOf(nextStep.nextState), m_alphabet.code(nextStep.writeSymbol), nextStep.whereToMove == LEFT ? 0 : 2);
+        });
+    }
+
+    /// Whether the table fits: at most 255 tape symbols, and fewer than 2^22 / symbols states
+    bool available() const { return !m_entries.empty(); }
+
+    /// Runs every input until the machine halts or one of the limits is reached, like BasicTuringMachine::run()
+    /// Loop detection is not supported, limits.detectLoops is ignored.
+    /// @param maxSteps Step budget of each input overriding limits.maxSteps, or empty
+    /// @param results Receives the result of each input
+    /// @param fallback Gives the result of the input at an index from another engine, for runs leaving their window
+    ///                 and inputs longer than maxLaneInput
+    template<class Input>
+    void run(std::span<const Input> inputs, const RunLimits& limits, std::span<const std::size_t> maxSteps,
+             std::span<RunResult> results, const std::function<RunResult(std::size_t)>& fallback) const
+    {
+        using Clock = RunLimits::Clock;
+
+        std::size_t longest = 0;
+
+        for(const Input& input : inputs) {
+            if(std::size(input) <= maxLaneInput) {
+                longest = std::max<std::size_t>(longest, std::size(input));
+            }
+        }
+
+        const std::size_t margin = std::max<std::size_t>(minimumMargin, longest / 2);
+        const std::size_t window = longest + 2 * margin;
+
+        Lanes state;
+        state.cells.assign(lanes * window + gatherPadding, 0);
+        state.window = static_cast<std::uint32_t>(window);
+
+        std::size_t next = 0;
+        std::size_t active = 0;
+        std::size_t rounds = 0;
+        std::size_t firstEnd = none;    ///< No lane runs out of fuel before this round
+
+        /* Starts the next input that is not over before its first step in lane, or idles the lane */
+        const auto load = [&](std::size_t lane) {
+            const std::int32_t base = static_cast<std::int32_t>(lane * window);
+
+            while(next < inputs.size()) {
+                const std::size_t i = next++;
+                const std::size_t budget = maxSteps.empty() ? limits.maxSteps : maxSteps[i];
+
+                if(budget == 0) {
+                    results[i] = {Verdict::OutOfFuel, 0, 0};
+                    continue;
+                }
+
+                if(std::size(inputs[i]) > maxLaneInput) {
+                    results[i] = fallback(i);
+                    continue;
+                }
+
+                std::uint8_t* cells = state.cells.data() + base;
+                std::memset(cells, 0, window);
+                std::size_t position = margin;
+
+                for(const auto& symbol : inputs[i]) {
+                    cells[position++] = static_cast<std::uint8_t>(m_alphabet.code(symbol));
+                }
+
+                state.row[lane] = static_cast<std::int32_t>(m_initial);
+                state.cell[lane] = base + static_cast<std::int32_t>(margin);
+                state.input[lane] = i;
+                state.start[lane] = rounds;
+                state.end[lane] = budget > std::numeric_limits<std::size_t>::max() - rounds ? std::numeric_limits<std::size_t>::max() : rounds + budget;
+                firstEnd = std::min(firstEnd, state.end[lane]);
+                ++active;
+                return;
+            }
+
+            state.row[lane] = static_cast<std::int32_t>(m_idle);
+            state.cell[lane] = base;
+            state.input[lane] = none;
+        };
+
+        const auto finish = [&](std::size_t lane, RunResult result) {
+            results[state.input[lane]] = result;
+            --active;
+            load(lane);
+        };
+
+        for(std::size_t lane = 0; lane < lanes; ++lane) {
+            load(lane);
+        }
+
+        std::size_t nextPoll = 0;
+
+        while(active != 0) {
+            if(rounds >= nextPoll) {
+                std::optional<Verdict> stopped;
+
+                if(limits.stopToken.stop_requested()) {
+                    stopped = Verdict::Cancelled;
+                } else if(limits.deadline && Clock::now() >= *limits.deadline) {
+                    stopped = Verdict::OutOfFuel;
+                }
+
+                if(stopped) {
+                    for(std::size_t lane = 0; lane < lanes; ++lane) {
+                        if(state.input[lane] != none) {
+                            results[state.input[lane]] = {*stopped, rounds - state.start[lane], headOf(state, lane, margin)};
+                        }
+                    }
+
+                    for(; next < inputs.size(); ++next) {
+                        results[next] = {*stopped, 0, 0};
+                    }
+
+                    return;
+                }
+
+                nextPoll = rounds + RunLimits::checkInterval;
+            }
+
+            /* Rounds until a lane may run out of fuel or the limits are polled again, or a lane stops earlier */
+            const std::size_t chunkEnd = std::min(nextPoll, firstEnd);
+            std::uint32_t stops;
+            rounds += advance(state, chunkEnd - rounds, stops);
+
+            for(; stops != 0; stops &= stops - 1) {
+                const auto lane = static_cast<std::size_t>(std::countr_zero(stops));
+                const auto row = static_cast<std::uint32_t>(state.row[lane]);
+
+                if(row == m_accept || row == m_reject) {
+                    finish(lane, {row == m_accept ? Verdict::Accepted : Verdict::Rejected, rounds - state.start[lane], headOf(state, lane, margin)});
+                } else {
+                    finish(lane, fallback(state.input[lane]));
+                }
+            }
+
+            /* firstEnd is only lowered as lanes are loaded: find the lanes actually out of fuel and the next bound */
+            if(rounds == firstEnd) {
+                firstEnd = none;
+
+                for(std::size_t lane = 0; lane < lanes; ++lane) {
+                    if(state.input[lane] != none && state.end[lane] == rounds) {
+                        finish(lane, {Verdict::OutOfFuel, rounds - state.start[lane], headOf(state, lane, margin)});
+                    }
+
+                    if(state.input[lane] != none) {
+                        firstEnd = std::min(firstEnd, state.end[lane]);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t minimumMargin = 64;
+    static constexpr std::size_t gatherPadding = 3;   ///< A cell is gathered as the low byte of 4 bytes, see advance()
+    static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    /// Configurations of the lanes, a field per array
+    struct Lanes {
+        alignas(32) std::array<std::int32_t, lanes> row{};     ///< Table row of the state, state index * codes
+        alignas(32) std::array<std::int32_t, lanes> cell{};    ///< Index of the cell under the head in cells
+        std::array<std::size_t, lanes> input{};                 ///< Index of the input run, none for idle lanes
+        std::array<std::size_t, lanes> start{};                 ///< Round of the first step
+        std::array<std::size_t, lanes> end{};                   ///< Round at which the budget is exhausted
+        std::vector<std::uint8_t> cells;                        ///< Window of each lane, one after another
+        std::uint32_t window = 0;
+    };
+
+    /// Next row in bits 10 to 31, code written in bits 2 to 9, then the move: 0 left, 1 stay, 2 right
+    static std::uint32_t entry(std::uint32_t row, std::uint32_t write, std::uint32_t move)
+    {
+        return row << 10 | write << 2 | move;
+    }
+
+    static std::ptrdiff_t headOf(const Lanes& state, std::size_t lane, std::size_t margin)
+    {
+        return std::ptrdiff_t(state.cell[lane]) - std::ptrdiff_t(lane * state.window + margin);
+    }
+
+    /// Applies count rounds of steps to every lane, or fewer if a lane stops earlier
+    /// The configurations stay in registers between rounds, and are only stored back to state at the end.
+    /// @param stops Receives the lanes that halted or left their window, a bit per lane
+    /// @return The rounds applied
+    std::size_t advance(Lanes& state, std::size_t count, std::uint32_t& stops) const
+    {
+        std::uint8_t* const cells = state.cells.data();
+        const std::uint32_t* const entries = m_entries.data();
+        std::size_t applied = 0;
+        stops = 0;
+
+#ifdef __AVX2__
+        const __m256i low = _mm256_set1_epi32(0xFF);
+        const __m256i moves = _mm256_set1_epi32(3);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i accept = _mm256_set1_epi32(static_cast<int>(m_accept));
+        const __m256i lastHalted = _mm256_set1_epi32(static_cast<int>(m_codes));
+        const __m256i lastOffset = _mm256_set1_epi32(static_cast<int>(state.window - 1));
+        const __m256i laneStep = _mm256_set1_epi32(static_cast<int>(state.window));
+        const __m256i bases[2] = {
+            _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), laneStep),
+            _mm256_mullo_epi32(_mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15), laneStep)
+        };
+
+        __m256i rows[2], heads[2];
+
+        for(int half = 0; half < 2; ++half) {
+            rows[half] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state.row.data() + 8 * half));
+            heads[half] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state.cell.data() + 8 * half));
+        }
+
+        while(applied != count && stops == 0) {
+            for(int half = 0; half < 2; ++half) {
+                const __m256i read = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(cells), heads[half], 1), low);
+                const __m256i step = _mm256_i32gather_epi32(reinterpret_cast<const int*>(entries), _mm256_add_epi32(rows[half], read), 4);
+
+                /* No scatter in AVX2: the written cells are stored one by one */
+                alignas(32) std::array<std::int32_t, 8> written, at;
+                _mm256_store_si256(reinterpret_cast<__m256i*>(written.data()), _mm256_srli_epi32(step, 2));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(at.data()), heads[half]);
+
+                for(std::size_t lane = 0; lane < 8; ++lane) {
+                    cells[static_cast<std::uint32_t>(at[lane])] = static_cast<std::uint8_t>(written[lane]);
+                }
+
+                heads[half] = _mm256_add_epi32(heads[half], _mm256_sub_epi32(_mm256_and_si256(step, moves), one));
+                rows[half] = _mm256_srli_epi32(step, 10);
+
+                /* Unsigned x <= limit as min(x, limit) == x */
+                const __m256i halted = _mm256_sub_epi32(rows[half], accept);
+                const __m256i isHalted = _mm256_cmpeq_epi32(_mm256_min_epu32(halted, lastHalted), halted);
+
+                const __m256i offset = _mm256_sub_epi32(heads[half], bases[half]);
+                const __m256i inside = _mm256_cmpeq_epi32(_mm256_min_epu32(offset, lastOffset), offset);
+
+                const __m256i stopped = _mm256_andnot_si256(_mm256_andnot_si256(isHalted, inside), _mm256_set1_epi32(-1));
+                stops |= static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(stopped))) << (8 * half);
+            }
+
+            ++applied;
+        }
+
+        for(int half = 0; half < 2; ++half) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(state.row.data() + 8 * half), rows[half]);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(state.cell.data() + 8 * half), heads[half]);
+        }
+#else
+        std::array<std::uint32_t, lanes> rows, heads;
+
+        for(std::size_t lane = 0; lane < lanes; ++lane) {
+            rows[lane] = static_cast<std::uint32_t>(state.row[lane]);
+            heads[lane] = static_cast<std::uint32_t>(state.cell[lane]);
+        }
+
+        while(applied != count && stops == 0) {
+            for(std::size_t lane = 0; lane < lanes; ++lane) {
+                const std::uint32_t step = entries[rows[lane] + cells[heads[lane]]];
+
+                cells[heads[lane]] = static_cast<std::uint8_t>(step >> 2);
+                heads[lane] += (step & 3) - 1;
+                rows[lane] = step >> 10;
+
+                const std::uint32_t offset = heads[lane] - static_cast<std::uint32_t>(lane * state.window);
+                stops |= std::uint32_t(rows[lane] - m_accept <= m_codes || offset >= state.window) << lane;
+            }
+
+            ++applied;
+        }
+
+        for(std::size_t lane = 0; lane < lanes; ++lane) {
+            state.row[lane] = static_cast<std::int32_t>(rows[lane]);
+            state.cell[lane] = static_cast<std::int32_t>(heads[lane]);
+        }
+#endif
+
+        return applied;
+    }
+
+    TapeAlphabet<TapeSymbol> m_alphabet;
+    std::uint32_t m_codes = 0;              ///< Symbols of the alphabet and other()
+    std::vector<std::uint32_t> m_entries;   ///< Indexed by row + code, see entry(); empty if the table doesn't fit
+    std::uint32_t m_initial = 0;
+    std::uint32_t m_accept = 0;             ///< Rows, the reject row following the accept row
+    std::uint32_t m_reject = 0;
+    std::uint32_t m_idle = 0;
+};
+
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "StepObserver.h"
+
+namespace trmch {
+
+/// Step observer proving that a run never halts
+///
+/// Two kinds of loops are recognized:
+///  - A configuration repeats: configurations are fingerprinted by a Zobrist hash of the tape updated by each write,
+///    and compared with a configuration saved at power-of-two intervals as in Brent's cycle detection.
+///    A matching fingerprint is confirmed against the saved tape, so a hash collision can't give a wrong verdict.
+///  - A translated cycle: the head reaches a new leftmost or rightmost cell in the same state as at a previous record,
+///    and the cells it visited behind the record in between are identical at both records. Everything ahead of a record
+///    is blank, so the machine will repeat the same moves shifted on the tape forever.
+template<class State, class TapeSymbol>
+class LoopDetector
+{
+public:
+    static constexpr bool observesSteps = true;
+
+    /// Number of cells kept behind each record to compare translated cycles: longer excursions are not detected
+    static constexpr std::ptrdiff_t recordWindow = 256;
+
+    /// Number of previous records searched for one in the same state
+    static constexpr std::size_t recordHistory = 64;
+
+    void onStart(const TwoWayTape<TapeSymbol> &tape, State state, std::ptrdiff_t head)
+    {
+        m_blank = tape.blank();
+        m_tapeHash = 0;
+
+        for(std::ptrdiff_t position = tape.first(); position < tape.last(); ++position) {
+            m_tapeHash ^= cellHash(position, tape[position]);
+        }
+
+        m_power = 1;
+        m_lambda = 0;
+        save(tape, state, head);
+
+        /* A resumed run may have written anywhere: only the cells past the non-blank ones are known to be blank */
+        m_leftmost = std::min<std::ptrdiff_t>(head, 0);
+        m_rightmost = std::max<std::ptrdiff_t>(head, static_cast<std::ptrdiff_t>(tape.inputSize()) - 1);
+
+        if(const auto [first, last] = nonBlank(tape); first != last) {
+            m_leftmost = std::min(m_leftmost, first);
+            m_rightmost = std::max(m_rightmost, last - 1);
+        }
+        m_segmentMin = m_segmentMax = head;
+        m_records.clear();
+        m_nextRecord = 0;
+    }
+
+    std::optional<Verdict> onStep(const StepEvent<State, TapeSymbol> &event, const TwoWayTape<TapeSymbol> &tape)
+    {
+        if(event.read != event.written) {
+            m_tapeHash ^= cellHash(event.head, event.read) ^ cellHash(event.head, event.written);
+        }
+
+        const State state = event.stateTo;
+        const std::ptrdiff_t head = event.head + event.move;
+
+        if(configurationHash(state, head) == m_saved.hash && state == m_saved.state && head == m_saved.head
+           && sameTape(tape)) {
+            return Verdict::Loops;
+        }
+
+        if(++m_lambda == m_power) {
+            save(tape, state, head);
+            m_power *= 2;
+            m_lambda = 0;
+        }
+
+        m_segmentMin = std::min(m_segmentMin, head);
+        m_segmentMax = std::max(m_segmentMax, head);
+
+        if(head > m_rightmost) {
+            m_rightmost = head;
+
+            if(record(tape, state, head, 1)) {
+                return Verdict::Loops;
+            }
+        }
+        else if(head < m_leftmost) {
+            m_leftmost = head;
+
+            if(record(tape, state, head, -1)) {
+                return Verdict::Loops;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    struct Saved {
+        std::uint64_t hash;
+        State state;
+        std::ptrdiff_t head;
+        std::ptrdiff_t first;   ///< Position of the first non-blank cell
+        std::vector<TapeSymbol> cells;
+    };
+
+    struct Record {
+        State state;
+        int direction;
+        std::ptrdiff_t head;
+        std::ptrdiff_t segmentMin;  ///< Head extent between the previous record and this one
+        std::ptrdiff_t segmentMax;
+        std::vector<TapeSymbol> window; ///< recordWindow cells ending at the head, in the order of the positions
+    };
+
+    static std::uint64_t mix(std::uint64_t value)
+    {
+        /* splitmix64 finalizer */
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    template<class T>
+    static std::uint64_t bits(const T &value)
+    {
+        std::uint64_t result = 0;
+        std::memcpy(&result, &value, std::min(sizeof(T), sizeof(result)));
+        return result;
+    }
+
+    /// Blank cells hash to 0, so growing the tape doesn't change the hash
+    std::uint64_t cellHash(std::ptrdiff_t position, TapeSymbol symbol) const
+    {
+        return symbol == m_blank ? 0 : mix(mix(static_cast<std::uint64_t>(position)) ^ bits(symbol));
+    }
+
+    std::uint64_t configurationHash(State state, std::ptrdiff_t head) const
+    {
+        return m_tapeHash ^ mix(bits(state) * 0xD6E8FEB86659FD93ull ^ static_cast<std::uint64_t>(head));
+    }
+
+    TapeSymbol at(const TwoWayTape<TapeSymbol> &tape, std::ptrdiff_t position) const
+    {
+        return position >= tape.first() && position < tape.last() ? tape[position] : m_blank;
+    }
+
+    std::pair<std::ptrdiff_t, std::ptrdiff_t> nonBlank(const TwoWayTape<TapeSymbol> &tape) const
+    {
+        std::ptrdiff_t first = tape.first();
+        std::ptrdiff_t last = tape.last();
+
+        while(first < last && tape[first] == m_blank) ++first;
+        while(last > first && tape[last - 1] == m_blank) --last;
+
+        return {first, last};
+    }
+
+    void save(const TwoWayTape<TapeSymbol> &tape, State state, std::ptrdiff_t head)
+    {
+        const auto [first, last] = nonBlank(tape);
+
+        m_saved.hash = configurationHash(state, head);
+        m_saved.state = state;
+        m_saved.head = head;
+        m_saved.first = first;
+        const TapeSymbol *cells = tape.data() + tape.origin();
+        m_saved.cells.assign(cells + first, cells + last);
+    }
+
+    bool sameTape(const TwoWayTape<TapeSymbol> &tape) const
+    {
+        const auto [first, last] = nonBlank(tape);
+
+        return first == m_saved.first
+               && static_cast<std::size_t>(last - first) == m_saved.cells.size()
+               && std::equal(m_saved.cells.begin(), m_saved.cells.end(), tape.data() + tape.origin() + first);
+    }
+
+    /// Registers a new record, after looking for a previous one in the same state forming a translated cycle with it
+    bool record(const TwoWayTape<TapeSymbol> &tape, State state, std::ptrdiff_t head, int direction)
+    {
+        bool translated = false;
+        std::ptrdiff_t min = m_segmentMin;
+        std::ptrdiff_t max = m_segmentMax;
+
+        for(std::size_t i = 0; i < m_records.size(); ++i) {
+            const Record &previous = m_records[(m_nextRecord + m_records.size() - 1 - i) % m_records.size()];
+
+            if(previous.state == state && previous.direction == direction) {
+                /* How far the head went back behind the previous record before reaching this one */
+                const std::ptrdiff_t excursion = direction > 0 ? previous.head - min : max - previous.head;
+
+                if(excursion < recordWindow) {
+                    translated = true;
+
+                    for(std::ptrdiff_t offset = 0; offset <= excursion && translated; ++offset) {
+                        const std::ptrdiff_t index = direction > 0 ? recordWindow - 1 - offset : offset;
+                        translated = previous.window[index] == at(tape, head - direction * offset);
+                    }
+                }
+
+                break;
+            }
+
+            min = std::min(min, previous.segmentMin);
+            max = std::max(max, previous.segmentMax);
+        }
+
+        Record *slot;
+
+        if(m_records.size() < recordHistory) {
+            slot = &m_records.emplace_back();
+        } else {
+            slot = &m_records[m_nextRecord];
+        }
+
+        m_nextRecord = (m_nextRecord + 1) % recordHistory;
+
+        slot->state = state;
+        slot->direction = direction;
+        slot->head = head;
+        slot->segmentMin = m_segmentMin;
+        slot->segmentMax = m_segmentMax;
+        slot->window.resize(recordWindow);
+
+        const std::ptrdiff_t windowFirst = direction > 0 ? head - (recordWindow - 1) : head;
+        for(std::ptrdiff_t i = 0; i < recordWindow; ++i) {
+            slot->window[i] = at(tape, windowFirst + i);
+        }
+
+        m_segmentMin = m_segmentMax = head;
+        return translated;
+    }
+
+    TapeSymbol m_blank{};
+    std::uint64_t m_tapeHash = 0;
+
+    Saved m_saved{};
+    std::size_t m_power = 1;
+    std::size_t m_lambda = 0;
+
+    std::ptrdiff_t m_leftmost = 0;
+    std::ptrdiff_t m_rightmost = 0;
+    std::ptrdiff_t m_segmentMin = 0;
+    std::ptrdiff_t m_segmentMax = 0;
+    std::vector<Record> m_records;
+    std::size_t m_nextRecord = 0;
+};
+
+}
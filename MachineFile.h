@@ -0,0 +1,442 @@
+#pragma once
+
+#include <map>
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+#include <ranges>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <stdexcept>
+#include <filesystem>
+#include <string_view>
+#include "TuringMachine.h"
+#include "StringStream.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+namespace trmch {
+
+/// Error in a machine description, locating the faulty line
+class MachineFormatError : public std::runtime_error
+{
+public:
+    MachineFormatError(const std::string& source, std::size_t line, const std::string& message)
+        : std::runtime_error(StringStream() << source << ":" << line << ": " << message),
+          m_source(source),
+          m_line(line) {}
+
+    const std::string& source() const { return m_source; }
+
+    /// 1-based, 0 for errors about the whole file
+    std::size_t line() const { return m_line; }
+
+private:
+    std::string m_source;
+    std::size_t m_line;
+};
+
+/// Machine descriptions for TuringMachine<State> with integral states and char symbols
+///
+/// Text form (.tm), one declaration or transition per line, # starting a comment:
+///
+///     initial 0
+///     accept 2
+///     reject -1
+///     0 'a' -> 1 'b' R
+///     1 ' ' -> 2 ' ' L
+///
+/// Symbols are quoted, with \' \\ \n \t as escapes, or a single bare character other than ' and #.
+/// Moves are L or R.
+///
+/// Binary form (.tmb), integers in the byte order of the machine that wrote it:
+///   "TRMCHTM1", u32 transition count, i64 initial, i64 accept, i64 reject,
+///   then per transition: i64 state, i64 next state, u8 read, u8 written, u8 move (0 for LEFT, 1 for RIGHT), 5 padding bytes
+/// The records are decoded straight from the mapped file into the transition table of the machine.
+namespace machine_file {
+    inline constexpr std::array<char, 8> magic{'T', 'R', 'M', 'C', 'H', 'T', 'M', '1'};
+    inline constexpr std::size_t headerSize = magic.size() + sizeof(std::uint32_t) + 3 * sizeof(std::int64_t);
+    inline constexpr std::size_t recordSize = 2 * sizeof(std::int64_t) + 8;
+
+    template<class T>
+    T read(std::span<const std::byte> bytes, std::size_t offset)
+    {
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }
+
+    template<std::integral State>
+    State toState(std::int64_t value, const std::string& source)
+    {
+        if(!std::in_range<State>(value)) {
+            throw MachineFormatError(source, 0, StringStream() << "State " << value << " out of range");
+        }
+
+        return static_cast<State>(value);
+    }
+
+    class LineParser
+    {
+    public:
+        LineParser(std::string_view line, const std::string& source, std::size_t number)
+            : m_line(line),
+              m_source(source),
+              m_number(number) {}
+
+        /// @return Whether the line has no token left, skipping blanks and comments
+        bool atEnd()
+        {
+            skipBlanks();
+            return m_position == m_line.size() || m_line[m_position] == '#';
+        }
+
+        std::string_view word()
+        {
+            if(atEnd()) {
+                fail("Unexpected end of line");
+            }
+
+            const std::size_t begin = m_position;
+
+            while(m_position < m_line.size() && !isBlank(m_line[m_position]) && m_line[m_position] != '#') {
+                ++m_position;
+            }
+
+            return m_line.substr(begin, m_position - begin);
+        }
+
+        template<std::integral State>
+        State state()
+        {
+            return state<State>(word());
+        }
+
+        template<std::integral State>
+        State state(std::string_view token)
+        {
+            State state{};
+            const auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), state);
+
+            if(error != std::errc() || end != token.data() + token.size()) {
+                fail(StringStream() << "Invalid state '" << token << "'");
+            }
+
+            return state;
+        }
+
+        char symbol()
+        {
+            if(atEnd()) {
+                fail("Expected a symbol");
+            }
+
+            if(m_line[m_position] != '\'') {
+                const std::string_view token = word();
+
+                if(token.size() != 1) {
+                    fail(StringStream() << "Invalid symbol '" << token << "', quote symbols such as ' '");
+                }
+
+                return token[0];
+            }
+
+            /* Quoted symbol */
+            ++m_position;
+            char symbol = take("Unterminated symbol");
+
+            if(symbol == '\\') {
+                switch(const char escaped = take("Unterminated symbol")) {
+                    case 'n': symbol = '\n'; break;
+                    case 't': symbol = '\t'; break;
+                    case '\\': case '\'': symbol = escaped; break;
+                    default: fail(StringStream() << "Unknown escape '\\" << escaped << "'");
+                }
+            }
+
+            if(take("Unterminated symbol") != '\'') {
+                fail("Symbols are a single character");
+            }
+
+            return symbol;
+        }
+
+        Move move()
+        {
+            const std::string_view token = word();
+
+            if(token == "L") return LEFT;
+            if(token == "R") return RIGHT;
+
+            fail(StringStream() << "Invalid move '" << token << "', expected L or R");
+        }
+
+        void expect(std::string_view expected)
+        {
+            if(word() != expected) {
+                fail(StringStream() << "Expected '" << expected << "'");
+            }
+        }
+
+        void end()
+        {
+            if(!atEnd()) {
+                fail(StringStream() << "Unexpected '" << word() << "'");
+            }
+        }
+
+        [[noreturn]] void fail(const std::string& message) const
+        {
+            throw MachineFormatError(m_source, m_number, message);
+        }
+
+    private:
+        static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        void skipBlanks()
+        {
+            while(m_position < m_line.size() && isBlank(m_line[m_position])) {
+                ++m_position;
+            }
+        }
+
+        char take(const char* error)
+        {
+            if(m_position == m_line.size()) {
+                fail(error);
+            }
+
+            return m_line[m_position++];
+        }
+
+        std::string_view m_line;
+        const std::string& m_source;
+        std::size_t m_number;
+        std::size_t m_position = 0;
+    };
+}
+
+/// Parses the text form of a machine
+/// @param source Name of the description in error messages, usually its file
+/// @throw MachineFormatError If the description is invalid, including conflicting transitions
+template<std::integral State = int>
+TuringMachine<State> parseMachine(std::string_view text, const std::string& source = "<string>")
+{
+    using Transition = typename TuringMachine<State>::Transition;
+
+    std::optional<State> initial, accept, reject;
+    std::vector<Transition> transitions;
+    std::map<std::pair<State, char>, std::size_t> lines; ///< Line of the transition for each (state, symbol)
+
+    std::size_t number = 0;
+
+    while(!text.empty()) {
+        const std::size_t newline = text.find('\n');
+        const std::string_view line = text.substr(0, newline);
+        text = newline == std::string_view::npos ? std::string_view() : text.substr(newline + 1);
+        ++number;
+
+        machine_file::LineParser parser(line, source, number);
+
+        if(parser.atEnd()) {
+            continue;
+        }
+
+        const std::string_view first = parser.word();
+
+        if(first == "initial" || first == "accept" || first == "reject") {
+            std::optional<State>& declared = first == "initial" ? initial : first == "accept" ? accept : reject;
+
+            if(declared) {
+                parser.fail(StringStream() << "Duplicate " << first << " state");
+            }
+
+            declared = parser.template state<State>();
+            parser.end();
+            continue;
+        }
+
+        Transition transition;
+        transition.stateFrom = parser.template state<State>(first);
+        transition.symbolOriginal = parser.symbol();
+        parser.expect("->");
+        transition.nextStep.nextState = parser.template state<State>();
+        transition.nextStep.writeSymbol = parser.symbol();
+        transition.nextStep.whereToMove = parser.move();
+        parser.end();
+
+        const auto [previous, inserted] = lines.emplace(std::pair(transition.stateFrom, transition.symbolOriginal), number);
+
+        if(!inserted) {
+            parser.fail(StringStream() << "Transition for state " << transition.stateFrom
+                                       << " already defined at line " << previous->second);
+        }
+
+        transitions.push_back(transition);
+    }
+
+    if(!initial || !accept || !reject) {
+        throw MachineFormatError(source, 0, StringStream() << "Missing " << (!initial ? "initial" : !accept ? "accept" : "reject") << " state");
+    }
+
+    return TuringMachine<State>(*initial, *accept, *reject, transitions);
+}
+
+/// Decodes the binary form of a machine, building the transition table directly from the records
+/// @throw MachineFormatError If the bytes are not a valid binary description
+template<std::integral State = int>
+TuringMachine<State> decodeMachine(std::span<const std::byte> bytes, const std::string& source = "<binary>")
+{
+    using Transition = typename TuringMachine<State>::Transition;
+
+    if(bytes.size() < machine_file::headerSize || std::memcmp(bytes.data(), machine_file::magic.data(), machine_file::magic.size()) != 0) {
+        throw MachineFormatError(source, 0, "Not a binary machine description");
+    }
+
+    std::size_t offset = machine_file::magic.size();
+    const auto count = machine_file::read<std::uint32_t>(bytes, offset);
+    const auto initial = machine_file::toState<State>(machine_file::read<std::int64_t>(bytes, offset + 4), source);
+    const auto accept = machine_file::toState<State>(machine_file::read<std::int64_t>(bytes, offset + 12), source);
+    const auto reject = machine_file::toState<State>(machine_file::read<std::int64_t>(bytes, offset + 20), source);
+
+    if(bytes.size() != machine_file::headerSize + std::size_t(count) * machine_file::recordSize) {
+        throw MachineFormatError(source, 0, StringStream() << "Expected " << count << " transitions");
+    }
+
+    const auto records = std::views::iota(std::size_t(0), std::size_t(count))
+                         | std::views::transform([&](std::size_t i) {
+        const std::size_t record = machine_file::headerSize + i * machine_file::recordSize;
+        const auto move = machine_file::read<std::uint8_t>(bytes, record + 18);
+
+        if(move > 1) {
+            throw MachineFormatError(source, 0, StringStream() << "Invalid move in transition " << i);
+        }
+
+        Transition transition;
+        transition.stateFrom = machine_file::toState<State>(machine_file::read<std::int64_t>(bytes, record), source);
+        transition.nextStep.nextState = machine_file::toState<State>(machine_file::read<std::int64_t>(bytes, record + 8), source);
+        transition.symbolOriginal = machine_file::read<char>(bytes, record + 16);
+        transition.nextStep.writeSymbol = machine_file::read<char>(bytes, record + 17);
+        transition.nextStep.whereToMove = move == 0 ? LEFT : RIGHT;
+        return transition;
+    });
+
+    try {
+        return TuringMachine<State>(initial, accept, reject, records);
+    }
+    catch(const std::invalid_argument& e) {
+        throw MachineFormatError(source, 0, e.what());
+    }
+}
+
+/// Loads a machine description, binary if it starts with the binary magic and text otherwise
+/// @throw std::runtime_error If the file can't be read, MachineFormatError if it is invalid
+template<std::integral State = int>
+TuringMachine<State> loadMachine(const std::filesystem::path& path)
+{
+    const MappedFile file(path);
+    const std::span<const std::byte> bytes = file.bytes();
+
+    if(bytes.size() >= machine_file::magic.size() && std::memcmp(bytes.data(), machine_file::magic.data(), machine_file::magic.size()) == 0) {
+        return decodeMachine<State>(bytes, path.string());
+    }
+
+    return parseMachine<State>(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()), path.string());
+}
+
+/// Loads every .tm and .tmb file of a directory, ordered by file name
+/// @param pool Loads the files in parallel on this pool, or on the calling thread if null
+/// @throw std::runtime_error If a file can't be read, MachineFormatError if one is invalid
+template<std::integral State = int>
+std::vector<std::pair<std::string, TuringMachine<State>>> loadMachines(const std::filesystem::path& directory, ThreadPool* pool = nullptr)
+{
+    std::vector<std::filesystem::path> paths;
+
+    for(const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if(entry.is_regular_file() && (entry.path().extension() == ".tm" || entry.path().extension() == ".tmb")) {
+            paths.push_back(entry.path());
+        }
+    }
+
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::optional<TuringMachine<State>>> machines(paths.size());
+    const auto load = [&](std::size_t i) { machines[i].emplace(loadMachine<State>(paths[i])); };
+
+    if(pool) {
+        pool->parallelFor(paths.size(), load, std::max<std::size_t>(1, paths.size() / (pool->size() * 16)));
+    } else {
+        for(std::size_t i = 0; i < paths.size(); ++i) {
+            load(i);
+        }
+    }
+
+    std::vector<std::pair<std::string, TuringMachine<State>>> loaded;
+    loaded.reserve(paths.size());
+
+    for(std::size_t i = 0; i < paths.size(); ++i) {
+        loaded.emplace_back(paths[i].stem().string(), std::move(*machines[i]));
+    }
+
+    return loaded;
+}
+
+/// Writes the text form of a machine, one transition per line ordered by state then by symbol
+template<std::integral State>
+void writeMachineText(std::ostream& out, const TuringMachine<State>& machine)
+{
+    const auto symbol = [](char c) -> std::string {
+        switch(c) {
+            case '\'': return "'\\''";
+            case '\\': return "'\\\\'";
+            case '\n': return "'\\n'";
+            case '\t': return "'\\t'";
+            default: return StringStream() << "'" << c << "'";
+        }
+    };
+
+    out << "initial " << machine.q0() << "\n"
+        << "accept " << machine.qA() << "\n"
+        << "reject " << machine.qR() << "\n"
+        << "\n";
+
+    for(const auto& transition : machine.deltaFunction()) {
+        out << transition.stateFrom << " " << symbol(transition.symbolOriginal) << " -> "
+            << transition.nextStep.nextState << " " << symbol(transition.nextStep.writeSymbol) << " "
+            << (transition.nextStep.whereToMove == LEFT ? "L" : "R") << "\n";
+    }
+}
+
+/// Writes the binary form of a machine
+template<std::integral State>
+void writeMachineBinary(std::ostream& out, const TuringMachine<State>& machine)
+{
+    const auto write = [&out](const auto& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    const auto transitions = machine.deltaFunction();
+
+    out.write(machine_file::magic.data(), machine_file::magic.size());
+    write(static_cast<std::uint32_t>(transitions.size()));
+    write(static_cast<std::int64_t>(machine.q0()));
+    write(static_cast<std::int64_t>(machine.qA()));
+    write(static_cast<std::int64_t>(machine.qR()));
+
+    for(const auto& transition : transitions) {
+        const std::array<char, 8> tail{transition.symbolOriginal, transition.nextStep.writeSymbol,
+                                       static_cast<char>(transition.nextStep.whereToMove == LEFT ? 0 : 1)};
+
+        write(static_cast<std::int64_t>(transition.stateFrom));
+        write(static_cast<std::int64_t>(transition.nextStep.nextState));
+        out.write(tail.data(), tail.size());
+    }
+}
+
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+#include <ostream>
+#include <utility>
+#include <type_traits>
+#include "TuringMachine.h"
+#include "Profiler.h"
+
+namespace trmch {
+
+struct OptimizeOptions {
+    bool removeUnreachable = true;  ///< Remove the transitions of the states never entered from the initial state
+    bool rejectDoomed = true;       ///< Send the transitions entering a state with no path to the accept state to qR
+    bool renumber = true;           ///< Renumber the states, hottest first, for integral states only
+};
+
+/// What optimize() changed in a machine
+template<class State>
+struct OptimizationReport {
+    std::vector<State> unreachableStates;   ///< Never entered from the initial state
+    std::vector<State> doomedStates;        ///< Entered from the initial state, but with no path to the accept state
+    std::size_t redirectedTransitions = 0;  ///< Transitions entering a doomed state, now entering the reject state
+    std::size_t removedTransitions = 0;     ///< Transitions of unreachable and doomed states
+    std::vector<std::pair<State, State>> renumbered;   ///< Old and new number of the states whose number changed
+
+    std::size_t statesBefore = 0;           ///< States with transitions
+    std::size_t statesAfter = 0;
+    std::size_t transitionsBefore = 0;
+    std::size_t transitionsAfter = 0;
+
+    bool changed() const { return redirectedTransitions || removedTransitions || !renumbered.empty(); }
+
+    /// One line per kind of change
+    void write(std::ostream& out) const
+    {
+        const auto list = [&](const char* title, const std::vector<State>& states) {
+            out << title << " (" << states.size() << "):";
+
+            for(const State& state : states) {
+                out << " " << state;
+            }
+
+            out << "\n";
+        };
+
+        out << "States: " << statesBefore << " -> " << statesAfter << "\n"
+            << "Transitions: " << transitionsBefore << " -> " << transitionsAfter << "\n";
+
+        list("Unreachable states", unreachableStates);
+        list("Doomed states", doomedStates);
+
+        out << "Transitions redirected to the reject state: " << redirectedTransitions << "\n"
+            << "Renumbered states (" << renumbered.size() << "):";
+
+        for(const auto& [from, to] : renumbered) {
+            out << " " << from << "->" << to;
+        }
+
+        out << "\n";
+    }
+};
+
+template<class Machine, class State>
+struct OptimizedMachine {
+    Machine machine;
+    OptimizationReport<State> report;
+};
+
+/// Builds the state graph of machine and rewrites its delta function before it is run
+///
+///  - Unreachable states: states never entered from q0 lose their transitions.
+///  - Doomed states: a state from which no path of transitions leads to qA can only reject or run forever, so the
+///    transitions entering it go to qR instead, with the same write and move. A run stops as soon as it would enter
+///    such a state: the accepted inputs are the same, but a run that looped forever in one now rejects.
+///  - Renumbering: the states are numbered from 0 in order of heat, so that the hot states are the first, adjacent
+///    rows of the transition table. Heat comes from profile (see Profiler::stateSteps()), or without profile from
+///    the breadth-first order from q0. qA and qR keep their number, and the others skip it.
+/// Chains of transitions are not merged: every step of the optimized machine is a step of the original one.
+template<class State, class InputSymbol, class TapeSymbol, class Input, class Tape>
+OptimizedMachine<TuringMachine<State, InputSymbol, TapeSymbol, Input, Tape>, State>
+optimize(const TuringMachine<State, InputSymbol, TapeSymbol, Input, Tape>& machine, const OptimizeOptions& options = {},
+         const Profiler<State, TapeSymbol>* profile = nullptr)
+{
+    using Machine = TuringMachine<State, InputSymbol, TapeSymbol, Input, Tape>;
+    using Transition = typename Machine::Transition;
+
+    const State q0 = machine.q0();
+    const State qA = machine.qA();
+    const State qR = machine.qR();
+
+    std::vector<Transition> transitions = machine.deltaFunction();
+    OptimizationReport<State> report;
+    report.transitionsBefore = transitions.size();
+
+    std::map<State, std::vector<State>> successors;
+    std::map<State, std::vector<State>> predecessors;
+    std::set<State> states;
+
+    for(const Transition& transition : transitions) {
+        successors[transition.stateFrom].push_back(transition.nextStep.nextState);
+        predecessors[transition.nextStep.nextState].push_back(transition.stateFrom);
+        states.insert(transition.stateFrom);
+    }
+
+    report.statesBefore = states.size();
+
+    /// States reached from start through edges, in breadth-first order
+    const auto search = [](const State& start, std::map<State, std::vector<State>>& edges) {
+        std::vector<State> order{start};
+        std::set<State> seen{start};
+
+        for(std::size_t i = 0; i < order.size(); ++i) {
+            for(const State& next : edges[order[i]]) {
+                if(seen.insert(next).second) {
+                    order.push_back(next);
+                }
+            }
+        }
+
+        return std::make_pair(order, seen);
+    };
+
+    const bool halted = q0 == qA || q0 == qR;
+    auto [order, reachable] = search(q0, successors);
+    const std::set<State> accepting = search(qA, predecessors).second;
+
+    if(options.rejectDoomed && !halted) {
+        for(const State& state : order) {
+            if(state != qR && !accepting.count(state)) {
+                report.doomedStates.push_back(state);
+            }
+        }
+
+        const std::set<State> doomed(report.doomedStates.begin(), report.doomedStates.end());
+
+        /* Doomed states are not entered anymore: their transitions are dead, the ones of q0 included */
+        std::erase_if(transitions, [&](const Transition& transition) {
+            if(doomed.count(transition.stateFrom)) {
+                ++report.removedTransitions;
+                return true;
+            }
+
+            return false;
+        });
+
+        std::erase_if(order, [&](const State& state) { return doomed.count(state) && state != q0; });
+
+        for(Transition& transition : transitions) {
+            if(doomed.count(transition.nextStep.nextState)) {
+                transition.nextStep.nextState = qR;
+                ++report.redirectedTransitions;
+            }
+        }
+    }
+
+    if(options.removeUnreachable) {
+        for(const State& state : states) {
+            if(!reachable.count(state)) {
+                report.unreachableStates.push_back(state);
+            }
+        }
+
+        std::erase_if(transitions, [&](const Transition& transition) {
+            if(!reachable.count(transition.stateFrom)) {
+                ++report.removedTransitions;
+                return true;
+            }
+
+            return false;
+        });
+    }
+
+    State initial = q0;
+
+    if constexpr (std::is_integral_v<State>) {
+        if(options.renumber) {
+            /* Hottest states first, then the others in breadth-first order, then the unreachable ones if kept */
+            std::vector<State> heat;
+
+            if(profile) {
+                for(const auto& stateSteps : profile->stateSteps()) {
+                    heat.push_back(stateSteps.state);
+                }
+            }
+
+            heat.insert(heat.end(), order.begin(), order.end());
+
+            for(const Transition& transition : transitions) {
+                heat.push_back(transition.stateFrom);
+                heat.push_back(transition.nextStep.nextState);
+            }
+
+            std::map<State, State> numbers;
+            State next = 0;
+
+            for(const State& state : heat) {
+                if(state == qA || state == qR || numbers.count(state)) {
+                    continue;
+                }
+
+                while(next == qA || next == qR) {
+                    ++next;
+                }
+
+                numbers[state] = next++;
+
+                if(numbers[state] != state) {
+                    report.renumbered.emplace_back(state, numbers[state]);
+                }
+            }
+
+            const auto renumber = [&](const State& state) {
+                const auto it = numbers.find(state);
+                return it == numbers.end() ? state : it->second;
+            };
+
+            for(Transition& transition : transitions) {
+                transition.stateFrom = renumber(transition.stateFrom);
+                transition.nextStep.nextState = renumber(transition.nextStep.nextState);
+            }
+
+            initial = renumber(q0);
+        }
+    }
+
+    std::set<State> statesAfter;
+
+    for(const Transition& transition : transitions) {
+        statesAfter.insert(transition.stateFrom);
+    }
+
+    report.statesAfter = statesAfter.size();
+    report.transitionsAfter = transitions.size();
+
+    return {Machine(initial, qA, qR, transitions), std::move(report)};
+}
+
+}
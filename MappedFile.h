@@ -0,0 +1,120 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include <fstream>
+#include <utility>
+#include <stdexcept>
+#include <filesystem>
+#include "StringStream.h"
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>) && __has_include(<fcntl.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define TRMCH_HAS_MMAP 1
+#else
+#include <vector>
+#define TRMCH_HAS_MMAP 0
+#endif
+
+namespace trmch {
+
+/// Read-only view of a whole file
+/// The file is memory-mapped where POSIX mmap is available, so only the pages actually read are loaded,
+/// and read into memory at once elsewhere.
+class MappedFile
+{
+public:
+    /// @throw std::runtime_error If the file can't be opened or mapped
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#if TRMCH_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+
+        if(fd < 0) {
+            throw std::runtime_error(StringStream() << "Cannot open " << path);
+        }
+
+        m_size = static_cast<std::size_t>(::lseek(fd, 0, SEEK_END));
+
+        if(m_size != 0) {
+            void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error(StringStream() << "Cannot map " << path);
+            }
+
+            m_data = static_cast<const std::byte*>(mapping);
+        }
+
+        ::close(fd);
+#else
+        std::ifstream file(path, std::ios::binary);
+
+        if(!file) {
+            throw std::runtime_error(StringStream() << "Cannot open " << path);
+        }
+
+        file.seekg(0, std::ios::end);
+        m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+#endif
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)),
+          m_size(std::exchange(other.m_size, 0))
+#if !TRMCH_HAS_MMAP
+          , m_buffer(std::move(other.m_buffer))
+#endif
+    {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if(this != &other) {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+#if !TRMCH_HAS_MMAP
+            m_buffer = std::move(other.m_buffer);
+#endif
+        }
+
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { unmap(); }
+
+    const std::byte* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+
+private:
+    void unmap()
+    {
+#if TRMCH_HAS_MMAP
+        if(m_data) {
+            ::munmap(const_cast<std::byte*>(m_data), m_size);
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+#if !TRMCH_HAS_MMAP
+    std::vector<std::byte> m_buffer;
+#endif
+};
+
+}
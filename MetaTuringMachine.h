@@ -2,6 +2,8 @@
 
 #include "TuringMachine.h"
 #include "TypeTraits.h"
+#include <array>
+#include <cstddef>
 
 namespace trmch {
 
@@ -13,6 +15,7 @@ template<char... inputs>
 struct MetaInput {
     static constexpr bool empty = (sizeof...(inputs) == 0);
     static constexpr int size = sizeof...(inputs);
+    static constexpr std::array<char, sizeof...(inputs)> chars{inputs...};
 
     template<unsigned int i>
     static constexpr char char_at = extract_nth_arg<i, inputs...>;
@@ -280,4 +283,134 @@ struct MetaTuringMachine
     static constexpr bool accept = NextStep<first_step>::result;
 };
 
-}
\ No newline at end of file
+
+
+// Private ----------------------
+
+
+/// Strategy of the constexpr engine: run the whole machine in one constant evaluation,
+/// instead of instantiating a Step type (and copies of the tape) per simulated step
+
+
+struct MetaTransitionData {
+    int stateFrom;
+    char read;
+    int stateTo;
+    char written;
+    Move move;
+};
+
+
+struct MetaRunResult {
+    bool accept;
+    std::size_t steps;
+};
+
+
+/// Same semantics as the Step strategy: the first matching transition applies, LEFT stays on the first cell,
+/// the tape is extended with blanks on the right and an empty input is a single blank
+constexpr MetaRunResult evaluateMetaTuringMachine(
+    int acceptState, int rejectState, int initialState,
+    const char* input, std::size_t inputSize,
+    const MetaTransitionData* transitions, std::size_t transitionCount)
+{
+    /* Transient constant-evaluation allocation, doubled when full */
+    std::size_t capacity = inputSize + 64;
+    char* tape = new char[capacity];
+    std::size_t size = inputSize == 0 ? 1 : inputSize;
+
+    for(std::size_t i = 0; i < size; ++i) {
+        tape[i] = i < inputSize ? input[i] : ' ';
+    }
+
+    int state = initialState;
+    std::size_t pointer = 0;
+    MetaRunResult result{false, 0};
+
+    while(true) {
+        const MetaTransitionData* transition = nullptr;
+
+        for(std::size_t i = 0; i < transitionCount && !transition; ++i) {
+            if(transitions[i].stateFrom == state && transitions[i].read == tape[pointer]) {
+                transition = &transitions[i];
+            }
+        }
+
+        if(!transition) {
+            break;
+        }
+
+        ++result.steps;
+        tape[pointer] = transition->written;
+        state = transition->stateTo;
+
+        switch(transition->move) {
+            case RIGHT:
+                if(++pointer == size) {
+                    if(size == capacity) {
+                        char* grown = new char[2 * capacity];
+
+                        for(std::size_t i = 0; i < size; ++i) {
+                            grown[i] = tape[i];
+                        }
+
+                        delete[] tape;
+                        tape = grown;
+                        capacity *= 2;
+                    }
+
+                    tape[size++] = ' ';
+                }
+                break;
+
+            case LEFT:
+                if(pointer > 0) --pointer;
+                break;
+        }
+
+        if(state == rejectState) {
+            break;
+        }
+
+        if(state == acceptState) {
+            result.accept = true;
+            break;
+        }
+    }
+
+    delete[] tape;
+    return result;
+}
+
+
+// Public -----------------------
+
+
+/// Same front end and result as MetaTuringMachine, evaluated by a single constexpr function
+/// Compilation cost grows with the number of steps only, so long runs don't hit the template depth limits
+/// (the compiler's constexpr operation limit still bounds them).
+template<
+    class Input,
+    AcceptState acceptState,
+    RejectState rejectState,
+    InitialState initialState,
+    class... Transitions>
+requires is_instance<MetaInput, Input>
+      && are_instances<MetaTransition, Transitions...>
+      && (acceptState.value != rejectState.value)
+struct ConstexprMetaTuringMachine
+{
+    static constexpr std::array<MetaTransitionData, sizeof...(Transitions)> transitions{{
+        {Transitions::stateFrom, Transitions::read, Transitions::stateTo, Transitions::written, Transitions::move}...
+    }};
+
+    static constexpr MetaRunResult result = evaluateMetaTuringMachine(
+        acceptState, rejectState, initialState,
+        Input::chars.data(), Input::chars.size(),
+        transitions.data(), transitions.size());
+
+    static constexpr bool accept = result.accept;
+    static constexpr std::size_t steps = result.steps;
+};
+
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include "BasicTuringMachine.h"
+#include "TransitionTable.h"
+
+namespace trmch {
+
+/// Tag to leave a head in place, only available for multi-tape machines
+inline constexpr struct Stay {} STAY;
+
+/// Move of one head of a multi-tape machine
+struct HeadMove {
+    constexpr HeadMove(Move move) : offset(move == LEFT ? -1 : 1) {}
+    constexpr HeadMove(Stay) : offset(0) {}
+
+    std::int8_t offset;
+};
+
+/// Machine with k tapes, each with its own head
+///
+/// A transition reads the k scanned symbols at once, writes k symbols and moves each head on its own.
+/// The input is written on the first tape, the others start blank. When no transition matches, the step counts
+/// and the machine rejects without moving.
+///
+/// Transitions are looked up with a key packing the state and the compact codes of the k symbols. While the key
+/// space is small next to the number of transitions the table is dense, otherwise it is hashed. During a run the
+/// k heads and cell pointers live together on the stack, and the tapes are only touched at the scanned cells.
+template<
+        std::size_t k,
+        class State = int,
+        class TapeSymbol = char,
+        class Input = std::string,
+        class Tape = std::string>
+class MultiTapeTuringMachine
+{
+    static_assert(k > 0, "A machine needs at least one tape");
+
+public:
+    using Symbols = std::array<TapeSymbol, k>;
+    using Moves = std::array<HeadMove, k>;
+
+    struct Transition {
+        State stateFrom;
+        Symbols read;
+        State stateTo;
+        Symbols written;
+        Moves moves;
+    };
+
+    /// @throw std::invalid_argument If two different transitions read the same symbols in the same state, or if the
+    ///                               states and the symbols read on k tapes don't fit in a 64-bit key
+    MultiTapeTuringMachine(State q0, State qA, State qR, const std::vector<Transition>& deltaFunction)
+        : m_initialState(q0),
+          m_acceptState(qA),
+          m_rejectState(qR)
+    {
+        std::vector<State> states{q0};
+        std::vector<TapeSymbol> symbols{m_blankSymbol};
+
+        for(const Transition& transition : deltaFunction) {
+            states.push_back(transition.stateFrom);
+            states.push_back(transition.stateTo);
+            symbols.insert(symbols.end(), transition.read.begin(), transition.read.end());
+        }
+
+        m_states = CompactIndex<State>(std::move(states));
+        m_symbols = CompactIndex<TapeSymbol>(std::move(symbols));
+
+        /* One more code for the symbols no transition reads */
+        while((std::size_t(1) << m_symbolBits) < m_symbols.size() + 1) {
+            ++m_symbolBits;
+        }
+
+        const std::size_t keyBits = m_symbolBits * k + bitWidth(m_states.size());
+
+        if(keyBits > 64) {
+            throw std::invalid_argument(StringStream()
+                << "The states and the symbols of " << k << " tapes need a " << keyBits << "-bit key, more than 64");
+        }
+
+        const std::size_t denseEntries = maxDenseEntriesPerTransition * deltaFunction.size() + minDenseEntries;
+        m_dense = keyBits <= maxDenseKeyBits && (std::size_t(1) << keyBits) <= denseEntries;
+
+        if(m_dense) {
+            m_table.resize(std::size_t(1) << keyBits);
+        }
+
+        for(const Transition& transition : deltaFunction) {
+            std::array<std::uint32_t, k> codes;
+
+            for(std::size_t tape = 0; tape < k; ++tape) {
+                codes[tape] = m_symbols[transition.read[tape]];
+            }
+
+            Entry entry;
+            entry.nextState = m_states[transition.stateTo];
+            entry.written = transition.written;
+            entry.defined = true;
+
+            for(std::size_t tape = 0; tape < k; ++tape) {
+                entry.moves[tape] = transition.moves[tape].offset;
+            }
+
+            Entry& slot = at(key(m_states[transition.stateFrom], codes));
+
+            if(slot.defined && (slot.nextState != entry.nextState || slot.written != entry.written || slot.moves != entry.moves)) {
+                throw std::invalid_argument(StringStream()
+                    << "Conflicting transitions for state " << transition.stateFrom);
+            }
+
+            slot = entry;
+        }
+    }
+
+    State q0() const { return m_initialState; }
+    State qA() const { return m_acceptState; }
+    State qR() const { return m_rejectState; }
+
+    /// Runs until the machine halts. Never returns if the machine loops: see run() to bound the execution.
+    [[nodiscard]] bool accept(const Input& input, std::array<Tape, k>* finalTapes = nullptr) const
+    {
+        return run(input, {}, finalTapes).accepted();
+    }
+
+    /// Runs until the machine halts or one of the limits is reached
+    /// RunResult::head is the head of the first tape. Unlike the single-tape machines, which move right when no
+    /// transition matches, a missing transition rejects with every head left in place.
+    [[nodiscard]] RunResult run(const Input& input, const RunLimits& limits, std::array<Tape, k>* finalTapes = nullptr) const
+    {
+        using Clock = RunLimits::Clock;
+
+        std::vector<TwoWayTape<TapeSymbol>> tapes(k, TwoWayTape<TapeSymbol>(m_blankSymbol));
+        tapes[0].assign(input.begin(), input.end());
+
+        for(std::size_t tape = 1; tape < k; ++tape) {
+            tapes[tape].assign(input.end(), input.end());
+        }
+
+        /* Everything a step touches besides the scanned cells and the table entry */
+        struct Heads {
+            std::array<TapeSymbol*, k> cells;
+            std::array<std::ptrdiff_t, k> positions;
+        } heads{};
+
+        const std::uint32_t acceptIndex = m_states[m_acceptState];
+        const std::uint32_t rejectIndex = m_states[m_rejectState];
+        std::uint32_t state = m_states[m_initialState];
+        std::size_t steps = 0;
+        std::optional<Verdict> ret;
+
+        while(!ret.has_value()) {
+            if(limits.stopToken.stop_requested()) {
+                ret = Verdict::Cancelled;
+                break;
+            }
+
+            if(steps == limits.maxSteps || (limits.deadline && Clock::now() >= *limits.deadline)) {
+                ret = Verdict::OutOfFuel;
+                break;
+            }
+
+            const std::size_t chunkEnd = steps + std::min(limits.maxSteps - steps, RunLimits::checkInterval);
+
+            while(steps != chunkEnd && !ret.has_value()) {
+                // Every head moves by one cell per step at most: run as many steps as the closest head to an edge allows
+                std::ptrdiff_t safeSteps = std::numeric_limits<std::ptrdiff_t>::max();
+
+                for(std::size_t tape = 0; tape < k; ++tape) {
+                    TwoWayTape<TapeSymbol>& storage = tapes[tape];
+                    const std::ptrdiff_t position = heads.positions[tape];
+
+                    if(position < storage.first() || position >= storage.last()) {
+                        storage.reserve(position);
+                    }
+
+                    const std::ptrdiff_t cell = storage.origin() + position;
+                    heads.cells[tape] = storage.data() + cell;
+                    safeSteps = std::min(safeSteps, std::min<std::ptrdiff_t>(cell, storage.capacity() - 1 - cell) + 1);
+                }
+
+                const std::size_t stop = steps + std::min(chunkEnd - steps, static_cast<std::size_t>(safeSteps));
+
+                while(steps != stop) {
+                    std::array<std::uint32_t, k> codes;
+
+                    for(std::size_t tape = 0; tape < k; ++tape) {
+                        codes[tape] = code(*heads.cells[tape]);
+                    }
+
+                    const Entry* entry = find(key(state, codes));
+                    ++steps;
+
+                    if(!entry) {
+                        ret = Verdict::Rejected;
+                        break;
+                    }
+
+                    for(std::size_t tape = 0; tape < k; ++tape) {
+                        *heads.cells[tape] = entry->written[tape];
+                        heads.cells[tape] += entry->moves[tape];
+                        heads.positions[tape] += entry->moves[tape];
+                    }
+
+                    state = entry->nextState;
+
+                    if(state == acceptIndex) {
+                        ret = Verdict::Accepted;
+                        break;
+                    } else if(state == rejectIndex) {
+                        ret = Verdict::Rejected;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if(finalTapes) {
+            for(std::size_t tape = 0; tape < k; ++tape) {
+                (*finalTapes)[tape] = tapes[tape].template contents<Tape>();
+            }
+        }
+
+        return {ret.value(), steps, heads.positions[0]};
+    }
+
+private:
+    /// Keys up to this size may index a dense table (2^20 entries), longer ones are hashed
+    static constexpr std::size_t maxDenseKeyBits = 20;
+
+    /// A dense table has at most this many entries per transition, plus minDenseEntries for the smallest machines,
+    /// so a machine with a wide key space but few transitions doesn't allocate megabytes of empty entries
+    static constexpr std::size_t maxDenseEntriesPerTransition = 16;
+    static constexpr std::size_t minDenseEntries = 4096;
+
+    struct Entry {
+        std::uint32_t nextState = 0;
+        Symbols written{};
+        std::array<std::int8_t, k> moves{};
+        bool defined = false;
+    };
+
+    static std::size_t bitWidth(std::size_t count)
+    {
+        std::size_t bits = 0;
+
+        while((std::size_t(1) << bits) < count) {
+            ++bits;
+        }
+
+        return bits;
+    }
+
+    std::uint32_t code(TapeSymbol symbol) const
+    {
+        const std::uint32_t index = m_symbols[symbol];
+        return index == CompactIndex<TapeSymbol>::npos ? static_cast<std::uint32_t>(m_symbols.size()) : index;
+    }
+
+    std::uint64_t key(std::uint32_t state, const std::array<std::uint32_t, k>& codes) const
+    {
+        std::uint64_t key = state;
+
+        for(std::size_t tape = 0; tape < k; ++tape) {
+            key = (key << m_symbolBits) | codes[tape];
+        }
+
+        return key;
+    }
+
+    Entry& at(std::uint64_t key)
+    {
+        return m_dense ? m_table[key] : m_sparse[key];
+    }
+
+    const Entry* find(std::uint64_t key) const
+    {
+        if(m_dense) {
+            const Entry& entry = m_table[key];
+            return entry.defined ? &entry : nullptr;
+        }
+
+        auto it = m_sparse.find(key);
+        return it != m_sparse.end() ? &it->second : nullptr;
+    }
+
+    State m_initialState;
+    State m_acceptState;
+    State m_rejectState;
+    TapeSymbol m_blankSymbol = ' ';
+
+    CompactIndex<State> m_states;
+    CompactIndex<TapeSymbol> m_symbols;
+    std::size_t m_symbolBits = 0;
+
+    bool m_dense = false;
+    std::vector<Entry> m_table;
+    std::unordered_map<std::uint64_t, Entry> m_sparse;
+};
+
+}
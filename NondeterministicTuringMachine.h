@@ -0,0 +1,336 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <limits>
+#include <cstdint>
+#include <optional>
+#include <unordered_set>
+#include "BasicTuringMachine.h"
+#include "TransitionTable.h"
+#include "SharedTape.h"
+
+namespace trmch {
+
+/// Bounds of a breadth-first search, see NondeterministicTuringMachine::search
+struct SearchLimits {
+    RunLimits run;              ///< maxSteps bounds the depth of the search, the deadline and stop token are polled per level
+    std::size_t maxFrontier = std::numeric_limits<std::size_t>::max(); ///< Configurations of one level
+    std::size_t maxMemory = std::numeric_limits<std::size_t>::max();   ///< Estimated bytes held by the visited configurations
+    unsigned threads = 0;       ///< Workers of the pool created for the search, 0 for one per hardware thread
+    ThreadPool* pool = nullptr; ///< Pool to reuse instead of creating one, threads is then ignored
+};
+
+struct SearchResult {
+    /// Accepted as soon as one branch accepts.
+    /// Rejected when every reachable configuration was explored without accepting, looping branches included.
+    /// OutOfFuel when the depth, the deadline, the frontier or the memory limit was reached first.
+    Verdict verdict = Verdict::Rejected;
+    std::size_t depth = 0;          ///< Steps of the accepting branch, or number of levels explored
+    std::size_t configurations = 0; ///< Distinct configurations visited
+    std::size_t peakFrontier = 0;
+    std::size_t memory = 0;         ///< Estimated bytes held by the visited configurations
+
+    bool accepted() const { return verdict == Verdict::Accepted; }
+};
+
+/// Machine whose delta function may have several transitions for the same (state, symbol)
+///
+/// The input is accepted if any sequence of choices reaches the accept state. Branches are explored breadth-first,
+/// so the first accepting branch found is a shortest one. A branch without transition halts rejecting. As with the
+/// deterministic machines, the first step applies the transitions of q0 even if it is qA or qR.
+///
+/// Configurations share their tape chunks copy-on-write with their parent (see SharedTape), and each one is
+/// only expanded once: successors go through a set sharded by hash, so the workers expanding a level in parallel
+/// rarely contend on the same lock.
+template<
+        class State = int,
+        class TapeSymbol = char,
+        class Input = std::string,
+        class Tape = std::string>
+class NondeterministicTuringMachine
+{
+public:
+    using NextStep = BasicNextStep<State, TapeSymbol>;
+
+    struct Transition {
+        State stateFrom;
+        TapeSymbol symbolOriginal;
+        NextStep nextStep;
+    };
+
+    NondeterministicTuringMachine(State q0, State qA, State qR, const std::vector<Transition>& deltaFunction)
+        : m_initialState(q0),
+          m_acceptState(qA),
+          m_rejectState(qR)
+    {
+        std::vector<State> states{q0, qA, qR};
+        std::vector<TapeSymbol> symbols;
+
+        for(const Transition& transition : deltaFunction) {
+            states.push_back(transition.stateFrom);
+            states.push_back(transition.nextStep.nextState);
+            symbols.push_back(transition.symbolOriginal);
+        }
+
+        m_states = CompactIndex<State>(std::move(states));
+        m_symbols = CompactIndex<TapeSymbol>(std::move(symbols));
+
+        /* Successors of each (state, symbol) stored contiguously, in the order of the delta function */
+        const std::size_t cells = m_states.size() * m_symbols.size();
+        m_offsets.assign(cells + 1, 0);
+
+        for(const Transition& transition : deltaFunction) {
+            ++m_offsets[indexOf(m_states[transition.stateFrom], m_symbols[transition.symbolOriginal]) + 1];
+        }
+
+        for(std::size_t i = 0; i < cells; ++i) {
+            m_offsets[i + 1] += m_offsets[i];
+        }
+
+        std::vector<std::uint32_t> next(m_offsets.begin(), m_offsets.end() - 1);
+        m_steps.resize(deltaFunction.size());
+
+        for(const Transition& transition : deltaFunction) {
+            const std::size_t cell = indexOf(m_states[transition.stateFrom], m_symbols[transition.symbolOriginal]);
+            m_steps[next[cell]++] = {m_states[transition.nextStep.nextState], transition.nextStep.writeSymbol,
+                                     static_cast<std::int8_t>(transition.nextStep.whereToMove == LEFT ? -1 : 1)};
+        }
+    }
+
+    State q0() const { return m_initialState; }
+    State qA() const { return m_acceptState; }
+    State qR() const { return m_rejectState; }
+
+    /// Searches for an accepting branch without limits, which never returns if the reachable configurations are infinite
+    [[nodiscard]] bool accept(const Input& input, Tape* finalTape = nullptr) const
+    {
+        return search(input, {}, finalTape).accepted();
+    }
+
+    /// Explores the branches breadth-first until one accepts, all of them are exhausted, or a limit is reached
+    /// @param finalTape Receives the tape of the accepting branch, if any
+    [[nodiscard]] SearchResult search(const Input& input, const SearchLimits& limits, Tape* finalTape = nullptr) const
+    {
+        using Clock = RunLimits::Clock;
+
+        Configuration initial{m_states[m_initialState], 0, SharedTape<TapeSymbol>(m_blankSymbol)};
+        initial.tape.assign(input.begin(), input.end());
+
+        SearchResult result;
+        VisitedSet visited;
+        std::atomic<std::size_t> memory{0};
+
+        std::vector<const Configuration*> frontier{visited.insert(std::move(initial))};
+        memory += footprint(*frontier.front(), true);
+
+        std::optional<ThreadPool> ownPool;
+        ThreadPool* pool = limits.pool;
+
+        std::atomic<bool> accepted{false};
+        std::mutex acceptMutex;
+
+        while(true) {
+            result.peakFrontier = std::max(result.peakFrontier, frontier.size());
+            result.configurations = visited.size();
+            result.memory = memory;
+
+            if(frontier.empty()) {
+                result.verdict = Verdict::Rejected;
+                return result;
+            }
+
+            if(limits.run.stopToken.stop_requested()) {
+                result.verdict = Verdict::Cancelled;
+                return result;
+            }
+
+            if(result.depth == limits.run.maxSteps || frontier.size() > limits.maxFrontier || result.memory > limits.maxMemory
+               || (limits.run.deadline && Clock::now() >= *limits.run.deadline)) {
+                result.verdict = Verdict::OutOfFuel;
+                return result;
+            }
+
+            const auto expand = [&](const Configuration& configuration, std::vector<const Configuration*>& next) {
+                const TapeSymbol symbol = configuration.tape[configuration.head];
+                const std::uint32_t symbolIndex = m_symbols[symbol];
+
+                if(symbolIndex == CompactIndex<TapeSymbol>::npos) {
+                    return;
+                }
+
+                const std::size_t cell = indexOf(configuration.state, symbolIndex);
+
+                for(std::uint32_t i = m_offsets[cell]; i < m_offsets[cell + 1] && !accepted.load(std::memory_order_relaxed); ++i) {
+                    const Step& step = m_steps[i];
+
+                    if(step.nextState == m_states[m_rejectState]) {
+                        continue;
+                    }
+
+                    Configuration successor = configuration;
+                    const bool allocated = successor.tape.write(successor.head, step.writeSymbol);
+                    successor.head += step.move;
+                    successor.state = step.nextState;
+
+                    if(step.nextState == m_states[m_acceptState]) {
+                        std::lock_guard lock(acceptMutex);
+
+                        if(!accepted.exchange(true) && finalTape) {
+                            *finalTape = successor.tape.template contents<Tape>();
+                        }
+
+                        return;
+                    }
+
+                    if(const Configuration* inserted = visited.insert(std::move(successor))) {
+                        memory.fetch_add(footprint(*inserted, allocated), std::memory_order_relaxed);
+                        next.push_back(inserted);
+                    }
+                }
+            };
+
+            std::vector<const Configuration*> next;
+
+            if(frontier.size() < parallelThreshold) {
+                for(const Configuration* configuration : frontier) {
+                    expand(*configuration, next);
+                }
+            }
+            else {
+                if(!pool) {
+                    pool = &ownPool.emplace(limits.threads);
+                }
+
+                /* Blocks of the frontier are expanded in parallel, each into its own list, then concatenated in order */
+                const std::size_t blocks = std::min<std::size_t>(frontier.size(), std::size_t(pool->size()) * 8);
+                std::vector<std::vector<const Configuration*>> parts(blocks);
+
+                pool->parallelFor(blocks, [&](std::size_t block) {
+                    const std::size_t begin = frontier.size() * block / blocks;
+                    const std::size_t end = frontier.size() * (block + 1) / blocks;
+
+                    for(std::size_t i = begin; i < end; ++i) {
+                        expand(*frontier[i], parts[block]);
+                    }
+                });
+
+                for(const auto& part : parts) {
+                    next.insert(next.end(), part.begin(), part.end());
+                }
+            }
+
+            ++result.depth;
+
+            if(accepted) {
+                result.verdict = Verdict::Accepted;
+                result.configurations = visited.size();
+                result.memory = memory;
+                return result;
+            }
+
+            frontier = std::move(next);
+        }
+    }
+
+private:
+    /// Levels smaller than this are expanded on the calling thread
+    static constexpr std::size_t parallelThreshold = 256;
+
+    struct Step {
+        std::uint32_t nextState;
+        TapeSymbol writeSymbol;
+        std::int8_t move;
+    };
+
+    struct Configuration {
+        std::uint32_t state;
+        std::ptrdiff_t head;
+        SharedTape<TapeSymbol> tape;
+
+        std::uint64_t hash() const
+        {
+            return tape.hash() ^ ((std::uint64_t(state) << 40) + static_cast<std::uint64_t>(head)) * 0x9E3779B97F4A7C15ull;
+        }
+
+        bool operator==(const Configuration& other) const
+        {
+            return state == other.state && head == other.head && tape == other.tape;
+        }
+    };
+
+    /// Set of configurations sharded by hash, each shard behind its own lock
+    /// Configurations never move once inserted, so the frontier refers to them by pointer.
+    class VisitedSet
+    {
+    public:
+        /// @return The stored configuration, or nullptr if an equal one was already visited
+        const Configuration* insert(Configuration&& configuration)
+        {
+            const std::uint64_t hash = configuration.hash();
+            Shard& shard = m_shards[(hash >> 32) % shardCount];
+
+            std::lock_guard lock(shard.mutex);
+            auto [it, inserted] = shard.configurations.insert(std::move(configuration));
+            return inserted ? &*it : nullptr;
+        }
+
+        std::size_t size()
+        {
+            std::size_t size = 0;
+
+            for(Shard& shard : m_shards) {
+                std::lock_guard lock(shard.mutex);
+                size += shard.configurations.size();
+            }
+
+            return size;
+        }
+
+    private:
+        static constexpr std::size_t shardCount = 64;
+
+        struct Hash {
+            std::size_t operator()(const Configuration& configuration) const
+            {
+                return static_cast<std::size_t>(configuration.hash());
+            }
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_set<Configuration, Hash> configurations;
+        };
+
+        std::array<Shard, shardCount> m_shards;
+    };
+
+    /// Estimated bytes held by a visited configuration: the set node, its chunk list and the chunk it wrote
+    static std::size_t footprint(const Configuration& configuration, bool allocatedChunk)
+    {
+        return sizeof(Configuration) + 2 * sizeof(void*)
+               + configuration.tape.chunkCount() * sizeof(std::shared_ptr<const typename SharedTape<TapeSymbol>::Chunk>)
+               + (allocatedChunk ? sizeof(typename SharedTape<TapeSymbol>::Chunk) : 0);
+    }
+
+    std::size_t indexOf(std::uint32_t stateIndex, std::uint32_t symbolIndex) const
+    {
+        return std::size_t(stateIndex) * m_symbols.size() + symbolIndex;
+    }
+
+    State m_initialState;
+    State m_acceptState;
+    State m_rejectState;
+    TapeSymbol m_blankSymbol = ' ';
+
+    CompactIndex<State> m_states;
+    CompactIndex<TapeSymbol> m_symbols;
+    std::vector<std::uint32_t> m_offsets;   ///< Successors of (state, symbol) are m_steps[m_offsets[i]] to m_steps[m_offsets[i + 1]]
+    std::vector<Step> m_steps;
+};
+
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include "RunLimits.h"
+#include "BasicTuringMachine.h"
+#include "PackedTape.h"
+#include "TransitionTable.h"
+
+namespace trmch {
+
+/// A transition table compiled for runs on a PackedTape
+///
+/// States are renumbered densely with the halting states last, symbols are replaced by their TapeAlphabet code,
+/// and every (state, code) pair has a step, missing transitions included: they reject like BasicTuringMachine does.
+/// A step is then a single table access, and sweeps over one symbol are crossed by scanning whole tape words.
+template<class State, class TapeSymbol>
+class PackedProgram
+{
+public:
+    PackedProgram() = default;
+
+    /// @param table Transitions of the machine, with nextStep.nextState, writeSymbol and whereToMove
+    template<class NextStep>
+    PackedProgram(const TransitionTable<State, TapeSymbol, NextStep>& table, State q0, State qA, State qR, TapeSymbol blank)
+    {
+        std::vector<TapeSymbol> symbols = table.symbols().keys();
+        table.forEach([&](std::uint32_t, TapeSymbol, const NextStep& nextStep) {
+            symbols.push_back(nextStep.writeSymbol);
+        });
+
+        m_alphabet = TapeAlphabet<TapeSymbol>(blank, std::move(symbols));
+        m_codes = m_alphabet.size() + 1;
+
+        if(!TapeAlphabet<TapeSymbol>::bitsPerCell(m_codes)) {
+            return;
+        }
+
+        /* Rows of the table states, then a row rejecting everything for the other states, then accept and reject */
+        const auto stateCount = static_cast<std::uint32_t>(table.states().size());
+        const std::uint32_t dead = stateCount;
+        m_accept = stateCount + 1;
+        m_reject = stateCount + 2;
+
+        const auto indexOf = [&](const State& state) {
+            if(state == qA) return m_accept;
+            if(state == qR) return m_reject;
+
+            const std::uint32_t index = table.states()[state];
+            return index == CompactIndex<State>::npos ? dead : index;
+        };
+
+        const std::uint32_t initial = table.states()[q0];
+        m_initial = initial == CompactIndex<State>::npos ? dead : initial;
+
+        m_steps.resize((stateCount + 1) * m_codes);
+        m_sweeps.assign(2 * (stateCount + 1), 0);
+
+        for(std::uint32_t state = 0; state <= stateCount; ++state) {
+            for(unsigned code = 0; code < m_codes; ++code) {
+                m_steps[state * m_codes + code] = {m_reject, static_cast<std::uint8_t>(code), 1, false};
+            }
+        }
+
+        table.forEach([&](std::uint32_t state, TapeSymbol symbol, const NextStep& nextStep) {
+            const unsigned code = m_alphabet.code(symbol);
+            Step& step = m_steps[state * m_codes + code];
+
+            step.next = indexOf(nextStep.nextState);
+            step.write = static_cast<std::uint8_t>(m_alphabet.code(nextStep.writeSymbol));
+            step.move = nextStep.whereToMove == LEFT ? -1 : 1;
+            step.sweeps = step.next == state && step.write == code;
+
+            if(step.sweeps) {
+                m_sweeps[2 * state + (step.move > 0)] |= std::uint16_t(1) << code;
+            }
+        });
+    }
+
+    const TapeAlphabet<TapeSymbol>& alphabet() const { return m_alphabet; }
+
+    /// Runs input until the machine halts or one of the limits is reached, like BasicTuringMachine::run()
+    /// Loop detection is not supported, limits.detectLoops is ignored.
+    /// @param tapeBytes Receives the bytes allocated for the tape
+    /// @return nullopt if the alphabet, with the symbols of input outside of it, doesn't fit in 4 bits per cell
+    template<class Input, class Tape>
+    std::optional<RunResult> run(const Input& input, const RunLimits& limits, Tape* finalTape = nullptr,
+                                 std::size_t* tapeBytes = nullptr) const
+    {
+        if(m_steps.empty()) {
+            return std::nullopt;
+        }
+
+        bool hasOther = false;
+
+        for(const auto& symbol : input) {
+            hasOther = hasOther || m_alphabet.code(symbol) == m_alphabet.other();
+        }
+
+        switch(TapeAlphabet<TapeSymbol>::bitsPerCell(m_alphabet.size() + hasOther)) {
+            case 1: return runPacked<1>(input, limits, finalTape, tapeBytes);
+            case 2: return runPacked<2>(input, limits, finalTape, tapeBytes);
+            case 4: return runPacked<4>(input, limits, finalTape, tapeBytes);
+            default: return std::nullopt;
+        }
+    }
+
+private:
+    struct Step {
+        std::uint32_t next;     ///< Dense state index
+        std::uint8_t write;     ///< Code
+        std::int8_t move;       ///< -1 or 1
+        bool sweeps;            ///< Whether the step writes back what it reads and keeps its state
+    };
+
+    template<unsigned Bits, class Input, class Tape>
+    RunResult runPacked(const Input& input, const RunLimits& limits, Tape* finalTape, std::size_t* tapeBytes) const
+    {
+        using Clock = RunLimits::Clock;
+
+        PackedTape<Bits> tape;
+        tape.assign(input.begin(), input.end(), [this](const auto& symbol) { return m_alphabet.code(symbol); });
+
+        std::optional<Verdict> ret;
+        std::uint32_t state = m_initial;
+        std::ptrdiff_t head = 0;
+        std::size_t steps = 0;
+
+        while(!ret.has_value()) {
+            if(limits.stopToken.stop_requested()) {
+                ret = Verdict::Cancelled;
+                break;
+            }
+
+            if(steps == limits.maxSteps || (limits.deadline && Clock::now() >= *limits.deadline)) {
+                ret = Verdict::OutOfFuel;
+                break;
+            }
+
+            const std::size_t chunkEnd = steps + std::min(limits.maxSteps - steps, RunLimits::checkInterval);
+
+            while(steps != chunkEnd && !ret.has_value()) {
+                if(head < tape.first() || head >= tape.last()) {
+                    tape.reserve(head);
+                }
+
+                /* Same safe window as BasicTuringMachine::resumeObserved() */
+                std::ptrdiff_t cell = tape.origin() + head;
+                const auto safeSteps = static_cast<std::size_t>(std::min<std::ptrdiff_t>(cell, std::ptrdiff_t(tape.capacity()) - 1 - cell) + 1);
+                const std::size_t stop = steps + std::min(chunkEnd - steps, safeSteps);
+
+                while(steps != stop) {
+                    const unsigned read = tape.get(static_cast<std::size_t>(cell));
+                    const Step& step = m_steps[state * m_codes + read];
+
+                    tape.set(static_cast<std::size_t>(cell), step.write);
+                    cell += step.move;
+                    state = step.next;
+                    ++steps;
+
+                    if(state >= m_accept) {
+                        ret = state == m_accept ? Verdict::Accepted : Verdict::Rejected;
+                        break;
+                    }
+
+                    if(step.sweeps) {
+                        const std::uint16_t swept = m_sweeps[2 * state + (step.move > 0)];
+                        const std::ptrdiff_t allocated = step.move > 0 ? std::ptrdiff_t(tape.capacity()) - cell : cell + 1;
+                        const std::size_t limit = std::min(chunkEnd - steps, static_cast<std::size_t>(std::max<std::ptrdiff_t>(allocated, 0)));
+                        std::size_t count = 0;
+
+                        if(std::has_single_bit(swept)) {
+                            count = tape.scan(static_cast<std::size_t>(cell), step.move, read, limit);
+                        } else {
+                            while(count != limit && (swept >> tape.get(static_cast<std::size_t>(cell + step.move * std::ptrdiff_t(count))) & 1)) {
+                                ++count;
+                            }
+                        }
+
+                        if(count != 0) {
+                            cell += step.move * static_cast<std::ptrdiff_t>(count);
+                            steps += count;
+                            break; /* The head may now be anywhere: recompute how far it can go safely */
+                        }
+                    }
+                }
+
+                head = cell - tape.origin();
+            }
+        }
+
+        if(finalTape) {
+            const auto [first, last] = tape.contentBounds();
+            finalTape->clear();
+
+            for(std::ptrdiff_t position = first; position < last; ++position) {
+                const unsigned code = tape[position];
+
+                /* A cell of another symbol was never written: reading it rejects without writing */
+                finalTape->push_back(code == m_alphabet.other() ? input[static_cast<std::size_t>(position)] : m_alphabet.symbol(code));
+            }
+        }
+
+        if(tapeBytes) {
+            *tapeBytes = tape.bytes();
+        }
+
+        return {ret.value(), steps, head};
+    }
+
+    TapeAlphabet<TapeSymbol> m_alphabet;
+    std::size_t m_codes = 0;                ///< Symbols of the alphabet and other()
+    std::vector<Step> m_steps;              ///< Indexed by state index * m_codes + code, empty if codes don't fit in 4 bits
+    std::vector<std::uint16_t> m_sweeps;    ///< Codes swept by each state, indexed by 2 * state index + (move is right)
+    std::uint32_t m_initial = 0;
+    std::uint32_t m_accept = 0;
+    std::uint32_t m_reject = 0;
+};
+
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include "TransitionTable.h"
+
+namespace trmch {
+
+/// Dense codes of the symbols a machine can find on its tape: the blank symbol is code 0, then the symbols its
+/// transitions read or write, in order. Input symbols outside of the alphabet share one more code, other().
+template<class TapeSymbol>
+class TapeAlphabet
+{
+public:
+    TapeAlphabet() = default;
+
+    TapeAlphabet(TapeSymbol blank, std::vector<TapeSymbol> symbols)
+    {
+        symbols.push_back(blank);
+        m_index = CompactIndex<TapeSymbol>(std::move(symbols));
+
+        /* Sorted order, except that blank is swapped to the front so that a zero-filled tape is blank */
+        m_codes.resize(m_index.size());
+        m_symbols = m_index.keys();
+
+        const std::uint32_t blankIndex = m_index[blank];
+        std::swap(m_symbols[0], m_symbols[blankIndex]);
+
+        for(std::uint32_t i = 0; i < m_codes.size(); ++i) {
+            m_codes[i] = static_cast<std::uint8_t>(i == 0 ? blankIndex : i == blankIndex ? 0 : i);
+        }
+
+        if constexpr (isByte) {
+            m_byteCodes.fill(static_cast<std::uint8_t>(other()));
+
+            for(unsigned code = 0; code < m_symbols.size(); ++code) {
+                m_byteCodes[toByte(m_symbols[code])] = static_cast<std::uint8_t>(code);
+            }
+        }
+    }
+
+    /// Number of symbols, other() excluded
+    std::size_t size() const { return m_symbols.size(); }
+
+    unsigned other() const { return static_cast<unsigned>(m_symbols.size()); }
+
+    /// @return The code of symbol, or other() if it is not in the alphabet
+    unsigned code(const TapeSymbol& symbol) const
+    {
+        if constexpr (isByte) {
+            return m_byteCodes[toByte(symbol)];
+        }
+
+        const std::uint32_t index = m_index[symbol];
+        return index == CompactIndex<TapeSymbol>::npos ? other() : m_codes[index];
+    }
+
+    /// @param code In [0, size())
+    const TapeSymbol& symbol(unsigned code) const { return m_symbols[code]; }
+
+    /// Smallest cell width among 1, 2 and 4 bits holding codes [0, codes), or 0 if more than 4 bits are needed
+    static unsigned bitsPerCell(std::size_t codes)
+    {
+        return codes <= 2 ? 1 : codes <= 4 ? 2 : codes <= 16 ? 4 : 0;
+    }
+
+private:
+    static constexpr bool isByte = sizeof(TapeSymbol) == 1 && std::is_trivially_copyable_v<TapeSymbol>;
+
+    static unsigned char toByte(TapeSymbol symbol)
+    {
+        unsigned char byte;
+        std::memcpy(&byte, &symbol, 1);
+        return byte;
+    }
+
+    CompactIndex<TapeSymbol> m_index;
+    std::vector<std::uint8_t> m_codes;      ///< Code of each compact index
+    std::vector<TapeSymbol> m_symbols;      ///< Symbol of each code
+    std::array<std::uint8_t, 256> m_byteCodes{};  ///< Code of each byte, for single-byte symbols
+};
+
+/// Tape of symbol codes packed at Bits bits per cell in 64-bit words, infinite in both directions like TwoWayTape
+///
+/// Code 0 is the blank symbol, so blank storage is zero-filled and the tape grows by whole words. Reading or writing
+/// a cell is a shift and a mask of its word, and scan() compares a whole word of cells against a symbol at once.
+template<unsigned Bits>
+class PackedTape
+{
+    static_assert(Bits == 1 || Bits == 2 || Bits == 4, "Cells are 1, 2 or 4 bits wide");
+
+public:
+    using Word = std::uint64_t;
+
+    static constexpr std::size_t cellsPerWord = 64 / Bits;
+    static constexpr Word cellMask = (Word(1) << Bits) - 1;
+
+    /// Resets the tape to the input, encoded by code(symbol), with some blank margin on both sides
+    template<class InputIt, class Encode>
+    void assign(InputIt first, InputIt last, Encode code)
+    {
+        const std::size_t inputSize = static_cast<std::size_t>(std::distance(first, last));
+        const std::size_t marginWords = (std::max<std::size_t>(inputSize / 2, minimumMargin) + cellsPerWord - 1) / cellsPerWord;
+        const std::size_t inputWords = (inputSize + cellsPerWord - 1) / cellsPerWord;
+
+        m_words.assign(marginWords + inputWords + marginWords, 0);
+        m_origin = static_cast<std::ptrdiff_t>(marginWords * cellsPerWord);
+        m_inputSize = inputSize;
+
+        /* A word of cells at a time, the input starting on a word boundary */
+        for(auto word = m_words.begin() + static_cast<std::ptrdiff_t>(marginWords); first != last; ++word) {
+            Word cells = 0;
+
+            for(unsigned shift = 0; shift != 64 && first != last; shift += Bits, ++first) {
+                cells |= Word(code(*first)) << shift;
+            }
+
+            *word = cells;
+        }
+    }
+
+    /// Grows the storage so that position is allocated
+    void reserve(std::ptrdiff_t position)
+    {
+        if(position < first()) {
+            const std::size_t missing = (static_cast<std::size_t>(first() - position) + cellsPerWord - 1) / cellsPerWord;
+            grow(std::max(missing, m_words.size()), 0);
+        }
+        else if(position >= last()) {
+            const std::size_t missing = (static_cast<std::size_t>(position - last()) + cellsPerWord) / cellsPerWord;
+            grow(0, std::max(missing, m_words.size()));
+        }
+    }
+
+    /// First allocated position, may be negative
+    std::ptrdiff_t first() const { return -m_origin; }
+
+    /// One past the last allocated position
+    std::ptrdiff_t last() const { return static_cast<std::ptrdiff_t>(capacity()) - m_origin; }
+
+    /// Cell index of position 0
+    std::ptrdiff_t origin() const { return m_origin; }
+
+    /// Allocated cells
+    std::size_t capacity() const { return m_words.size() * cellsPerWord; }
+
+    /// Allocated bytes
+    std::size_t bytes() const { return m_words.size() * sizeof(Word); }
+
+    std::size_t inputSize() const { return m_inputSize; }
+
+    /// Code of the cell at index cell, position cell - origin()
+    unsigned get(std::size_t cell) const
+    {
+        return static_cast<unsigned>((m_words[cell / cellsPerWord] >> shiftOf(cell)) & cellMask);
+    }
+
+    void set(std::size_t cell, unsigned code)
+    {
+        Word& word = m_words[cell / cellsPerWord];
+        const unsigned shift = shiftOf(cell);
+        word ^= (((word >> shift) ^ code) & cellMask) << shift;
+    }
+
+    unsigned operator[](std::ptrdiff_t position) const { return get(static_cast<std::size_t>(m_origin + position)); }
+
+    /// @param direction 1 to scan toward the right, -1 toward the left
+    /// @param limit Maximum number of cells to scan, all of them must be allocated
+    /// @return Number of consecutive cells holding code from index cell in that direction
+    std::size_t scan(std::size_t cell, std::ptrdiff_t direction, unsigned code, std::size_t limit) const
+    {
+        const Word pattern = code * (~Word(0) / cellMask);
+        std::size_t count = 0;
+
+        while(count != limit) {
+            /* Cells of this word from cell in scanning order, shifted to the low (right) or high (left) end */
+            const unsigned offset = static_cast<unsigned>(cell % cellsPerWord);
+            const Word differences = m_words[cell / cellsPerWord] ^ pattern;
+            std::size_t available;
+            int sameBits;
+
+            if(direction > 0) {
+                available = cellsPerWord - offset;
+                sameBits = std::countr_zero(differences >> (offset * Bits));
+            } else {
+                available = offset + 1;
+                sameBits = std::countl_zero(differences << ((cellsPerWord - 1 - offset) * Bits));
+            }
+
+            const std::size_t same = static_cast<std::size_t>(sameBits) / Bits;
+            available = std::min(available, limit - count);
+
+            if(same < available) {
+                return count + same;
+            }
+
+            count += available;
+            cell += direction > 0 ? available : -available;
+        }
+
+        return count;
+    }
+
+    /// Positions from the first to the last non-blank cell, always including the cells of the input
+    std::pair<std::ptrdiff_t, std::ptrdiff_t> contentBounds() const
+    {
+        const auto isUsed = [](Word word) { return word != 0; };
+        const auto firstWord = std::find_if(m_words.begin(), m_words.end(), isUsed);
+
+        std::ptrdiff_t begin = m_origin;
+        std::ptrdiff_t end = m_origin + static_cast<std::ptrdiff_t>(m_inputSize);
+
+        if(firstWord != m_words.end()) {
+            const auto lastWord = std::find_if(m_words.rbegin(), m_words.rend(), isUsed).base() - 1;
+            const auto firstIndex = static_cast<std::ptrdiff_t>(firstWord - m_words.begin());
+            const auto lastIndex = static_cast<std::ptrdiff_t>(lastWord - m_words.begin());
+
+            const std::ptrdiff_t used = firstIndex * std::ptrdiff_t(cellsPerWord) + std::countr_zero(*firstWord) / int(Bits);
+            const std::ptrdiff_t usedEnd = lastIndex * std::ptrdiff_t(cellsPerWord) + (63 - std::countl_zero(*lastWord)) / int(Bits) + 1;
+
+            begin = std::min(begin, used);
+            end = std::max(end, usedEnd);
+        }
+
+        return {begin - m_origin, end - m_origin};
+    }
+
+private:
+    static constexpr std::size_t minimumMargin = 64;
+
+    static unsigned shiftOf(std::size_t cell)
+    {
+        return static_cast<unsigned>(cell % cellsPerWord) * Bits;
+    }
+
+    void grow(std::size_t left, std::size_t right)
+    {
+        std::vector<Word> words(left + m_words.size() + right, 0);
+        std::copy(m_words.begin(), m_words.end(), words.begin() + static_cast<std::ptrdiff_t>(left));
+
+        m_words = std::move(words);
+        m_origin += static_cast<std::ptrdiff_t>(left * cellsPerWord);
+    }
+
+    std::vector<Word> m_words;
+    std::ptrdiff_t m_origin = 0;
+    std::size_t m_inputSize = 0;
+};
+
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include "RunLimits.h"
+#include "InputSource.h"
+#include "BasicTuringMachine.h"
+
+namespace trmch {
+
+/// Tape infinite in both directions, filled from an InputSource as the head reaches it, see runPaged()
+///
+/// Cells are split into pages of pageSize cells, made when the head first reaches them. Until a page is written to,
+/// it is read in place: from the mapping of a mapped input, or from a single blank page outside of the input. A write
+/// copies the page first, so the memory of the tape only covers the pages read from a stream and the pages written.
+/// Starting a run doesn't read anything, whatever the size of the input.
+template<class TapeSymbol>
+class PagedTape
+{
+public:
+    static constexpr std::size_t defaultPageSize = 4096;
+
+    /// @param input Read as the head reaches it, must outlive the tape
+    PagedTape(InputSource<TapeSymbol>& input, TapeSymbol blank, std::size_t pageSize = defaultPageSize)
+        : m_input(input),
+          m_mapped(input.mapped()),
+          m_blank(blank),
+          m_pageSize(std::max<std::size_t>(pageSize, 1)),
+          m_blankPage(m_pageSize, blank) {}
+
+    PagedTape(const PagedTape&) = delete;
+    PagedTape& operator=(const PagedTape&) = delete;
+
+    std::size_t pageSize() const { return m_pageSize; }
+    TapeSymbol blank() const { return m_blank; }
+
+    /// Index of the page holding position
+    std::int64_t pageOf(std::int64_t position) const
+    {
+        const auto size = static_cast<std::int64_t>(m_pageSize);
+        return position >= 0 ? position / size : -((-position - 1) / size) - 1;
+    }
+
+    /// Cells of page index, read-only
+    const TapeSymbol* page(std::int64_t index)
+    {
+        Page& page = slot(index);
+
+        if(!page.cells) {
+            load(index, page);
+        }
+
+        return page.cells;
+    }
+
+    /// Cells of page index, copied first if they are shared
+    TapeSymbol* writablePage(std::int64_t index)
+    {
+        Page& page = slot(index);
+
+        if(!page.owned) {
+            const TapeSymbol* cells = this->page(index);
+            page.owned = std::make_unique<TapeSymbol[]>(m_pageSize);
+            std::copy(cells, cells + m_pageSize, page.owned.get());
+            page.cells = page.owned.get();
+            ++m_ownedPages;
+        }
+
+        return page.owned.get();
+    }
+
+    TapeSymbol operator[](std::int64_t position)
+    {
+        const std::int64_t index = pageOf(position);
+        return page(index)[position - index * static_cast<std::int64_t>(m_pageSize)];
+    }
+
+    /// Bytes of the pages owned by the tape: the pages read from a stream or a generator, and the pages written
+    std::size_t residentBytes() const { return m_ownedPages * m_pageSize * sizeof(TapeSymbol); }
+
+    /// Positions of the pages reached so far, [first, last)
+    std::pair<std::int64_t, std::int64_t> reached() const
+    {
+        const auto size = static_cast<std::int64_t>(m_pageSize);
+        return {-static_cast<std::int64_t>(m_left.size()) * size, static_cast<std::int64_t>(m_right.size()) * size};
+    }
+
+    /// Symbols of the input read so far, the whole input once the head has gone past its end
+    std::size_t inputRead() const { return m_inputRead; }
+
+    /// Cells from the first to the last non-blank one of the pages reached, always including the input read
+    template<class Tape>
+    Tape contents()
+    {
+        const auto [first, last] = reached();
+        std::int64_t begin = 0;
+        std::int64_t end = static_cast<std::int64_t>(m_inputRead);
+
+        for(std::int64_t position = first; position < last; ++position) {
+            if((*this)[position] != m_blank) {
+                begin = std::min(begin, position);
+                end = std::max(end, position + 1);
+            }
+        }
+
+        Tape tape;
+
+        for(std::int64_t position = begin; position < end; ++position) {
+            tape.push_back((*this)[position]);
+        }
+
+        return tape;
+    }
+
+private:
+    struct Page {
+        const TapeSymbol* cells = nullptr;      ///< Null until the page is reached
+        std::unique_ptr<TapeSymbol[]> owned;    ///< Null while the cells are shared
+    };
+
+    Page& slot(std::int64_t index)
+    {
+        std::vector<Page>& pages = index >= 0 ? m_right : m_left;
+        const auto i = static_cast<std::size_t>(index >= 0 ? index : -index - 1);
+
+        if(i >= pages.size()) {
+            pages.resize(i + 1);
+        }
+
+        return pages[i];
+    }
+
+    void load(std::int64_t index, Page& page)
+    {
+        if(index < 0) {
+            page.cells = m_blankPage.data();
+            return;
+        }
+
+        const std::size_t first = static_cast<std::size_t>(index) * m_pageSize;
+
+        if(!m_mapped.empty()) {
+            if(first + m_pageSize <= m_mapped.size()) {
+                page.cells = m_mapped.data() + first;
+            } else if(first < m_mapped.size()) {
+                /* The last page of the input, completed with blank cells */
+                page.owned = std::make_unique<TapeSymbol[]>(m_pageSize);
+                std::fill(std::copy(m_mapped.begin() + static_cast<std::ptrdiff_t>(first), m_mapped.end(), page.owned.get()),
+                          page.owned.get() + m_pageSize, m_blank);
+                page.cells = page.owned.get();
+                ++m_ownedPages;
+            } else {
+                page.cells = m_blankPage.data();
+            }
+
+            m_inputRead = std::max(m_inputRead, std::min(first + m_pageSize, m_mapped.size()));
+            return;
+        }
+
+        /* A stream is read in order: the pages before were reached first */
+        for(std::int64_t previous = 0; previous < index; ++previous) {
+            if(!slot(previous).cells) {
+                load(previous, slot(previous));
+            }
+        }
+
+        if(m_inputEnded) {
+            page.cells = m_blankPage.data();
+            return;
+        }
+
+        page.owned = std::make_unique<TapeSymbol[]>(m_pageSize);
+        const std::size_t count = m_input.read(std::span<TapeSymbol>(page.owned.get(), m_pageSize));
+        std::fill(page.owned.get() + count, page.owned.get() + m_pageSize, m_blank);
+        page.cells = page.owned.get();
+        ++m_ownedPages;
+
+        m_inputRead += count;
+        m_inputEnded = count < m_pageSize;
+    }
+
+    InputSource<TapeSymbol>& m_input;
+    std::span<const TapeSymbol> m_mapped;
+    TapeSymbol m_blank;
+    std::size_t m_pageSize;
+    std::vector<TapeSymbol> m_blankPage;
+
+    std::vector<Page> m_right;      ///< Pages 0, 1, 2...
+    std::vector<Page> m_left;       ///< Pages -1, -2, -3...
+    std::size_t m_ownedPages = 0;
+    std::size_t m_inputRead = 0;
+    bool m_inputEnded = false;
+};
+
+/// Runs machine like its run() on tape, filled from its input source as the head reaches new pages
+/// Nothing of the input is read before the first step, and the pages are copied on their first change only, so
+/// the run costs the memory of the cells it reaches rather than the size of the input. The final tape stays in
+/// tape: see PagedTape::contents(). Loops are not detected, limits.detectLoops is ignored.
+/// @throw std::invalid_argument If the blank symbol of tape is not the one of the machine
+template<class Machine>
+RunResult runPaged(const Machine& machine, PagedTape<typename Machine::TapeSymbolType>& tape, const RunLimits& limits = {})
+{
+    using Clock = RunLimits::Clock;
+    using State = typename Machine::StateType;
+    using TapeSymbol = typename Machine::TapeSymbolType;
+
+    if(tape.blank() != machine.blank()) {
+        throw std::invalid_argument("The paged tape has another blank symbol than the machine");
+    }
+
+    const State acceptState = machine.qA();
+    const State rejectState = machine.qR();
+    const auto pageSize = static_cast<std::ptrdiff_t>(tape.pageSize());
+    std::optional<Verdict> ret;
+    State currentState = machine.q0();
+    std::int64_t head = 0;
+    std::size_t steps = 0;
+
+    while(!ret.has_value()) {
+        if(limits.stopToken.stop_requested()) {
+            ret = Verdict::Cancelled;
+            break;
+        }
+
+        if(steps == limits.maxSteps || (limits.deadline && Clock::now() >= *limits.deadline)) {
+            ret = Verdict::OutOfFuel;
+            break;
+        }
+
+        const std::size_t chunkEnd = steps + std::min(limits.maxSteps - steps, RunLimits::checkInterval);
+
+        while(steps != chunkEnd && !ret.has_value()) {
+            // Steps within the page of the head, read in place until a step changes one of its cells
+            const std::int64_t page = tape.pageOf(head);
+            const TapeSymbol* cells = tape.page(page);
+            TapeSymbol* writable = nullptr;
+            std::ptrdiff_t cell = static_cast<std::ptrdiff_t>(head - page * pageSize);
+
+            while(steps != chunkEnd && cell >= 0 && cell < pageSize) {
+                const State previousState = currentState;
+                const TapeSymbol read = cells[cell];
+
+                BasicNextStep<State, TapeSymbol> nextStep;
+                nextStep.whereToMove = Move::RIGHT;
+                nextStep.writeSymbol = read;
+                nextStep.nextState = rejectState;
+
+                callOneStep(machine, currentState, read, nextStep);
+
+                if(nextStep.writeSymbol != read) {
+                    if(!writable) {
+                        writable = tape.writablePage(page);
+                        cells = writable;
+                    }
+
+                    writable[cell] = nextStep.writeSymbol;
+                }
+
+                const int direction = nextStep.whereToMove == Move::LEFT ? -1 : 1;
+                cell += direction;
+                currentState = nextStep.nextState;
+                ++steps;
+
+                if(currentState == acceptState) {
+                    ret = Verdict::Accepted;
+                    break;
+                } else if(currentState == rejectState) {
+                    ret = Verdict::Rejected;
+                    break;
+                }
+
+                if constexpr (requires { machine.sweepRule(currentState, nextStep.whereToMove); }) {
+                    if(currentState == previousState && nextStep.writeSymbol == read) {
+                        if(const auto* rule = machine.sweepRule(currentState, nextStep.whereToMove)) {
+                            const std::ptrdiff_t inPage = direction > 0 ? pageSize - cell : cell + 1;
+                            const std::size_t limit = std::min(chunkEnd - steps, static_cast<std::size_t>(std::max<std::ptrdiff_t>(inPage, 0)));
+
+                            if(limit != 0) {
+                                const std::size_t swept = rule->scan(cells, cell, direction, limit);
+                                cell += direction * static_cast<std::ptrdiff_t>(swept);
+                                steps += swept;
+                            }
+                        }
+                    }
+                }
+            }
+
+            head = page * pageSize + cell;
+        }
+    }
+
+    return {ret.value(), steps, static_cast<std::ptrdiff_t>(head)};
+}
+
+}
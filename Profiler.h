@@ -0,0 +1,312 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <ostream>
+#include <algorithm>
+#include "StringStream.h"
+#include "StepObserver.h"
+#include "TransitionTable.h"
+
+namespace trmch {
+
+/// Instrumentation policy counting where a machine spends its steps, passed to BasicTuringMachine::runObserved
+///
+/// Collects per-transition hits, per-state step totals, a histogram of the head positions and the extent of the tape,
+/// accumulated over every run it observes. Running with NoObserver instead compiles the instrumentation out entirely.
+/// Counters are indexed by the compact indices of the delta function, so a step costs two index translations
+/// and three increments. Sweeps are stepped one by one while profiling so that every step is counted.
+template<class State, class TapeSymbol>
+class Profiler
+{
+public:
+    static constexpr bool observesSteps = true;
+
+    struct TransitionHits {
+        State state;
+        TapeSymbol symbol;
+        std::uint64_t hits;
+    };
+
+    struct StateSteps {
+        State state;
+        std::uint64_t steps;
+    };
+
+    /// @param machine Machine with a deltaFunction() listing its transitions, such as TuringMachine
+    template<class Machine>
+    explicit Profiler(const Machine& machine)
+    {
+        std::vector<State> states;
+        std::vector<TapeSymbol> symbols;
+
+        for(const auto& transition : machine.deltaFunction()) {
+            states.push_back(transition.stateFrom);
+            symbols.push_back(transition.symbolOriginal);
+        }
+
+        m_states = CompactIndex<State>(std::move(states));
+        m_symbols = CompactIndex<TapeSymbol>(std::move(symbols));
+
+        /* One more row and column for the steps without transition */
+        m_transitionHits.assign((m_states.size() + 1) * (m_symbols.size() + 1), 0);
+    }
+
+    void onStart(const TwoWayTape<TapeSymbol>& tape, State, std::ptrdiff_t head)
+    {
+        ++m_runs;
+        m_maxCapacity = std::max(m_maxCapacity, tape.capacity());
+        m_runLeftmost = std::min<std::ptrdiff_t>(head, 0);
+        m_runRightmost = std::max<std::ptrdiff_t>(head, static_cast<std::ptrdiff_t>(tape.inputSize()) - 1);
+        m_maxExtent = std::max(m_maxExtent, static_cast<std::size_t>(m_runRightmost - m_runLeftmost + 1));
+    }
+
+    std::optional<Verdict> onStep(const StepEvent<State, TapeSymbol>& event, const TwoWayTape<TapeSymbol>& tape)
+    {
+        ++m_steps;
+        ++m_transitionHits[index(m_states[event.stateFrom], m_states.size()) * (m_symbols.size() + 1)
+                           + index(m_symbols[event.read], m_symbols.size())];
+
+        visit(event.head);
+
+        if(event.head < m_runLeftmost || event.head > m_runRightmost) {
+            m_runLeftmost = std::min(m_runLeftmost, event.head);
+            m_runRightmost = std::max(m_runRightmost, event.head);
+            m_maxExtent = std::max(m_maxExtent, static_cast<std::size_t>(m_runRightmost - m_runLeftmost + 1));
+            m_maxCapacity = std::max(m_maxCapacity, tape.capacity());
+        }
+
+        return std::nullopt;
+    }
+
+    std::uint64_t runs() const { return m_runs; }
+    std::uint64_t steps() const { return m_steps; }
+
+    /// Largest number of cells between the leftmost and the rightmost visited or input cell of a run
+    std::size_t maxExtent() const { return m_maxExtent; }
+
+    /// Largest number of cells allocated for a tape
+    std::size_t maxCapacity() const { return m_maxCapacity; }
+
+    /// Hits of each transition of the delta function, most hit first
+    /// Steps in a state and on a symbol without transition are not listed.
+    std::vector<TransitionHits> transitionHits() const
+    {
+        std::vector<TransitionHits> hits;
+
+        for(std::uint32_t state = 0; state < m_states.size(); ++state) {
+            for(std::uint32_t symbol = 0; symbol < m_symbols.size(); ++symbol) {
+                if(const std::uint64_t count = m_transitionHits[state * (m_symbols.size() + 1) + symbol]) {
+                    hits.push_back({m_states.key(state), m_symbols.key(symbol), count});
+                }
+            }
+        }
+
+        std::stable_sort(hits.begin(), hits.end(), [](const TransitionHits& a, const TransitionHits& b) {
+            return a.hits > b.hits;
+        });
+
+        return hits;
+    }
+
+    /// Steps taken from each state of the delta function, most used first
+    std::vector<StateSteps> stateSteps() const
+    {
+        std::vector<StateSteps> steps;
+
+        for(std::uint32_t state = 0; state < m_states.size(); ++state) {
+            std::uint64_t total = 0;
+
+            for(std::uint32_t symbol = 0; symbol <= m_symbols.size(); ++symbol) {
+                total += m_transitionHits[state * (m_symbols.size() + 1) + symbol];
+            }
+
+            if(total != 0) {
+                steps.push_back({m_states.key(state), total});
+            }
+        }
+
+        std::stable_sort(steps.begin(), steps.end(), [](const StateSteps& a, const StateSteps& b) {
+            return a.steps > b.steps;
+        });
+
+        return steps;
+    }
+
+    /// Leftmost position of the head histogram
+    std::ptrdiff_t histogramFirst() const { return m_histogramFirst; }
+
+    /// Steps made with the head on each position from histogramFirst()
+    std::span<const std::uint64_t> headHistogram() const
+    {
+        return std::span<const std::uint64_t>(m_headHistogram).subspan(m_headMargin);
+    }
+
+    /// Steps made with the head on position
+    std::uint64_t headVisits(std::ptrdiff_t position) const
+    {
+        const std::span<const std::uint64_t> histogram = headHistogram();
+        const std::ptrdiff_t cell = position - m_histogramFirst;
+        return cell >= 0 && cell < static_cast<std::ptrdiff_t>(histogram.size()) ? histogram[cell] : 0;
+    }
+
+    void writeJson(std::ostream& out) const
+    {
+        out << "{\n"
+            << "  \"runs\": " << m_runs << ",\n"
+            << "  \"steps\": " << m_steps << ",\n"
+            << "  \"maxExtent\": " << m_maxExtent << ",\n"
+            << "  \"maxCapacity\": " << m_maxCapacity << ",\n"
+            << "  \"transitions\": [";
+
+        const auto transitions = transitionHits();
+
+        for(std::size_t i = 0; i < transitions.size(); ++i) {
+            out << (i ? ",\n" : "\n") << "    {\"state\": " << jsonString(transitions[i].state)
+                << ", \"symbol\": " << jsonString(transitions[i].symbol) << ", \"hits\": " << transitions[i].hits << "}";
+        }
+
+        out << "\n  ],\n"
+            << "  \"states\": [";
+
+        const auto states = stateSteps();
+
+        for(std::size_t i = 0; i < states.size(); ++i) {
+            out << (i ? ",\n" : "\n") << "    {\"state\": " << jsonString(states[i].state) << ", \"steps\": " << states[i].steps << "}";
+        }
+
+        out << "\n  ],\n"
+            << "  \"head\": {\"first\": " << m_histogramFirst << ", \"histogram\": [";
+
+        const std::span<const std::uint64_t> histogram = headHistogram();
+
+        for(std::size_t i = 0; i < histogram.size(); ++i) {
+            out << (i ? ", " : "") << histogram[i];
+        }
+
+        out << "]}\n"
+            << "}\n";
+    }
+
+    /// One line per transition: state,symbol,hits
+    void writeCsv(std::ostream& out) const
+    {
+        out << "state,symbol,hits\n";
+
+        for(const TransitionHits& transition : transitionHits()) {
+            out << csvField(transition.state) << "," << csvField(transition.symbol) << "," << transition.hits << "\n";
+        }
+    }
+
+    void reset()
+    {
+        std::fill(m_transitionHits.begin(), m_transitionHits.end(), 0);
+        m_headHistogram.clear();
+        m_headMargin = 0;
+        m_histogramFirst = 0;
+        m_runs = m_steps = 0;
+        m_maxExtent = m_maxCapacity = 0;
+    }
+
+private:
+    /// Unknown states and symbols, which have no transition, go to the extra last row or column
+    static std::size_t index(std::uint32_t compactIndex, std::size_t size)
+    {
+        return compactIndex == CompactIndex<State>::npos ? size : compactIndex;
+    }
+
+    void visit(std::ptrdiff_t position)
+    {
+        if(m_headHistogram.size() == m_headMargin) {
+            m_histogramFirst = position;
+        }
+
+        if(position < m_histogramFirst) {
+            const auto missing = static_cast<std::size_t>(m_histogramFirst - position);
+
+            /* The margin at least doubles the storage, so a run growing to the left inserts O(log n) times */
+            if(missing > m_headMargin) {
+                const std::size_t extra = std::max(missing - m_headMargin, m_headHistogram.size());
+                m_headHistogram.insert(m_headHistogram.begin(), extra, 0);
+                m_headMargin += extra;
+            }
+
+            m_headMargin -= missing;
+            m_histogramFirst = position;
+        }
+
+        const std::size_t cell = m_headMargin + static_cast<std::size_t>(position - m_histogramFirst);
+
+        if(cell >= m_headHistogram.size()) {
+            m_headHistogram.resize(cell + 1, 0);
+        }
+
+        ++m_headHistogram[cell];
+    }
+
+    template<class T>
+    static std::string text(const T& value)
+    {
+        return StringStream() << value;
+    }
+
+    template<class T>
+    static std::string jsonString(const T& value)
+    {
+        std::string escaped = "\"";
+
+        for(char c : text(value)) {
+            if(c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if(static_cast<unsigned char>(c) < 0x20) {
+                escaped += StringStream() << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+            } else {
+                escaped += c;
+            }
+        }
+
+        return escaped + "\"";
+    }
+
+    template<class T>
+    static std::string csvField(const T& value)
+    {
+        const std::string field = text(value);
+
+        if(field.find_first_of(",\"\n ") == std::string::npos && !field.empty()) {
+            return field;
+        }
+
+        std::string quoted = "\"";
+
+        for(char c : field) {
+            quoted += c;
+
+            if(c == '"') {
+                quoted += '"';
+            }
+        }
+
+        return quoted + "\"";
+    }
+
+    CompactIndex<State> m_states;
+    CompactIndex<TapeSymbol> m_symbols;
+    std::vector<std::uint64_t> m_transitionHits;   ///< Indexed by state index * (symbols + 1) + symbol index
+
+    std::vector<std::uint64_t> m_headHistogram;    ///< From m_headMargin unused cells, then histogramFirst()
+    std::size_t m_headMargin = 0;
+    std::ptrdiff_t m_histogramFirst = 0;
+
+    std::uint64_t m_runs = 0;
+    std::uint64_t m_steps = 0;
+    std::ptrdiff_t m_runLeftmost = 0;
+    std::ptrdiff_t m_runRightmost = 0;
+    std::size_t m_maxExtent = 0;
+    std::size_t m_maxCapacity = 0;
+};
+
+}
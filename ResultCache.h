@@ -0,0 +1,259 @@
+#pragma once
+
+#include <list>
+#include <span>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include "RunLimits.h"
+#include "Fingerprint.h"
+
+namespace trmch {
+
+/// Thread-safe bounded cache of run results keyed by (machine fingerprint, input), least recently used out first
+///
+/// The key holds the fingerprint of the machine's delta function (see TuringMachine::fingerprint), so results of a
+/// machine are never served to a machine with other transitions: a changed machine misses, and the results of the
+/// previous one age out. A result is only reused under limits that would give the same result:
+///  - a halted run, if limits.maxSteps allows its steps,
+///  - a run found to loop, if loops are detected and limits.maxSteps allows its steps,
+///  - a run out of fuel, if limits.maxSteps is the same budget and the run detected loops or the request doesn't.
+/// Cancelled runs, runs stopped by their deadline and runs under a stop token or a deadline are not cached.
+/// The final tape is stored only when storeTapes is set; a request for the tape misses on an entry without one.
+template<class Input = std::string, class Tape = std::string>
+class ResultCache
+{
+public:
+    struct Statistics {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t size = 0;
+    };
+
+    /// @param capacity Number of results kept
+    explicit ResultCache(std::size_t capacity, bool storeTapes = false)
+        : m_capacity(std::max<std::size_t>(capacity, 1)),
+          m_storeTapes(storeTapes) {}
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /// Like machine.run(), running the machine only if no cached result applies
+    template<class Machine>
+    RunResult run(const Machine& machine, const Input& input, const RunLimits& limits, Tape* finalTape = nullptr)
+    {
+        const Key key{machine.fingerprint(), input};
+
+        if(cacheable(limits)) {
+            if(const std::optional<RunResult> cached = find(key, limits, finalTape)) {
+                return *cached;
+            }
+        }
+
+        Tape tape;
+        const bool keepTape = finalTape || m_storeTapes;
+        const RunResult result = machine.run(input, limits, keepTape ? &tape : nullptr);
+
+        if(cacheable(limits)) {
+            insert(key, result, limits, keepTape ? &tape : nullptr);
+        }
+
+        if(finalTape) {
+            *finalTape = std::move(tape);
+        }
+
+        return result;
+    }
+
+    /// Like machine.accept(): runs until the machine halts, never returning if it loops
+    template<class Machine>
+    bool accept(const Machine& machine, const Input& input, Tape* finalTape = nullptr)
+    {
+        return run(machine, input, {}, finalTape).accepted();
+    }
+
+    /// Like machine.acceptBatch(), only running the inputs without a cached result, as one batch
+    template<class Machine>
+    std::vector<RunResult> acceptBatch(const Machine& machine, std::span<const Input> inputs, const BatchOptions& options = {})
+    {
+        std::vector<RunResult> results(inputs.size());
+        std::vector<std::size_t> missing;
+        std::vector<Input> missingInputs;
+        std::vector<std::size_t> missingSteps;
+
+        const auto limitsOf = [&](std::size_t i) {
+            RunLimits limits = options.limits;
+
+            if(!options.maxSteps.empty()) {
+                limits.maxSteps = options.maxSteps[i];
+            }
+
+            return limits;
+        };
+
+        const bool useCache = cacheable(options.limits);
+
+        for(std::size_t i = 0; i < inputs.size(); ++i) {
+            std::optional<RunResult> cached;
+
+            if(useCache) {
+                cached = find(Key{machine.fingerprint(), inputs[i]}, limitsOf(i), nullptr);
+            }
+
+            if(cached) {
+                results[i] = *cached;
+            } else {
+                missing.push_back(i);
+                missingInputs.push_back(inputs[i]);
+                missingSteps.push_back(limitsOf(i).maxSteps);
+            }
+        }
+
+        if(missing.empty()) {
+            return results;
+        }
+
+        BatchOptions batch = options;
+        batch.maxSteps = missingSteps;
+        const std::vector<RunResult> computed = machine.acceptBatch(std::span<const Input>(missingInputs), batch);
+
+        for(std::size_t j = 0; j < missing.size(); ++j) {
+            results[missing[j]] = computed[j];
+
+            if(useCache) {
+                insert(Key{machine.fingerprint(), std::move(missingInputs[j])}, computed[j], limitsOf(missing[j]), nullptr);
+            }
+        }
+
+        return results;
+    }
+
+    Statistics statistics() const
+    {
+        std::lock_guard lock(m_mutex);
+        Statistics statistics = m_statistics;
+        statistics.size = m_entries.size();
+        return statistics;
+    }
+
+    void clear()
+    {
+        std::lock_guard lock(m_mutex);
+        m_index.clear();
+        m_entries.clear();
+    }
+
+private:
+    struct Key {
+        std::uint64_t machine;
+        Input input;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const
+        {
+            return static_cast<std::size_t>(Fingerprint().add(key.machine).addRange(key.input).value());
+        }
+    };
+
+    struct Entry {
+        Key key;
+        RunResult result;
+        bool detectedLoops;     ///< Whether the run looked for loops: without, running out of fuel may hide one
+        std::optional<Tape> tape;
+    };
+
+    using Entries = std::list<Entry>;
+
+    static bool cacheable(const RunLimits& limits)
+    {
+        return !limits.deadline && !limits.stopToken.stop_possible();
+    }
+
+    static bool applies(const RunResult& result, bool detectedLoops, const RunLimits& limits)
+    {
+        switch(result.verdict) {
+            case Verdict::Accepted:
+            case Verdict::Rejected:
+                return result.steps <= limits.maxSteps;
+
+            case Verdict::Loops:
+                return limits.detectLoops && result.steps <= limits.maxSteps;
+
+            case Verdict::OutOfFuel:
+                return result.steps == limits.maxSteps && (detectedLoops || !limits.detectLoops);
+
+            default:
+                return false;
+        }
+    }
+
+    std::optional<RunResult> find(const Key& key, const RunLimits& limits, Tape* finalTape)
+    {
+        std::lock_guard lock(m_mutex);
+        const auto it = m_index.find(key);
+
+        if(it == m_index.end() || !applies(it->second->result, it->second->detectedLoops, limits) || (finalTape && !it->second->tape)) {
+            ++m_statistics.misses;
+            return std::nullopt;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        ++m_statistics.hits;
+
+        if(finalTape) {
+            *finalTape = *it->second->tape;
+        }
+
+        return it->second->result;
+    }
+
+    void insert(Key key, const RunResult& result, const RunLimits& limits, const Tape* tape)
+    {
+        if(!applies(result, limits.detectLoops, limits)) {
+            return;
+        }
+
+        std::lock_guard lock(m_mutex);
+        const auto it = m_index.find(key);
+
+        if(it != m_index.end()) {
+            /* A halting or looping result answers more requests than running out of fuel: keep it */
+            if(result.verdict == Verdict::OutOfFuel && it->second->result.verdict != Verdict::OutOfFuel) {
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                return;
+            }
+
+            it->second->result = result;
+            it->second->detectedLoops = limits.detectLoops;
+            it->second->tape = tape && m_storeTapes ? std::optional<Tape>(*tape) : std::nullopt;
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+
+        m_entries.push_front({std::move(key), result, limits.detectLoops, tape && m_storeTapes ? std::optional<Tape>(*tape) : std::nullopt});
+        m_index.emplace(m_entries.front().key, m_entries.begin());
+
+        if(m_entries.size() > m_capacity) {
+            m_index.erase(m_entries.back().key);
+            m_entries.pop_back();
+            ++m_statistics.evictions;
+        }
+    }
+
+    std::size_t m_capacity;
+    bool m_storeTapes;
+
+    mutable std::mutex m_mutex;
+    Entries m_entries;      ///< Most recently used first
+    std::unordered_map<Key, typename Entries::iterator, KeyHash> m_index;
+    Statistics m_statistics;
+};
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <coroutine>
+#include "RunLimits.h"
+#include "StepObserver.h"
+#include "LoopDetector.h"
+
+namespace trmch {
+
+/// Coroutine of a run that pauses every slice of steps, see runResumable()
+///
+/// Nothing runs until resume() is called, and each call then applies at most one slice of steps. So a thread can
+/// interleave many runs, or drop one between two slices, which destroys it. The machine must outlive the run.
+class ResumableRun
+{
+public:
+    struct promise_type {
+        std::size_t steps = 0;
+        std::optional<RunResult> result;
+        std::exception_ptr exception;
+
+        ResumableRun get_return_object() { return ResumableRun(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(std::size_t stepsSoFar)
+        {
+            steps = stepsSoFar;
+            return {};
+        }
+
+        void return_value(const RunResult& runResult)
+        {
+            steps = runResult.steps;
+            result = runResult;
+        }
+
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    ResumableRun() = default;
+
+    ResumableRun(ResumableRun&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    ResumableRun& operator=(ResumableRun&& other) noexcept
+    {
+        if(this != &other) {
+            destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~ResumableRun() { destroy(); }
+
+    /// Applies the next slice of steps
+    /// @return Whether the run is over, result() then holds its result
+    /// @throw Whatever the run threw
+    bool resume()
+    {
+        if(!m_handle) {
+            throw std::logic_error("Resuming an empty run");
+        }
+
+        if(!m_handle.done()) {
+            m_handle.resume();
+        }
+
+        if(m_handle.promise().exception) {
+            std::rethrow_exception(m_handle.promise().exception);
+        }
+
+        return m_handle.done();
+    }
+
+    bool done() const { return m_handle && m_handle.done(); }
+
+    /// Steps applied so far
+    std::size_t steps() const { return m_handle ? m_handle.promise().steps : 0; }
+
+    /// @throw std::logic_error If the run is not over
+    const RunResult& result() const
+    {
+        if(!done() || !m_handle.promise().result) {
+            throw std::logic_error("The run is not over");
+        }
+
+        return *m_handle.promise().result;
+    }
+
+private:
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit ResumableRun(Handle handle)
+        : m_handle(handle) {}
+
+    void destroy()
+    {
+        if(m_handle) {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+    Handle m_handle;
+};
+
+/// Runs machine like its run(), in slices of sliceSteps steps: the run pauses after each one
+/// limits.maxSteps and limits.deadline bound the whole run, and stopping limits.stopToken cancels it at its next
+/// slice. Loops are detected across slices. The machine, and finalTape if any, must outlive the run.
+template<class Machine>
+ResumableRun runResumable(const Machine& machine, typename Machine::InputType input, RunLimits limits,
+                          std::size_t sliceSteps, typename Machine::TapeType* finalTape = nullptr)
+{
+    using Detector = LoopDetector<typename Machine::StateType, typename Machine::TapeSymbolType>;
+
+    typename Machine::ConfigurationType configuration = machine.start(input);
+    sliceSteps = std::max<std::size_t>(sliceSteps, 1);
+
+    Detector detector;
+    ContinuedObserver<Detector> continuedDetector{detector};
+
+    while(true) {
+        RunLimits slice = limits;
+        slice.maxSteps = configuration.steps + std::min(limits.maxSteps - configuration.steps, sliceSteps);
+
+        NoObserver observer;
+        const RunResult result = limits.detectLoops
+                                 ? machine.resumeObserved(configuration, slice, continuedDetector)
+                                 : machine.resumeObserved(configuration, slice, observer);
+
+        if(result.verdict != Verdict::OutOfFuel || result.steps == limits.maxSteps
+           || (limits.deadline && RunLimits::Clock::now() >= *limits.deadline)) {
+            /* Copied once at the end rather than after every slice */
+            if(finalTape) {
+                configuration.tape.contentsInto(*finalTape);
+            }
+
+            co_return result;
+        }
+
+        co_yield result.steps;
+    }
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stop_token>
+
+namespace trmch {
+
+enum class Verdict {
+    Accepted,   ///< The machine reached its accept state
+    Rejected,   ///< The machine reached its reject state, or had no transition to apply
+    OutOfFuel,  ///< The step budget or the deadline was exhausted before the machine halted
+    Cancelled,  ///< A stop was requested through the stop token
+    Loops       ///< The machine was proven to never halt, see RunLimits::detectLoops
+};
+
+/// Bounds of one run. Default limits never stop the machine, like accept() always did.
+struct RunLimits {
+    using Clock = std::chrono::steady_clock;
+
+    /// Deadline and stop token are only polled every checkInterval steps to keep the step loop tight
+    static constexpr std::size_t checkInterval = 4096;
+
+    std::size_t maxSteps = std::numeric_limits<std::size_t>::max();
+    std::optional<Clock::time_point> deadline;
+    std::stop_token stopToken;
+
+    /// Look for configurations that repeat, and stop with Verdict::Loops when one is found (see LoopDetector)
+    /// Every step is then hashed and sweeps are stepped one by one: this is slower than a plain run
+    bool detectLoops = false;
+};
+
+class ThreadPool;
+
+struct BatchOptions {
+    unsigned threads = 0;                   ///< Workers of the pool created for the batch, 0 for one per hardware thread
+    ThreadPool* pool = nullptr;             ///< Pool to reuse across batches instead of creating one, threads is then ignored
+    RunLimits limits;                       ///< Applied to each input on its own
+    std::span<const std::size_t> maxSteps;  ///< Step budget of each input overriding limits.maxSteps, empty to use limits.maxSteps
+};
+
+struct RunResult {
+    Verdict verdict = Verdict::Rejected;
+    std::size_t steps = 0;       ///< Number of transitions applied
+    std::ptrdiff_t head = 0;     ///< Final head position, 0 being the first cell of the input
+
+    bool accepted() const { return verdict == Verdict::Accepted; }
+    bool halted() const { return verdict == Verdict::Accepted || verdict == Verdict::Rejected; }
+};
+
+inline const char* toString(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::Accepted: return "Accepted";
+        case Verdict::Rejected: return "Rejected";
+        case Verdict::OutOfFuel: return "OutOfFuel";
+        case Verdict::Cancelled: return "Cancelled";
+        case Verdict::Loops: return "Loops";
+    }
+
+    return "?";
+}
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <queue>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <future>
+#include <cstdint>
+#include <algorithm>
+#include <optional>
+#include <exception>
+#include <functional>
+#include <stop_token>
+#include <condition_variable>
+#include "RunLimits.h"
+#include "ResumableRun.h"
+
+namespace trmch {
+
+enum class SchedulingPolicy
+{
+    RoundRobin,     ///< Runs take turns, priorities are ignored
+    Priority        ///< Runs of a higher priority take turns first, lower ones only get the workers left idle
+};
+
+/// Fixed set of workers interleaving resumable runs one slice at a time
+///
+/// A worker takes the run at the front of the ready queue, applies one slice of it, and puts it back at the end of
+/// its priority if it is not over. So a short run waits for at most one slice of each run queued before it, however
+/// long these runs are, instead of waiting for them to finish.
+class RunScheduler
+{
+public:
+    /// Run submitted to a scheduler
+    /// A default-constructed Job refers to no run until a job from submit() is assigned to it: cancel() then does
+    /// nothing and the job is never ready.
+    class Job
+    {
+    public:
+        Job() = default;
+
+        /// Whether the job refers to a run submitted to a scheduler
+        bool valid() const { return m_state != nullptr; }
+
+        /// Stops the run at its next slice, its result is then Verdict::Cancelled
+        void cancel()
+        {
+            if(m_state) {
+                m_state->stop.request_stop();
+            }
+        }
+
+        bool ready() const { return m_result.valid() && m_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+        /// Waits for the run to be over, the job must be valid()
+        /// @throw Whatever the run threw
+        RunResult get() { return m_result.get(); }
+
+    private:
+        friend class RunScheduler;
+
+        struct State {
+            ResumableRun run;
+            int priority = 0;
+            std::stop_source stop;
+            std::promise<RunResult> result;
+            std::optional<std::stop_callback<std::function<void()>>> forwardStop;
+            std::optional<std::stop_callback<std::function<void()>>> forwardShutdown;
+        };
+
+        std::shared_ptr<State> m_state;
+        std::future<RunResult> m_result;
+    };
+
+    /// Steps of a slice when none is given, about ten microseconds
+    static constexpr std::size_t defaultSliceSteps = 1 << 16;
+
+    /// @param threads Number of workers, 0 to use one per hardware thread
+    explicit RunScheduler(unsigned threads = 0, SchedulingPolicy policy = SchedulingPolicy::RoundRobin)
+        : m_policy(policy)
+    {
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for(unsigned i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this] { work(); });
+        }
+    }
+
+    /// Cancels the runs not over yet, and waits for the workers
+    ~RunScheduler()
+    {
+        m_shutdown.request_stop();
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_wakeUp.notify_all();
+
+        for(std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    RunScheduler(const RunScheduler&) = delete;
+    RunScheduler& operator=(const RunScheduler&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(m_threads.size()); }
+
+    /// Schedules machine.run(input, limits) in slices of sliceSteps steps
+    /// limits.maxSteps is the budget of the run, and stopping limits.stopToken cancels it like Job::cancel().
+    /// The machine must outlive the run.
+    template<class Machine, class Input>
+    Job submit(const Machine& machine, Input input, RunLimits limits = {}, int priority = 0,
+               std::size_t sliceSteps = defaultSliceSteps)
+    {
+        auto state = std::make_shared<Job::State>();
+        state->priority = priority;
+
+        if(limits.stopToken.stop_possible()) {
+            state->forwardStop.emplace(limits.stopToken, [stop = state->stop]() mutable { stop.request_stop(); });
+        }
+
+        limits.stopToken = state->stop.get_token();
+        state->run = runResumable(machine, std::move(input), limits, sliceSteps);
+
+        return enqueue(std::move(state));
+    }
+
+    /// Runs left, running or waiting for a worker
+    std::size_t pending() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_pending;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<Job::State> job;
+        int priority;
+        std::uint64_t turn;
+    };
+
+    struct Later {
+        bool operator()(const Entry& a, const Entry& b) const
+        {
+            if(a.priority != b.priority) {
+                return a.priority < b.priority;
+            }
+
+            return a.turn > b.turn;
+        }
+    };
+
+    Job enqueue(std::shared_ptr<Job::State> state)
+    {
+        state->forwardShutdown.emplace(m_shutdown.get_token(), [stop = state->stop]() mutable { stop.request_stop(); });
+
+        Job job;
+        job.m_result = state->result.get_future();
+        job.m_state = state;
+
+        {
+            std::lock_guard lock(m_mutex);
+            ++m_pending;
+            push(std::move(state));
+        }
+
+        m_wakeUp.notify_one();
+        return job;
+    }
+
+    /// @pre m_mutex is locked
+    void push(std::shared_ptr<Job::State> job)
+    {
+        const int priority = m_policy == SchedulingPolicy::Priority ? job->priority : 0;
+        m_ready.push({std::move(job), priority, m_nextTurn++});
+    }
+
+    void work()
+    {
+        std::unique_lock lock(m_mutex);
+
+        while(true) {
+            m_wakeUp.wait(lock, [this] { return m_stopping || !m_ready.empty(); });
+
+            if(m_ready.empty()) {
+                return;
+            }
+
+            std::shared_ptr<Job::State> job = m_ready.top().job;
+            m_ready.pop();
+            lock.unlock();
+
+            bool over = true;
+            std::exception_ptr exception;
+
+            try {
+                over = job->run.resume();
+            } catch(...) {
+                exception = std::current_exception();
+            }
+
+            lock.lock();
+
+            if(!over) {
+                push(std::move(job));
+                continue;
+            }
+
+            /* Not pending anymore by the time its result is ready */
+            --m_pending;
+            lock.unlock();
+
+            if(exception) {
+                job->result.set_exception(exception);
+            } else {
+                job->result.set_value(job->run.result());
+            }
+
+            lock.lock();
+        }
+    }
+
+    SchedulingPolicy m_policy;
+    std::stop_source m_shutdown;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::priority_queue<Entry, std::vector<Entry>, Later> m_ready;
+    std::uint64_t m_nextTurn = 0;
+    std::size_t m_pending = 0;
+    bool m_stopping = false;
+
+    std::vector<std::thread> m_threads;
+};
+
+}
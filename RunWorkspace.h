@@ -0,0 +1,49 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include "TwoWayTape.h"
+#include "Configuration.h"
+
+namespace trmch {
+
+/// Storage of runs made one after another, see BasicTuringMachine::run(RunWorkspace&, ...)
+///
+/// Each run starts on the tape the previous one left, reset to its input: the tape keeps its storage, so once it has
+/// grown to the size of the runs, runs in the same workspace don't allocate anymore. The final tape of the last run
+/// stays in the workspace, to read in place with finalTape(). A workspace is used by one thread at a time, local()
+/// gives each thread its own.
+template<class State, class TapeSymbol>
+class RunWorkspace
+{
+public:
+    RunWorkspace()
+        : m_configuration(State{}, TapeSymbol{}) {}
+
+    /// The configuration where the last run stopped, which can be resumed
+    Configuration<State, TapeSymbol>& configuration() { return m_configuration; }
+    const Configuration<State, TapeSymbol>& configuration() const { return m_configuration; }
+
+    /// Cells of the last run from the first to the last non-blank one, like the finalTape of run()
+    /// Valid until the next run in this workspace.
+    std::span<const TapeSymbol> finalTape() const { return m_configuration.tape.view(); }
+
+    /// Sets tape to finalTape(), reusing the storage of tape if it can (see TwoWayTape::contentsInto)
+    template<class Tape>
+    void copyFinalTape(Tape& tape) const { m_configuration.tape.contentsInto(tape); }
+
+    /// Cells allocated for the tape
+    std::size_t capacity() const { return m_configuration.tape.capacity(); }
+
+    /// The workspace of the calling thread
+    static RunWorkspace& local()
+    {
+        thread_local RunWorkspace workspace;
+        return workspace;
+    }
+
+private:
+    Configuration<State, TapeSymbol> m_configuration;
+};
+
+}
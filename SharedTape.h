@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace trmch {
+
+/// Tape infinite in both directions made of fixed-size chunks shared copy-on-write between copies
+///
+/// Copying a tape copies one pointer per chunk, and a write clones only the chunk it touches, so configurations
+/// branching from a common ancestor share everything they did not write. Unallocated chunks are blank.
+/// The tape keeps a Zobrist hash of its contents up to date on each write, blank cells hashing to 0 so that
+/// two tapes with the same contents hash the same whatever their allocated extent.
+template<class TapeSymbol>
+class SharedTape
+{
+public:
+    static constexpr std::ptrdiff_t chunkSize = 64;
+    using Chunk = std::array<TapeSymbol, chunkSize>;
+
+    explicit SharedTape(TapeSymbol blank)
+        : m_blank(blank) {}
+
+    /// Resets the tape to the input, position 0 being its first cell
+    template<class InputIt>
+    void assign(InputIt first, InputIt last)
+    {
+        m_chunks.clear();
+        m_firstPosition = 0;
+        m_hash = 0;
+        m_inputSize = 0;
+
+        for(std::ptrdiff_t position = 0; first != last; ++first, ++position) {
+            write(position, *first);
+            ++m_inputSize;
+        }
+    }
+
+    TapeSymbol operator[](std::ptrdiff_t position) const
+    {
+        const std::ptrdiff_t index = chunkIndex(position);
+
+        if(index < 0 || index >= static_cast<std::ptrdiff_t>(m_chunks.size()) || !m_chunks[index]) {
+            return m_blank;
+        }
+
+        return (*m_chunks[index])[cellIndex(position)];
+    }
+
+    /// Clones the chunk holding position, unless the cell already holds symbol
+    /// @return Whether a chunk was allocated
+    bool write(std::ptrdiff_t position, TapeSymbol symbol)
+    {
+        const TapeSymbol previous = (*this)[position];
+
+        if(previous == symbol) {
+            return false;
+        }
+
+        m_hash ^= cellHash(position, previous) ^ cellHash(position, symbol);
+
+        const std::ptrdiff_t index = reserve(position);
+        std::shared_ptr<Chunk> chunk;
+
+        if(m_chunks[index]) {
+            chunk = std::make_shared<Chunk>(*m_chunks[index]);
+        } else {
+            chunk = std::make_shared<Chunk>();
+            chunk->fill(m_blank);
+        }
+
+        (*chunk)[cellIndex(position)] = symbol;
+        m_chunks[index] = std::move(chunk);
+        return true;
+    }
+
+    std::uint64_t hash() const { return m_hash; }
+    TapeSymbol blank() const { return m_blank; }
+    std::size_t inputSize() const { return m_inputSize; }
+    std::size_t chunkCount() const { return m_chunks.size(); }
+
+    bool operator==(const SharedTape& other) const
+    {
+        if(m_hash != other.m_hash) {
+            return false;
+        }
+
+        const std::ptrdiff_t first = std::min(m_firstPosition, other.m_firstPosition);
+        const std::ptrdiff_t last = std::max(lastPosition(), other.lastPosition());
+
+        for(std::ptrdiff_t position = first; position < last; position += chunkSize) {
+            const Chunk* a = chunkAt(position);
+            const Chunk* b = other.chunkAt(position);
+
+            if(a == b) {
+                continue;
+            }
+
+            for(std::ptrdiff_t cell = 0; cell < chunkSize; ++cell) {
+                if((a ? (*a)[cell] : m_blank) != (b ? (*b)[cell] : m_blank)) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /// Cells from the first to the last non-blank one, always including the cells of the input
+    template<class Tape>
+    Tape contents() const
+    {
+        std::ptrdiff_t first = 0;
+        std::ptrdiff_t last = static_cast<std::ptrdiff_t>(m_inputSize);
+
+        for(std::ptrdiff_t position = m_firstPosition; position < lastPosition(); ++position) {
+            if((*this)[position] != m_blank) {
+                first = std::min(first, position);
+                last = std::max(last, position + 1);
+            }
+        }
+
+        Tape tape;
+
+        for(std::ptrdiff_t position = first; position < last; ++position) {
+            tape.push_back((*this)[position]);
+        }
+
+        return tape;
+    }
+
+private:
+    static std::uint64_t mix(std::uint64_t value)
+    {
+        /* splitmix64 finalizer */
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    std::uint64_t cellHash(std::ptrdiff_t position, TapeSymbol symbol) const
+    {
+        if(symbol == m_blank) {
+            return 0;
+        }
+
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &symbol, std::min(sizeof(symbol), sizeof(bits)));
+        return mix(mix(static_cast<std::uint64_t>(position)) ^ bits);
+    }
+
+    std::ptrdiff_t lastPosition() const
+    {
+        return m_firstPosition + static_cast<std::ptrdiff_t>(m_chunks.size()) * chunkSize;
+    }
+
+    std::ptrdiff_t chunkIndex(std::ptrdiff_t position) const
+    {
+        const std::ptrdiff_t offset = position - m_firstPosition;
+        return offset >= 0 ? offset / chunkSize : -1;
+    }
+
+    static std::ptrdiff_t cellIndex(std::ptrdiff_t position)
+    {
+        const std::ptrdiff_t cell = position % chunkSize;
+        return cell < 0 ? cell + chunkSize : cell;
+    }
+
+    const Chunk* chunkAt(std::ptrdiff_t position) const
+    {
+        const std::ptrdiff_t index = chunkIndex(position);
+        return index >= 0 && index < static_cast<std::ptrdiff_t>(m_chunks.size()) ? m_chunks[index].get() : nullptr;
+    }
+
+    /// Extends the chunk list so it covers position
+    /// @return The index of the chunk holding position
+    std::ptrdiff_t reserve(std::ptrdiff_t position)
+    {
+        if(m_chunks.empty()) {
+            m_firstPosition = position - cellIndex(position);
+            m_chunks.resize(1);
+        }
+
+        if(position < m_firstPosition) {
+            const std::ptrdiff_t missing = (m_firstPosition - position + chunkSize - 1) / chunkSize;
+            m_chunks.insert(m_chunks.begin(), static_cast<std::size_t>(missing), nullptr);
+            m_firstPosition -= missing * chunkSize;
+        }
+        else if(position >= lastPosition()) {
+            m_chunks.resize(static_cast<std::size_t>(chunkIndex(position) + 1));
+        }
+
+        return chunkIndex(position);
+    }
+
+    std::vector<std::shared_ptr<const Chunk>> m_chunks;
+    std::ptrdiff_t m_firstPosition = 0;    ///< Position of the first cell of the first chunk, a multiple of chunkSize
+    std::uint64_t m_hash = 0;
+    std::size_t m_inputSize = 0;
+    TapeSymbol m_blank;
+};
+
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <algorithm>
+#include <string_view>
+#include "MetaTuringMachine.h"
+#include "BasicTuringMachine.h"
+#include "SweepRule.h"
+
+namespace trmch {
+
+/// Runtime machine built from the same MetaTransition pack as a MetaTuringMachine
+///
+/// The transitions are compiled at compile time into a dense table of state x symbol, the states being numbered
+/// first: a step is one load from a constant array, without building or searching a table at runtime. As in
+/// MetaTuringMachine, the first transition matching a state and a symbol applies, and the others are ignored.
+///
+/// run() and the other runs of BasicTuringMachine use the tape of the runtime engine: it is infinite in both
+/// directions, and a missing transition rejects after a step. runMeta() runs with the semantics of MetaTuringMachine
+/// instead: the head stays on the first cell when it moves left of it, and a missing transition rejects without a
+/// step. So runMeta() gives the verdict and the steps of Meta and ConstexprMeta, on inputs known at runtime only.
+template<
+    AcceptState acceptState,
+    RejectState rejectState,
+    InitialState initialState,
+    class... Transitions>
+requires are_instances<MetaTransition, Transitions...>
+      && (acceptState.value != rejectState.value)
+class StaticTuringMachine : public BasicTuringMachine<StaticTuringMachine<acceptState, rejectState, initialState, Transitions...>>
+{
+    using Base = BasicTuringMachine<StaticTuringMachine>;
+    using NextStep = typename Base::NextStep;
+
+    /// The states a run may look a transition up in: the initial state, the states with transitions and the states
+    /// they enter, but the accept and reject states where a run stops. Sorted, with their count.
+    static constexpr auto collectStates()
+    {
+        std::array<int, 1 + 2 * sizeof...(Transitions)> states{};
+        std::size_t count = 0;
+
+        states[count++] = initialState;
+        ((states[count++] = Transitions::stateFrom), ...);
+        ((Transitions::stateTo != acceptState && Transitions::stateTo != rejectState ? void(states[count++] = Transitions::stateTo) : void()), ...);
+
+        std::sort(states.begin(), states.begin() + count);
+        count = std::size_t(std::unique(states.begin(), states.begin() + count) - states.begin());
+
+        return std::make_pair(states, count);
+    }
+
+public:
+    /// The same machine run at compile time on Input, see MetaTuringMachine
+    template<class Input>
+    using Meta = MetaTuringMachine<Input, acceptState, rejectState, initialState, Transitions...>;
+
+    /// The same machine run at compile time on Input, see ConstexprMetaTuringMachine
+    template<class Input>
+    using ConstexprMeta = ConstexprMetaTuringMachine<Input, acceptState, rejectState, initialState, Transitions...>;
+
+    /// Rows of the table, one per state a run may look a transition up in, whatever the numbers of the states
+    static constexpr std::size_t rows = collectStates().second;
+    static constexpr std::size_t symbols = 256;
+
+    StaticTuringMachine()
+        : Base(initialState, acceptState, rejectState)
+    {
+        for(std::size_t row = 0; row < rows; ++row) {
+            for(std::size_t symbol = 0; symbol < symbols; ++symbol) {
+                const Entry& entry = table[row * symbols + symbol];
+
+                if(entry.defined && entry.nextStep.nextState == states[row] && entry.nextStep.writeSymbol == char(symbol)) {
+                    m_sweeps[2 * row + entry.nextStep.whereToMove].add(char(symbol));
+                }
+            }
+        }
+    }
+
+    /// Symbols over which currentState sweeps toward direction, found ahead of time in the table
+    /// @return nullptr if the state has no such self-loop
+    const SweepRule<char>* sweepRule(int currentState, Move direction) const
+    {
+        const std::size_t row = rowOf(currentState);
+
+        if(row == npos || m_sweeps[2 * row + direction].empty()) {
+            return nullptr;
+        }
+
+        return &m_sweeps[2 * row + direction];
+    }
+
+    /// Runs with the semantics of MetaTuringMachine until the machine halts or one of the limits is reached
+    /// The tape starts at the first cell of the input, where the head stays when it moves left, and a missing
+    /// transition rejects without a step. finalTape receives the cells of the input and the non-blank ones after it.
+    /// Loops are not detected, limits.detectLoops is ignored.
+    [[nodiscard]] RunResult runMeta(std::string_view input, const RunLimits& limits = {}, std::string* finalTape = nullptr) const
+    {
+        using Clock = RunLimits::Clock;
+
+        /* An empty input is a single blank cell */
+        std::string tape(input.empty() ? std::string_view(" ") : input);
+        tape.resize(tape.size() + 64, ' ');
+
+        std::optional<Verdict> ret;
+        int currentState = initialState;
+        std::size_t head = 0;
+        std::size_t steps = 0;
+
+        while(!ret.has_value()) {
+            if(limits.stopToken.stop_requested()) {
+                ret = Verdict::Cancelled;
+                break;
+            }
+
+            if(steps == limits.maxSteps || (limits.deadline && Clock::now() >= *limits.deadline)) {
+                ret = Verdict::OutOfFuel;
+                break;
+            }
+
+            const std::size_t chunkEnd = steps + std::min(limits.maxSteps - steps, RunLimits::checkInterval);
+
+            while(steps != chunkEnd) {
+                if(head == tape.size()) {
+                    tape.resize(2 * tape.size(), ' ');
+                }
+
+                const std::size_t row = rowOf(currentState);
+                const char read = tape[head];
+
+                if(row == npos || !table[row * symbols + static_cast<unsigned char>(read)].defined) {
+                    ret = Verdict::Rejected;
+                    break;
+                }
+
+                const NextStep& nextStep = table[row * symbols + static_cast<unsigned char>(read)].nextStep;
+                tape[head] = nextStep.writeSymbol;
+
+                if(nextStep.whereToMove == RIGHT) {
+                    ++head;
+                } else if(head > 0) {
+                    --head;
+                }
+
+                currentState = nextStep.nextState;
+                ++steps;
+
+                if(currentState == acceptState) {
+                    ret = Verdict::Accepted;
+                    break;
+                } else if(currentState == rejectState) {
+                    ret = Verdict::Rejected;
+                    break;
+                }
+
+                // Sweeps as in the runtime engine, short of the first cell where moving left doesn't move
+                if(nextStep.nextState == states[row] && nextStep.writeSymbol == read) {
+                    if(const SweepRule<char>* rule = sweepRule(currentState, nextStep.whereToMove)) {
+                        const int direction = nextStep.whereToMove == RIGHT ? 1 : -1;
+                        const std::size_t allocated = direction > 0 ? tape.size() - head : head;
+                        const std::size_t swept = rule->scan(tape.data(), std::ptrdiff_t(head), direction,
+                                                             std::min(chunkEnd - steps, allocated));
+
+                        head += direction > 0 ? swept : -swept;
+                        steps += swept;
+                    }
+                }
+            }
+        }
+
+        if(finalTape) {
+            std::size_t last = tape.size();
+
+            while(last > input.size() && tape[last - 1] == ' ') {
+                --last;
+            }
+
+            finalTape->assign(tape.data(), last);
+        }
+
+        return {ret.value(), steps, std::ptrdiff_t(head)};
+    }
+
+protected:
+    void oneStep(int currentState, char currentSymbol, NextStep& nextStep) const
+    {
+        /* A missing transition holds the default step of the run loop, so the step is a plain copy */
+        if(const std::size_t row = rowOf(currentState); row != npos) {
+            nextStep = table[row * symbols + static_cast<unsigned char>(currentSymbol)].nextStep;
+        }
+    }
+
+private:
+    struct Entry {
+        NextStep nextStep;
+        bool defined;
+    };
+
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    static constexpr std::array<int, rows> states = [] {
+        const auto [collected, count] = collectStates();
+        std::array<int, rows> states{};
+        std::copy_n(collected.begin(), count, states.begin());
+        return states;
+    }();
+
+    /// Numbers of the states from the lowest to the highest one, when they are few enough to index rows directly
+    static constexpr std::int64_t firstState = rows == 0 ? 0 : states.front();
+    static constexpr std::int64_t stateSpan = rows == 0 ? 0 : std::int64_t(states.back()) - firstState + 1;
+    static constexpr bool contiguous = stateSpan == std::int64_t(rows);
+    static constexpr bool direct = stateSpan < 4 * std::int64_t(rows) + 256;
+
+    static constexpr auto directRows = [] {
+        std::array<std::uint32_t, direct && !contiguous ? std::size_t(stateSpan) : 0> directRows{};
+
+        if constexpr (direct && !contiguous) {
+            std::fill(directRows.begin(), directRows.end(), std::uint32_t(-1));
+
+            for(std::size_t row = 0; row < rows; ++row) {
+                directRows[std::size_t(states[row] - firstState)] = std::uint32_t(row);
+            }
+        }
+
+        return directRows;
+    }();
+
+    /// Row of state: its number shifted for contiguous numbers, a lookup for a few gaps, a binary search otherwise
+    static constexpr std::size_t rowOf(int state)
+    {
+        const auto offset = std::uint64_t(std::int64_t(state) - firstState);
+
+        if constexpr (contiguous) {
+            return offset < rows ? std::size_t(offset) : npos;
+        } else if constexpr (direct) {
+            return offset < directRows.size() && directRows[offset] != std::uint32_t(-1) ? directRows[offset] : npos;
+        } else {
+            const auto it = std::lower_bound(states.begin(), states.end(), state);
+            return it != states.end() && *it == state ? std::size_t(it - states.begin()) : npos;
+        }
+    }
+
+    static constexpr std::array<Entry, rows * symbols> table = [] {
+        std::array<Entry, rows * symbols> table{};
+
+        /* Missing transitions reject, as the default step of the run loop */
+        for(std::size_t i = 0; i < table.size(); ++i) {
+            table[i] = {{rejectState, char(i % symbols), RIGHT}, false};
+        }
+
+        /* In order, keeping the first transition of each state and symbol */
+        ([&] {
+            Entry& entry = table[rowOf(Transitions::stateFrom) * symbols + static_cast<unsigned char>(Transitions::read)];
+
+            if(!entry.defined) {
+                entry = {{Transitions::stateTo, Transitions::written, Transitions::move}, true};
+            }
+        }(), ...);
+
+        return table;
+    }();
+
+    std::array<SweepRule<char>, 2 * rows> m_sweeps; ///< Indexed by 2 * row + direction
+};
+
+}
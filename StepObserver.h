@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include "RunLimits.h"
+#include "TwoWayTape.h"
+
+namespace trmch {
+
+/// One applied transition, as seen by a step observer
+template<class State, class TapeSymbol>
+struct StepEvent {
+    std::size_t step;       ///< Number of steps applied, this one included
+    State stateFrom;
+    TapeSymbol read;
+    std::ptrdiff_t head;    ///< Position of the cell read and written
+    State stateTo;
+    TapeSymbol written;
+    int move;               ///< -1 for LEFT, 1 for RIGHT
+};
+
+/// Observer of a run, passed to BasicTuringMachine::runObserved
+/// An observer with observesSteps set is called after every step, the halting one included, and the run loop then
+/// stops skipping sweeps so that it sees each of them. onStep may stop the run by returning a verdict, which a halting
+/// step overrides.
+struct NoObserver {
+    static constexpr bool observesSteps = false;
+
+    template<class State, class TapeSymbol>
+    void onStart(const TwoWayTape<TapeSymbol> &, State, std::ptrdiff_t) {}
+
+    template<class State, class TapeSymbol>
+    std::optional<Verdict> onStep(const StepEvent<State, TapeSymbol> &, const TwoWayTape<TapeSymbol> &) { return std::nullopt; }
+};
+
+/// Forwards to observer, but only the first onStart(): one observer then follows a run resumed over several calls
+template<class Observer>
+struct ContinuedObserver {
+    static constexpr bool observesSteps = Observer::observesSteps;
+
+    Observer &observer;
+    bool started = false;
+
+    template<class State, class TapeSymbol>
+    void onStart(const TwoWayTape<TapeSymbol> &tape, State state, std::ptrdiff_t head)
+    {
+        if(!started) {
+            observer.onStart(tape, state, head);
+            started = true;
+        }
+    }
+
+    template<class State, class TapeSymbol>
+    std::optional<Verdict> onStep(const StepEvent<State, TapeSymbol> &event, const TwoWayTape<TapeSymbol> &tape)
+    {
+        return observer.onStep(event, tape);
+    }
+};
+
+}
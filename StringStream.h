@@ -17,7 +17,7 @@ namespace {
         std::ostringstream m_buffer;
     };
 
-    std::string quote(const std::string &str) {
+    inline std::string quote(const std::string &str) {
         return StringStream() << '"' << str << '"';
     }
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+namespace trmch {
+
+/// Symbols over which a state sweeps: it reads one of them, writes it back, keeps its state and moves on
+/// in the same direction. A run of such cells can be crossed in one scan instead of one step per cell.
+template<class TapeSymbol>
+class SweepRule
+{
+public:
+    void add(TapeSymbol symbol)
+    {
+        if(std::find(m_symbols.begin(), m_symbols.end(), symbol) == m_symbols.end()) {
+            m_symbols.push_back(symbol);
+        }
+
+        if constexpr (isByte) {
+            m_isSwept[toByte(symbol)] = true;
+        }
+    }
+
+    bool empty() const { return m_symbols.empty(); }
+
+    bool contains(TapeSymbol symbol) const
+    {
+        if constexpr (isByte) {
+            return m_isSwept[toByte(symbol)];
+        } else {
+            return std::find(m_symbols.begin(), m_symbols.end(), symbol) != m_symbols.end();
+        }
+    }
+
+    /// @param direction 1 to scan toward the right, -1 toward the left
+    /// @param limit Maximum number of cells to scan, all of them must be allocated
+    /// @return Number of consecutive swept cells from cells[cell] in that direction
+    std::size_t scan(const TapeSymbol* cells, std::ptrdiff_t cell, std::ptrdiff_t direction, std::size_t limit) const
+    {
+        if constexpr (isByte) {
+            if(m_symbols.size() == 1) {
+                return scanSingleByte(reinterpret_cast<const unsigned char*>(cells), cell, direction, limit);
+            }
+        }
+
+        std::size_t count = 0;
+
+        while(count != limit && contains(cells[cell])) {
+            cell += direction;
+            ++count;
+        }
+
+        return count;
+    }
+
+private:
+    static constexpr bool isByte = sizeof(TapeSymbol) == 1;
+
+    static unsigned char toByte(TapeSymbol symbol)
+    {
+        unsigned char byte;
+        std::memcpy(&byte, &symbol, 1);
+        return byte;
+    }
+
+    /// Compares 8 cells at a time: the first differing cell is the first non-zero byte of the XOR with the symbol
+    std::size_t scanSingleByte(const unsigned char* cells, std::ptrdiff_t cell, std::ptrdiff_t direction, std::size_t limit) const
+    {
+        constexpr std::size_t wordSize = sizeof(std::uint64_t);
+        const unsigned char symbol = toByte(m_symbols.front());
+        const std::uint64_t pattern = 0x0101010101010101ull * symbol;
+
+        std::size_t count = 0;
+
+        if constexpr (std::endian::native == std::endian::little) {
+            while(limit - count >= wordSize) {
+                /* Load the next 8 cells in scanning order: to the left, they end at the current cell */
+                const unsigned char* word = direction > 0 ? cells + cell : cells + cell - (wordSize - 1);
+
+                std::uint64_t value;
+                std::memcpy(&value, word, wordSize);
+                value ^= pattern;
+
+                if(value != 0) {
+                    const int zeroBits = direction > 0 ? std::countr_zero(value) : std::countl_zero(value);
+                    return count + static_cast<std::size_t>(zeroBits / 8);
+                }
+
+                cell += direction * static_cast<std::ptrdiff_t>(wordSize);
+                count += wordSize;
+            }
+        }
+
+        while(count != limit && cells[cell] == symbol) {
+            cell += direction;
+            ++count;
+        }
+
+        return count;
+    }
+
+    std::vector<TapeSymbol> m_symbols;
+    std::array<bool, 256> m_isSwept{};
+};
+
+}
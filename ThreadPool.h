@@ -0,0 +1,244 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace trmch {
+
+/// Fixed set of workers, each owning a task deque
+/// A worker pops its own tasks from the back (most recent first), and when it runs out,
+/// steals the oldest task of another worker: stolen tasks are the biggest ranges in parallelFor().
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    /// @param threads Number of workers, 0 to use one per hardware thread
+    explicit ThreadPool(unsigned threads = 0)
+    {
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for(unsigned i = 0; i < threads; ++i) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+
+        for(unsigned i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m_sleepMutex);
+            m_stopping = true;
+        }
+
+        m_wakeUp.notify_all();
+
+        for(std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+    /// Tasks submitted from a worker go to its own deque, others are spread round-robin
+    void submit(Task task)
+    {
+        std::size_t index;
+
+        if(t_pool == this) {
+            index = t_index;
+        } else {
+            index = m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        }
+
+        /* Counted before it is published, so that a worker taking it can't bring the count below zero */
+        {
+            std::lock_guard lock(m_sleepMutex);
+            ++m_queued;
+        }
+
+        {
+            Worker& worker = *m_workers[index];
+            std::lock_guard lock(worker.mutex);
+            worker.tasks.push_back(std::move(task));
+        }
+
+        m_wakeUp.notify_one();
+    }
+
+    /// Calls body(i) for every i in [0, count) and blocks until all calls returned
+    /// The range is split recursively, so idle workers steal large halves instead of single items.
+    /// The first exception thrown by body is rethrown here, once every call returned. The calling thread runs queued
+    /// tasks while it waits, so parallelFor() may be called from a task of the same pool.
+    template<class Body>
+    void parallelFor(std::size_t count, const Body& body, std::size_t grainSize = 1)
+    {
+        if(count == 0) {
+            return;
+        }
+
+        struct Join {
+            std::mutex mutex;
+            std::condition_variable done;
+            std::size_t remaining;
+            std::exception_ptr error;
+        } join;
+
+        join.remaining = count;
+        grainSize = std::max<std::size_t>(grainSize, 1);
+
+        std::function<void(std::size_t, std::size_t)> range = [&](std::size_t begin, std::size_t end) {
+            while(end - begin > grainSize) {
+                const std::size_t middle = begin + (end - begin) / 2;
+                submit([&range, middle, end] { range(middle, end); });
+                end = middle;
+            }
+
+            std::exception_ptr error;
+
+            try {
+                for(std::size_t i = begin; i < end; ++i) {
+                    body(i);
+                }
+            }
+            catch(...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard lock(join.mutex);
+
+            if(error && !join.error) {
+                join.error = error;
+            }
+
+            join.remaining -= end - begin;
+
+            if(join.remaining == 0) {
+                join.done.notify_all();
+            }
+        };
+
+        submit([&range, count] { range(0, count); });
+
+        /* The calling thread runs tasks while it waits: called from a worker, it must not hold the worker back */
+        const std::size_t index = t_pool == this ? t_index : 0;
+        std::unique_lock lock(join.mutex);
+
+        while(join.remaining != 0) {
+            lock.unlock();
+
+            if(std::optional<Task> task = pop(index)) {
+                {
+                    std::lock_guard queuedLock(m_sleepMutex);
+                    --m_queued;
+                }
+
+                (*task)();
+                lock.lock();
+            }
+            else {
+                /* Tasks may be submitted by the ones still running: look for them again shortly */
+                lock.lock();
+                join.done.wait_for(lock, std::chrono::microseconds(100), [&] { return join.remaining == 0; });
+            }
+        }
+
+        if(join.error) {
+            std::rethrow_exception(join.error);
+        }
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::optional<Task> pop(std::size_t index)
+    {
+        {
+            Worker& own = *m_workers[index];
+            std::lock_guard lock(own.mutex);
+
+            if(!own.tasks.empty()) {
+                Task task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return task;
+            }
+        }
+
+        for(std::size_t i = 1; i < m_workers.size(); ++i) {
+            Worker& victim = *m_workers[(index + i) % m_workers.size()];
+            std::lock_guard lock(victim.mutex);
+
+            if(!victim.tasks.empty()) {
+                Task task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return task;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    void work(std::size_t index)
+    {
+        t_pool = this;
+        t_index = index;
+
+        while(true) {
+            {
+                std::unique_lock lock(m_sleepMutex);
+                m_wakeUp.wait(lock, [this] { return m_stopping || m_queued > 0; });
+
+                if(m_queued == 0) {
+                    return; /* stopping */
+                }
+            }
+
+            /* Another worker may have taken the task we were woken up for */
+            if(std::optional<Task> task = pop(index)) {
+                {
+                    std::lock_guard lock(m_sleepMutex);
+                    --m_queued;
+                }
+
+                (*task)();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_nextWorker{0};
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeUp;
+    std::size_t m_queued = 0;
+    bool m_stopping = false;
+
+    static inline thread_local ThreadPool* t_pool = nullptr;
+    static inline thread_local std::size_t t_index = 0;
+};
+
+}
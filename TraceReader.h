@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "MappedFile.h"
+#include "TraceWriter.h"
+
+namespace trmch {
+
+/// Reads a trace written by TraceWriter without loading it
+///
+/// The file is memory-mapped: deltas are decoded in place, and restoring the configuration after any step
+/// costs a binary search in the keyframe index plus the replay of at most one keyframe interval of deltas.
+template<class State, class TapeSymbol>
+class TraceReader
+{
+public:
+    /// Change applied by one step
+    struct Delta {
+        State state;        ///< State after the step
+        TapeSymbol written;
+        int move;           ///< -1 for LEFT, 1 for RIGHT
+    };
+
+    /// Configuration after some number of steps
+    struct Snapshot {
+        std::size_t step;
+        State state;
+        std::ptrdiff_t head;
+        std::ptrdiff_t first;   ///< Position of cells[0]
+        std::vector<TapeSymbol> cells;
+        TapeSymbol blank;
+
+        TapeSymbol operator[](std::ptrdiff_t position) const
+        {
+            const std::ptrdiff_t cell = position - first;
+            return cell >= 0 && cell < static_cast<std::ptrdiff_t>(cells.size()) ? cells[cell] : blank;
+        }
+    };
+
+    /// Every offset and count of the index and the keyframes is checked here, so that reading the trace afterwards
+    /// never leaves the file.
+    /// @throw std::runtime_error If the file is not a complete trace for these State and TapeSymbol types, or one of
+    ///                           its keyframes holds more than maximumCells cells
+    explicit TraceReader(const std::filesystem::path& path, std::size_t maximumCells = trace::defaultMaximumCells)
+        : m_file(path)
+    {
+        const std::size_t headerSize = trace::headerMagic.size() + 2 * sizeof(std::uint32_t) + sizeof(std::uint64_t) + sizeof(TapeSymbol);
+
+        if(m_file.size() < headerSize + trace::footerSize
+           || std::memcmp(m_file.data(), trace::headerMagic.data(), trace::headerMagic.size()) != 0
+           || std::memcmp(m_file.data() + m_file.size() - trace::footerMagic.size(), trace::footerMagic.data(), trace::footerMagic.size()) != 0) {
+            throw std::runtime_error(StringStream() << path << " is not a complete trace");
+        }
+
+        std::size_t offset = trace::headerMagic.size();
+
+        if(read<std::uint32_t>(offset) != sizeof(State) || read<std::uint32_t>(offset + 4) != sizeof(TapeSymbol)) {
+            throw std::runtime_error(StringStream() << path << " was recorded with other state or symbol types");
+        }
+
+        m_keyframeInterval = read<std::uint64_t>(offset + 8);
+        m_blank = read<TapeSymbol>(offset + 16);
+
+        offset = m_file.size() - trace::footerSize;
+        const auto indexOffset = read<std::uint64_t>(offset);
+        const auto keyframes = read<std::uint64_t>(offset + 8);
+        m_steps = read<std::uint64_t>(offset + 16);
+        m_verdict = static_cast<Verdict>(read<std::uint8_t>(offset + 24));
+
+        /* Compared without a sum or a product that could wrap around */
+        if(keyframes == 0 || keyframes > (offset - headerSize) / (2 * sizeof(std::uint64_t))
+           || indexOffset != offset - keyframes * 2 * sizeof(std::uint64_t)) {
+            throw std::runtime_error(StringStream() << path << " has a corrupted index");
+        }
+
+        m_index = reinterpret_cast<const std::byte*>(m_file.data() + indexOffset);
+        m_keyframes = keyframes;
+
+        /* Each keyframe and the deltas up to the next one must lie between the header and the index */
+        for(std::size_t keyframe = 0; keyframe < m_keyframes; ++keyframe) {
+            const bool last = keyframe + 1 == m_keyframes;
+            const std::uint64_t begin = keyframeOffset(keyframe);
+            const std::uint64_t end = last ? indexOffset : keyframeOffset(keyframe + 1);
+            const std::uint64_t step = keyframeStep(keyframe);
+            const std::uint64_t nextStep = last ? m_steps : keyframeStep(keyframe + 1);
+
+            if(begin < headerSize || begin > end || end > indexOffset || end - begin < keyframeHeaderSize
+               || (keyframe == 0 && step != 0) || step > nextStep || read<std::uint64_t>(begin) != step) {
+                throw std::runtime_error(StringStream() << path << " has a corrupted index");
+            }
+
+            const auto cells = read<std::uint64_t>(begin + keyframeHeaderSize - sizeof(std::uint64_t));
+            const std::uint64_t available = end - begin - keyframeHeaderSize;
+
+            if(cells > maximumCells || cells > available / sizeof(TapeSymbol)
+               || nextStep - step > (available - cells * sizeof(TapeSymbol)) / deltaSize) {
+                throw std::runtime_error(StringStream() << path << " has a corrupted keyframe");
+            }
+        }
+    }
+
+    std::size_t steps() const { return m_steps; }
+    Verdict verdict() const { return m_verdict; }
+    std::size_t keyframes() const { return m_keyframes; }
+    std::size_t keyframeInterval() const { return m_keyframeInterval; }
+
+    /// @param step In [1, steps()]
+    Delta delta(std::size_t step) const
+    {
+        check(step, 1);
+
+        const std::size_t keyframe = keyframeBefore(step - 1);
+        const std::size_t offset = deltasOf(keyframe) + (step - 1 - keyframeStep(keyframe)) * deltaSize;
+
+        return decode(offset);
+    }
+
+    /// Restores the configuration after step steps, step 0 being the initial configuration
+    /// @param step In [0, steps()]
+    Snapshot at(std::size_t step) const
+    {
+        check(step, 0);
+
+        const std::size_t keyframe = keyframeBefore(step);
+        std::size_t offset = keyframeOffset(keyframe);
+
+        Snapshot snapshot;
+        snapshot.step = read<std::uint64_t>(offset);
+        snapshot.state = read<State>(offset += sizeof(std::uint64_t));
+        snapshot.head = static_cast<std::ptrdiff_t>(read<std::int64_t>(offset += sizeof(State)));
+        snapshot.first = static_cast<std::ptrdiff_t>(read<std::int64_t>(offset += sizeof(std::int64_t)));
+        snapshot.cells.resize(read<std::uint64_t>(offset += sizeof(std::int64_t)));
+        snapshot.blank = m_blank;
+        offset += sizeof(std::uint64_t);
+
+        if(!snapshot.cells.empty()) {
+            std::memcpy(snapshot.cells.data(), m_file.data() + offset, snapshot.cells.size() * sizeof(TapeSymbol));
+        }
+
+        offset += snapshot.cells.size() * sizeof(TapeSymbol);
+
+        for(; snapshot.step < step; ++snapshot.step, offset += deltaSize) {
+            const Delta delta = decode(offset);
+            write(snapshot, snapshot.head, delta.written);
+            snapshot.head += delta.move;
+            snapshot.state = delta.state;
+        }
+
+        return snapshot;
+    }
+
+private:
+    static constexpr std::size_t deltaSize = trace::deltaSize<State, TapeSymbol>;
+    static constexpr std::size_t keyframeHeaderSize = trace::keyframeHeaderSize<State>;
+
+    template<class T>
+    T read(std::size_t offset) const
+    {
+        T value;
+        std::memcpy(&value, m_file.data() + offset, sizeof(T));
+        return value;
+    }
+
+    void check(std::size_t step, std::size_t min) const
+    {
+        if(step < min || step > m_steps) {
+            throw std::out_of_range(StringStream() << "Step " << step << " is not in the trace");
+        }
+    }
+
+    std::size_t keyframeStep(std::size_t keyframe) const
+    {
+        std::uint64_t step;
+        std::memcpy(&step, m_index + keyframe * 2 * sizeof(std::uint64_t), sizeof(step));
+        return step;
+    }
+
+    std::size_t keyframeOffset(std::size_t keyframe) const
+    {
+        std::uint64_t offset;
+        std::memcpy(&offset, m_index + (keyframe * 2 + 1) * sizeof(std::uint64_t), sizeof(offset));
+        return offset;
+    }
+
+    /// Offset of the first delta following a keyframe
+    std::size_t deltasOf(std::size_t keyframe) const
+    {
+        const std::size_t offset = keyframeOffset(keyframe) + keyframeHeaderSize;
+        return offset + read<std::uint64_t>(offset - sizeof(std::uint64_t)) * sizeof(TapeSymbol);
+    }
+
+    /// Last keyframe at or before step, by binary search in the index
+    std::size_t keyframeBefore(std::size_t step) const
+    {
+        std::size_t low = 0;
+        std::size_t high = m_keyframes;
+
+        while(high - low > 1) {
+            const std::size_t middle = low + (high - low) / 2;
+
+            if(keyframeStep(middle) <= step) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+
+        return low;
+    }
+
+    Delta decode(std::size_t offset) const
+    {
+        Delta delta;
+        delta.state = read<State>(offset);
+        delta.written = read<TapeSymbol>(offset + sizeof(State));
+        delta.move = read<std::int8_t>(offset + sizeof(State) + sizeof(TapeSymbol));
+        return delta;
+    }
+
+    static void write(Snapshot& snapshot, std::ptrdiff_t position, TapeSymbol symbol)
+    {
+        if(snapshot.cells.empty()) {
+            snapshot.first = position;
+        }
+
+        if(position < snapshot.first) {
+            snapshot.cells.insert(snapshot.cells.begin(), static_cast<std::size_t>(snapshot.first - position), snapshot.blank);
+            snapshot.first = position;
+        }
+
+        const auto cell = static_cast<std::size_t>(position - snapshot.first);
+
+        if(cell >= snapshot.cells.size()) {
+            snapshot.cells.resize(cell + 1, snapshot.blank);
+        }
+
+        snapshot.cells[cell] = symbol;
+    }
+
+    MappedFile m_file;
+    std::size_t m_keyframeInterval = 0;
+    TapeSymbol m_blank{};
+    std::size_t m_steps = 0;
+    Verdict m_verdict = Verdict::Rejected;
+    const std::byte* m_index = nullptr;
+    std::size_t m_keyframes = 0;
+};
+
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <filesystem>
+#include <type_traits>
+#include "StringStream.h"
+#include "StepObserver.h"
+
+namespace trmch {
+
+/// Binary execution trace, written by TraceWriter and read back by TraceReader
+///
+/// All integers are in the byte order of the machine that wrote the trace:
+///   header    "TRMCHTR1", u32 sizeof(State), u32 sizeof(TapeSymbol), u64 keyframe interval, TapeSymbol blank
+///   body      a keyframe every interval steps, each followed by the deltas of the steps up to the next one
+///             keyframe: u64 step, State state, i64 head, i64 first cell, u64 cell count, the cells
+///             delta:    State state, TapeSymbol written, i8 move (the configuration after the step, as a change)
+///   index     u64 step and u64 file offset of each keyframe
+///   footer    u64 index offset, u64 keyframe count, u64 steps, u8 verdict, "TRMCHEND"
+///
+/// Keyframes hold the cells from the first to the last non-blank one.
+namespace trace {
+    inline constexpr std::array<char, 8> headerMagic{'T', 'R', 'M', 'C', 'H', 'T', 'R', '1'};
+    inline constexpr std::array<char, 8> footerMagic{'T', 'R', 'M', 'C', 'H', 'E', 'N', 'D'};
+
+    inline constexpr std::size_t footerSize = 3 * sizeof(std::uint64_t) + 1 + footerMagic.size();
+
+    template<class State, class TapeSymbol>
+    inline constexpr std::size_t deltaSize = sizeof(State) + sizeof(TapeSymbol) + 1;
+
+    template<class State>
+    inline constexpr std::size_t keyframeHeaderSize = sizeof(std::uint64_t) + sizeof(State) + 2 * sizeof(std::int64_t) + sizeof(std::uint64_t);
+
+    /// Keyframes read by TraceReader hold at most this many cells unless told otherwise
+    inline constexpr std::size_t defaultMaximumCells = std::size_t(1) << 28;
+}
+
+/// Step observer recording a run to a binary trace file (see namespace trace for the format)
+///
+/// Each step appends a fixed-size delta to an in-memory buffer, written to the file when full, and the whole tape
+/// is saved every keyframeInterval steps so that a reader can restore any step from the closest keyframe before it.
+/// finish() must be called with the result of the run to write the index, otherwise the trace can't be read.
+template<class State, class TapeSymbol>
+class TraceWriter
+{
+    static_assert(std::is_trivially_copyable_v<State> && std::is_trivially_copyable_v<TapeSymbol>,
+                  "Traces store states and symbols as raw bytes");
+
+public:
+    static constexpr bool observesSteps = true;
+    static constexpr std::size_t defaultKeyframeInterval = std::size_t(1) << 16;
+    static constexpr std::size_t bufferSize = std::size_t(1) << 20;
+
+    /// @throw std::runtime_error If the file can't be created
+    explicit TraceWriter(const std::filesystem::path& path, std::size_t keyframeInterval = defaultKeyframeInterval)
+        : m_path(path),
+          m_file(path, std::ios::binary | std::ios::trunc),
+          m_keyframeInterval(std::max<std::size_t>(keyframeInterval, 1))
+    {
+        if(!m_file) {
+            throw std::runtime_error(StringStream() << "Cannot create the trace " << path);
+        }
+
+        m_buffer.reserve(bufferSize);
+    }
+
+    void onStart(const TwoWayTape<TapeSymbol>& tape, State state, std::ptrdiff_t head)
+    {
+        m_buffer.clear();
+        m_index.clear();
+        m_offset = 0;
+
+        append(trace::headerMagic);
+        append(static_cast<std::uint32_t>(sizeof(State)));
+        append(static_cast<std::uint32_t>(sizeof(TapeSymbol)));
+        append(static_cast<std::uint64_t>(m_keyframeInterval));
+        append(tape.blank());
+
+        keyframe(0, tape, state, head);
+    }
+
+    std::optional<Verdict> onStep(const StepEvent<State, TapeSymbol>& event, const TwoWayTape<TapeSymbol>& tape)
+    {
+        std::array<std::byte, trace::deltaSize<State, TapeSymbol>> delta;
+        std::memcpy(delta.data(), &event.stateTo, sizeof(State));
+        std::memcpy(delta.data() + sizeof(State), &event.written, sizeof(TapeSymbol));
+        delta.back() = static_cast<std::byte>(static_cast<std::int8_t>(event.move));
+        append(delta);
+
+        if(event.step % m_keyframeInterval == 0) {
+            keyframe(event.step, tape, event.stateTo, event.head + event.move);
+        }
+
+        return std::nullopt;
+    }
+
+    /// Writes the index and the footer, and closes the file
+    /// @throw std::runtime_error If the trace could not be written entirely
+    void finish(const RunResult& result)
+    {
+        const std::uint64_t indexOffset = m_offset + m_buffer.size();
+
+        for(const auto& [step, offset] : m_index) {
+            append(step);
+            append(offset);
+        }
+
+        append(indexOffset);
+        append(static_cast<std::uint64_t>(m_index.size()));
+        append(static_cast<std::uint64_t>(result.steps));
+        append(static_cast<std::uint8_t>(result.verdict));
+        append(trace::footerMagic);
+
+        flush();
+        m_file.close();
+
+        if(!m_file) {
+            throw std::runtime_error(StringStream() << "Cannot write the trace " << m_path);
+        }
+    }
+
+private:
+    template<class T>
+    void append(const T& value)
+    {
+        if(m_buffer.size() + sizeof(T) > bufferSize) {
+            flush();
+        }
+
+        const auto* bytes = reinterpret_cast<const char*>(&value);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void flush()
+    {
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_offset += m_buffer.size();
+        m_buffer.clear();
+    }
+
+    void keyframe(std::size_t step, const TwoWayTape<TapeSymbol>& tape, State state, std::ptrdiff_t head)
+    {
+        std::ptrdiff_t first = tape.first();
+        std::ptrdiff_t last = tape.last();
+
+        while(first < last && tape[first] == tape.blank()) ++first;
+        while(last > first && tape[last - 1] == tape.blank()) --last;
+
+        m_index.emplace_back(step, m_offset + m_buffer.size());
+
+        append(static_cast<std::uint64_t>(step));
+        append(state);
+        append(static_cast<std::int64_t>(head));
+        append(static_cast<std::int64_t>(first));
+        append(static_cast<std::uint64_t>(last - first));
+
+        for(std::ptrdiff_t position = first; position < last; ++position) {
+            append(tape[position]);
+        }
+    }
+
+    std::filesystem::path m_path;
+    std::ofstream m_file;
+    std::size_t m_keyframeInterval;
+
+    std::vector<char> m_buffer;
+    std::uint64_t m_offset = 0;     ///< Bytes already written to the file
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> m_index;
+};
+
+/// Runs machine like its run(), recording every step to a binary trace file to replay with TraceReader
+/// Sweeps are stepped one by one and each step appends a few bytes to a buffer: see TraceWriter.
+template<class Machine, class Writer = TraceWriter<typename Machine::StateType, typename Machine::TapeSymbolType>>
+RunResult recordTrace(const Machine& machine, const typename Machine::InputType& input, const std::filesystem::path& file,
+                      const RunLimits& limits = {}, typename Machine::TapeType* finalTape = nullptr,
+                      std::size_t keyframeInterval = Writer::defaultKeyframeInterval)
+{
+    Writer writer(file, keyframeInterval);
+    const RunResult result = machine.runObserved(input, limits, writer, finalTape);
+    writer.finish(result);
+    return result;
+}
+
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ranges>
+#include <sstream>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include "StringStream.h"
+
+namespace trmch {
+
+/// Maps a sparse set of keys (states, symbols) to the compact range [0, size())
+/// Integral keys spanning a small range are mapped by a direct offset table, others are hashed
+template<class Key>
+class CompactIndex
+{
+public:
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+    CompactIndex() = default;
+
+    explicit CompactIndex(std::vector<Key> keys)
+        : m_keys(std::move(keys))
+    {
+        std::sort(m_keys.begin(), m_keys.end());
+        m_keys.erase(std::unique(m_keys.begin(), m_keys.end()), m_keys.end());
+
+        if constexpr (isDirectlyIndexable) {
+            if(!m_keys.empty()) {
+                const auto span = offsetOf(m_keys.back(), m_keys.front());
+
+                /* Allow some holes, but don't allocate a huge table for a few scattered keys */
+                if(span < 4 * m_keys.size() + 256) {
+                    m_min = m_keys.front();
+                    m_direct.assign(span + 1, npos);
+
+                    for(std::uint32_t i = 0; i < m_keys.size(); ++i) {
+                        m_direct[offsetOf(m_keys[i], m_min)] = i;
+                    }
+
+                    return;
+                }
+            }
+        }
+
+        for(std::uint32_t i = 0; i < m_keys.size(); ++i) {
+            m_sparse.emplace(m_keys[i], i);
+        }
+    }
+
+    /// @return The compact index of key, or npos if the key is unknown
+    std::uint32_t operator[](const Key& key) const
+    {
+        if constexpr (isDirectlyIndexable) {
+            if(!m_direct.empty()) {
+                const auto offset = offsetOf(key, m_min);
+                return offset < m_direct.size() ? m_direct[offset] : npos;
+            }
+        }
+
+        auto it = m_sparse.find(key);
+        return it != m_sparse.end() ? it->second : npos;
+    }
+
+    const Key& key(std::uint32_t index) const { return m_keys[index]; }
+    const std::vector<Key>& keys() const { return m_keys; }
+    std::size_t size() const { return m_keys.size(); }
+
+private:
+    static constexpr bool isDirectlyIndexable = std::is_integral_v<Key> && !std::is_same_v<Key, bool>;
+
+    /// Unsigned arithmetic wraps around, so this is also right for negative signed keys
+    static std::size_t offsetOf(const Key& key, const Key& min)
+    {
+        using Unsigned = std::make_unsigned_t<std::conditional_t<isDirectlyIndexable, Key, int>>;
+        return static_cast<std::size_t>(static_cast<Unsigned>(static_cast<Unsigned>(key) - static_cast<Unsigned>(min)));
+    }
+
+    std::vector<Key> m_keys;
+    Key m_min{};
+    std::vector<std::uint32_t> m_direct;
+    std::unordered_map<Key, std::uint32_t> m_sparse;
+};
+
+/// Dense (state, symbol) -> NextStep lookup compiled from a transition list
+/// States and symbols are remapped to compact indices so a lookup is two index translations and one array access
+template<class State, class TapeSymbol, class NextStep>
+class TransitionTable
+{
+public:
+    TransitionTable() = default;
+
+    /// @param deltaFunction Range of transitions with stateFrom, symbolOriginal and nextStep, read once
+    ///                      Its transitions are first collected into flat arrays, so that a range decoding its
+    ///                      elements, such as the records of a MachineFile, decodes each of them only once.
+    /// @throw std::invalid_argument If two transitions for the same (state, symbol) disagree
+    template<std::ranges::input_range Range>
+    explicit TransitionTable(const Range& deltaFunction)
+        : TransitionTable(Transitions(deltaFunction)) {}
+
+    /// @return The step to apply, or nullptr if the machine has no transition for (state, symbol)
+    const NextStep* find(const State& state, const TapeSymbol& symbol) const
+    {
+        const std::uint32_t stateIndex = m_states[state];
+        const std::uint32_t symbolIndex = m_symbols[symbol];
+
+        if(stateIndex == CompactIndex<State>::npos || symbolIndex == CompactIndex<TapeSymbol>::npos) {
+            return nullptr;
+        }
+
+        const Entry& entry = m_entries[indexOf(stateIndex, symbolIndex)];
+        return entry.defined ? &entry.nextStep : nullptr;
+    }
+
+    /// Calls visit(stateIndex, symbol, nextStep) for every defined transition
+    template<class Visitor>
+    void forEach(Visitor visit) const
+    {
+        for(std::uint32_t stateIndex = 0; stateIndex < m_states.size(); ++stateIndex) {
+            for(std::uint32_t symbolIndex = 0; symbolIndex < m_symbols.size(); ++symbolIndex) {
+                const Entry& entry = m_entries[indexOf(stateIndex, symbolIndex)];
+
+                if(entry.defined) {
+                    visit(stateIndex, m_symbols.key(symbolIndex), entry.nextStep);
+                }
+            }
+        }
+    }
+
+    const CompactIndex<State>& states() const { return m_states; }
+    const CompactIndex<TapeSymbol>& symbols() const { return m_symbols; }
+
+private:
+    struct Entry {
+        NextStep nextStep;
+        bool defined = false;
+    };
+
+    /// The transitions of a range, one array per field
+    struct Transitions {
+        template<class Range>
+        explicit Transitions(const Range& deltaFunction)
+        {
+            if constexpr (std::ranges::sized_range<Range>) {
+                const auto size = static_cast<std::size_t>(std::ranges::size(deltaFunction));
+                states.reserve(size);
+                symbols.reserve(size);
+                steps.reserve(size);
+            }
+
+            for(const auto& transition : deltaFunction) {
+                states.push_back(transition.stateFrom);
+                symbols.push_back(transition.symbolOriginal);
+                steps.push_back(transition.nextStep);
+            }
+        }
+
+        std::vector<State> states;
+        std::vector<TapeSymbol> symbols;
+        std::vector<NextStep> steps;
+    };
+
+    explicit TransitionTable(const Transitions& transitions)
+        : m_states(transitions.states),
+          m_symbols(transitions.symbols),
+          m_entries(m_states.size() * m_symbols.size())
+    {
+        for(std::size_t i = 0; i < transitions.steps.size(); ++i)
+        {
+            const State& state = transitions.states[i];
+            const TapeSymbol& symbol = transitions.symbols[i];
+            Entry& entry = m_entries[indexOf(m_states[state], m_symbols[symbol])];
+
+            if(entry.defined && !sameStep(entry.nextStep, transitions.steps[i])) {
+                throw std::invalid_argument(StringStream()
+                    << "Conflicting transitions for state " << state
+                    << " reading '" << symbol << "'");
+            }
+
+            entry.nextStep = transitions.steps[i];
+            entry.defined = true;
+        }
+    }
+
+    static bool sameStep(const NextStep& a, const NextStep& b)
+    {
+        return a.nextState == b.nextState && a.writeSymbol == b.writeSymbol && a.whereToMove == b.whereToMove;
+    }
+
+    std::size_t indexOf(std::uint32_t stateIndex, std::uint32_t symbolIndex) const
+    {
+        return std::size_t(stateIndex) * m_symbols.size() + symbolIndex;
+    }
+
+    CompactIndex<State> m_states;
+    CompactIndex<TapeSymbol> m_symbols;
+    std::vector<Entry> m_entries;
+};
+
+}
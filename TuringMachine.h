@@ -1,6 +1,17 @@
 #pragma once
 
+#include <span>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <ranges>
+#include <optional>
 #include "AbstractTuringMachine.h"
+#include "TransitionTable.h"
+#include "SweepRule.h"
+#include "PackedProgram.h"
+#include "LockstepProgram.h"
+#include "Fingerprint.h"
 
 namespace trmch {
 
@@ -10,9 +21,11 @@ template<
         class TapeSymbol = char,
         class Input = std::string,
         class Tape = std::string>
-class TuringMachine : public AbstractTuringMachine<State, InputSymbol, TapeSymbol, Input, Tape>
+class TuringMachine : public BasicTuringMachine<TuringMachine<State, InputSymbol, TapeSymbol, Input, Tape>,
+                                                State, InputSymbol, TapeSymbol, Input, Tape>
 {
-    using NextStep = AbstractTuringMachine<>::NextStep;
+    using Base = BasicTuringMachine<TuringMachine, State, InputSymbol, TapeSymbol, Input, Tape>;
+    using NextStep = typename Base::NextStep;
 
 public:
     struct Transition {
@@ -21,24 +34,178 @@ public:
         NextStep nextStep;
     };
 
+    /// The delta function is compiled once into a dense table, so each step costs O(1) whatever its size
+    /// The programs of runPacked() and acceptLockstep() and the fingerprint are built on their first use.
+    /// @throw std::invalid_argument If the delta function has two different transitions for the same (state, symbol)
     TuringMachine(State q0, State qA, State qR, const std::vector<Transition>& deltaFunction)
-         : AbstractTuringMachine<>(q0, qA, qR),
-           m_deltaFunction(deltaFunction) {}
+         : TuringMachine(q0, qA, qR, std::span<const Transition>(deltaFunction)) {}
 
-protected:
-    void oneStep(State currentState, TapeSymbol currentSymbol, NextStep& nextStep) const override {
+    /// Builds the table straight from any range of transitions, such as a view decoding them from a file
+    template<std::ranges::forward_range Range>
+    requires std::convertible_to<std::ranges::range_reference_t<const Range>, Transition>
+    TuringMachine(State q0, State qA, State qR, const Range& deltaFunction)
+         : Base(q0, qA, qR),
+           m_deltaFunction(deltaFunction),
+           m_sweeps(2 * m_deltaFunction.states().size()),
+           m_derived(std::make_shared<Derived>())
+    {
+        m_deltaFunction.forEach([this](std::uint32_t stateIndex, TapeSymbol symbol, const NextStep& nextStep) {
+            if(nextStep.nextState == m_deltaFunction.states().key(stateIndex) && nextStep.writeSymbol == symbol) {
+                m_sweeps[2 * stateIndex + nextStep.whereToMove].add(symbol);
+            }
+        });
+    }
 
-        for(const Transition& transition : m_deltaFunction)
-        {
-            if(transition.stateFrom == currentState && transition.symbolOriginal == currentSymbol)
-            {
-                nextStep = transition.nextStep;
+    /// Hash of the states and the compiled transitions: machines with the same delta function, whatever the order
+    /// or the duplicates of its transitions, have the same fingerprint (see ResultCache)
+    std::uint64_t fingerprint() const
+    {
+        std::call_once(m_derived->fingerprintOnce, [this] {
+            Fingerprint fingerprint;
+            fingerprint.add(this->q0()).add(this->qA()).add(this->qR()).add(this->blank());
+
+            m_deltaFunction.forEach([&](std::uint32_t stateIndex, TapeSymbol symbol, const NextStep& nextStep) {
+                fingerprint.add(m_deltaFunction.states().key(stateIndex)).add(symbol)
+                           .add(nextStep.nextState).add(nextStep.writeSymbol).add(static_cast<std::uint8_t>(nextStep.whereToMove));
+            });
+
+            m_derived->fingerprint = fingerprint.value();
+        });
+
+        return m_derived->fingerprint;
+    }
+
+    /// The transitions of the compiled table, without duplicates, ordered by state then by symbol
+    std::vector<Transition> deltaFunction() const
+    {
+        std::vector<Transition> transitions;
+
+        m_deltaFunction.forEach([&](std::uint32_t stateIndex, TapeSymbol symbol, const NextStep& nextStep) {
+            transitions.push_back({m_deltaFunction.states().key(stateIndex), symbol, nextStep});
+        });
+
+        return transitions;
+    }
+
+    /// Runs like run() on a tape packed at 1, 2 or 4 bits per cell, for machines with at most 15 tape symbols
+    /// The symbols are replaced by dense codes (see TapeAlphabet), so a binary machine uses an eighth of the memory
+    /// of run() and scans its sweeps a word of cells at a time. Falls back to run() if the alphabet is too large
+    /// or if loops must be detected.
+    /// @param tapeBytes Receives the bytes allocated for the tape, if the packed tape was used
+    [[nodiscard]] RunResult runPacked(const Input& input, const RunLimits& limits, Tape* finalTape = nullptr,
+                                      std::size_t* tapeBytes = nullptr) const
+    {
+        if(!limits.detectLoops) {
+            if(const auto result = packed().run(input, limits, finalTape, tapeBytes)) {
+                return *result;
             }
         }
+
+        return this->run(input, limits, finalTape);
+    }
+
+    /// Runs every input like acceptBatch(), 16 inputs at a time in lockstep on each worker (see LockstepProgram)
+    /// Faster on many short runs, whose steps are then interleaved instead of stalling one after another on their
+    /// table lookups. Inputs whose head leaves their window go through run(). Falls back to acceptBatch() if the
+    /// table doesn't fit or if loops must be detected.
+    [[nodiscard]] std::vector<RunResult> acceptLockstep(std::span<const Input> inputs, const BatchOptions& options = {}) const
+    {
+        if(options.limits.detectLoops || !lockstep().available()) {
+            return this->acceptBatch(inputs, options);
+        }
+
+        const LockstepProgram<State, TapeSymbol>& program = lockstep();
+
+        assert(options.maxSteps.empty() || options.maxSteps.size() == inputs.size());
+
+        std::vector<RunResult> results(inputs.size());
+
+        std::optional<ThreadPool> ownPool;
+        ThreadPool* pool = options.pool;
+
+        if(!pool) {
+            pool = &ownPool.emplace(options.threads);
+        }
+
+        /* Chunks of several rounds of lanes, and enough of them to balance the workers */
+        const std::size_t chunk = std::max<std::size_t>(LockstepProgram<State, TapeSymbol>::lanes * 8, inputs.size() / (pool->size() * 16));
+        const std::size_t chunks = (inputs.size() + chunk - 1) / chunk;
+
+        pool->parallelFor(chunks, [&](std::size_t c) {
+            const std::size_t begin = c * chunk;
+            const std::size_t count = std::min(chunk, inputs.size() - begin);
+            const auto maxSteps = options.maxSteps.empty() ? options.maxSteps : options.maxSteps.subspan(begin, count);
+
+            program.run(inputs.subspan(begin, count), options.limits, maxSteps, std::span(results).subspan(begin, count),
+                           [&](std::size_t i) {
+                               RunLimits limits = options.limits;
+
+                               if(!maxSteps.empty()) {
+                                   limits.maxSteps = maxSteps[i];
+                               }
+
+                               return this->run(inputs[begin + i], limits);
+                           });
+        }, 1);
+
+        return results;
+    }
+
+    /// Symbols over which currentState sweeps toward direction, found ahead of time in the delta function
+    /// @return nullptr if the state has no such self-loop
+    const SweepRule<TapeSymbol>* sweepRule(State currentState, Move direction) const
+    {
+        const std::uint32_t stateIndex = m_deltaFunction.states()[currentState];
+
+        if(stateIndex == CompactIndex<State>::npos || m_sweeps[2 * stateIndex + direction].empty()) {
+            return nullptr;
+        }
+
+        return &m_sweeps[2 * stateIndex + direction];
+    }
+
+protected:
+    void oneStep(State currentState, TapeSymbol currentSymbol, NextStep& nextStep) const
+    {
+        if(const NextStep* found = m_deltaFunction.find(currentState, currentSymbol))
+        {
+            nextStep = *found;
+        }
     }
 
 private:
-    std::vector<Transition> m_deltaFunction;
+    /// Built from the delta function on first use, once even if several threads run the machine
+    /// Shared by the copies of the machine, which have the same delta function.
+    struct Derived {
+        std::once_flag packedOnce;
+        std::once_flag lockstepOnce;
+        std::once_flag fingerprintOnce;
+        std::optional<PackedProgram<State, TapeSymbol>> packed;
+        std::optional<LockstepProgram<State, TapeSymbol>> lockstep;
+        std::uint64_t fingerprint = 0;
+    };
+
+    const PackedProgram<State, TapeSymbol>& packed() const
+    {
+        std::call_once(m_derived->packedOnce, [this] {
+            m_derived->packed.emplace(m_deltaFunction, this->q0(), this->qA(), this->qR(), this->blank());
+        });
+
+        return *m_derived->packed;
+    }
+
+    const LockstepProgram<State, TapeSymbol>& lockstep() const
+    {
+        std::call_once(m_derived->lockstepOnce, [this] {
+            m_derived->lockstep.emplace(m_deltaFunction, this->q0(), this->qA(), this->qR(), this->blank());
+        });
+
+        return *m_derived->lockstep;
+    }
+
+    TransitionTable<State, TapeSymbol, NextStep> m_deltaFunction;
+    std::vector<SweepRule<TapeSymbol>> m_sweeps; ///< Indexed by 2 * state index + direction
+    std::shared_ptr<Derived> m_derived;
 };
 
-}
\ No newline at end of file
+}
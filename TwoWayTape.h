@@ -0,0 +1,170 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+namespace trmch {
+
+/// Tape infinite in both directions, position 0 being the first cell of the input
+/// Cells are stored contiguously and pre-filled with the blank symbol. When the head leaves the allocated
+/// cells the storage is doubled toward that side, so a run touching n cells reallocates O(log n) times.
+/// The storage is kept by assign(): a tape reused for the next run only allocates once it outgrows every previous one.
+template<class TapeSymbol>
+class TwoWayTape
+{
+public:
+    explicit TwoWayTape(TapeSymbol blank)
+        : m_blank(blank) {}
+
+    /// Resets the tape to the input, with some blank margin on both sides
+    template<class InputIt>
+    void assign(InputIt first, InputIt last)
+    {
+        const std::size_t inputSize = static_cast<std::size_t>(std::distance(first, last));
+        const std::size_t margin = std::max<std::size_t>(inputSize / 2, minimumMargin);
+
+        m_cells.assign(margin + inputSize + margin, m_blank);
+        std::copy(first, last, m_cells.begin() + static_cast<std::ptrdiff_t>(margin));
+
+        m_origin = static_cast<std::ptrdiff_t>(margin);
+        m_inputSize = inputSize;
+    }
+
+    /// Resets the tape to blank cells covering [first, last), the input having been inputSize cells from position 0
+    void assignBlank(std::ptrdiff_t first, std::ptrdiff_t last, std::size_t inputSize)
+    {
+        first = std::min<std::ptrdiff_t>(first, 0);
+        last = std::max(last, static_cast<std::ptrdiff_t>(inputSize));
+
+        m_cells.assign(minimumMargin + static_cast<std::size_t>(last - first) + minimumMargin, m_blank);
+        m_origin = static_cast<std::ptrdiff_t>(minimumMargin) - first;
+        m_inputSize = inputSize;
+    }
+
+    /// Resets the tape to the cells of other.contents(), reusing the storage of this tape
+    void assignContents(const TwoWayTape& other)
+    {
+        const auto [begin, end] = other.contentBounds();
+
+        m_cells.assign(begin, end);
+        m_origin = static_cast<std::ptrdiff_t>((other.m_cells.begin() + other.m_origin) - begin);
+        m_inputSize = other.m_inputSize;
+        m_blank = other.m_blank;
+    }
+
+    /// Grows the storage so that position is allocated
+    void reserve(std::ptrdiff_t position)
+    {
+        if(position < first()) {
+            const std::size_t missing = static_cast<std::size_t>(first() - position);
+            grow(std::max(missing, m_cells.size()), 0);
+        }
+        else if(position >= last()) {
+            const std::size_t missing = static_cast<std::size_t>(position - last() + 1);
+            grow(0, std::max(missing, m_cells.size()));
+        }
+    }
+
+    /// First allocated position, may be negative
+    std::ptrdiff_t first() const { return -m_origin; }
+
+    /// One past the last allocated position
+    std::ptrdiff_t last() const { return static_cast<std::ptrdiff_t>(m_cells.size()) - m_origin; }
+
+    /// Offset of position 0 in data()
+    std::ptrdiff_t origin() const { return m_origin; }
+
+    TapeSymbol* data() { return m_cells.data(); }
+    const TapeSymbol* data() const { return m_cells.data(); }
+    std::size_t capacity() const { return m_cells.size(); }
+
+    TapeSymbol& operator[](std::ptrdiff_t position) { return m_cells[static_cast<std::size_t>(m_origin + position)]; }
+    const TapeSymbol& operator[](std::ptrdiff_t position) const { return m_cells[static_cast<std::size_t>(m_origin + position)]; }
+
+    TapeSymbol blank() const { return m_blank; }
+    std::size_t inputSize() const { return m_inputSize; }
+
+    /// Cells from the first to the last non-blank one, always including the cells of the input
+    template<class Tape>
+    Tape contents() const
+    {
+        const auto [begin, end] = contentBounds();
+        return Tape(begin, end);
+    }
+
+    /// Sets tape to contents(), reusing its storage when Tape can assign a range like std::string and std::vector
+    template<class Tape>
+    void contentsInto(Tape& tape) const
+    {
+        /* As pointers, which std::string assigns without a temporary string */
+        const auto [first, last] = contentBounds();
+        const TapeSymbol* begin = std::to_address(first);
+        const TapeSymbol* end = std::to_address(last);
+
+        if constexpr (requires { tape.assign(begin, end); }) {
+            tape.assign(begin, end);
+        } else {
+            tape = Tape(begin, end);
+        }
+    }
+
+    /// The cells of contents(), without copying them: valid until the tape is modified
+    std::span<const TapeSymbol> view() const
+    {
+        const auto [begin, end] = contentBounds();
+        return {begin, end};
+    }
+
+private:
+    static constexpr std::size_t minimumMargin = 64;
+
+    std::pair<typename std::vector<TapeSymbol>::const_iterator, typename std::vector<TapeSymbol>::const_iterator> contentBounds() const
+    {
+        const auto isBlank = [this](const TapeSymbol& symbol) { return symbol == m_blank; };
+
+        auto begin = std::find_if_not(m_cells.begin(), m_cells.end(), isBlank);
+        auto end = std::find_if_not(m_cells.rbegin(), m_cells.rend(), isBlank).base();
+
+        const auto inputBegin = m_cells.begin() + m_origin;
+        const auto inputEnd = inputBegin + static_cast<std::ptrdiff_t>(m_inputSize);
+
+        if(begin == m_cells.end()) {
+            begin = end = inputBegin;
+        }
+
+        return {std::min(begin, inputBegin), std::max(end, inputEnd)};
+    }
+
+    void grow(std::size_t left, std::size_t right)
+    {
+        const std::size_t size = m_cells.size();
+
+        /* In the storage left by a previous, larger run if possible */
+        if(m_cells.capacity() >= left + size + right) {
+            m_cells.resize(left + size + right, m_blank);
+            std::move_backward(m_cells.begin(), m_cells.begin() + static_cast<std::ptrdiff_t>(size),
+                               m_cells.begin() + static_cast<std::ptrdiff_t>(left + size));
+            std::fill_n(m_cells.begin(), left, m_blank);
+
+            m_origin += static_cast<std::ptrdiff_t>(left);
+            return;
+        }
+
+        std::vector<TapeSymbol> cells(left + m_cells.size() + right, m_blank);
+        std::copy(m_cells.begin(), m_cells.end(), cells.begin() + static_cast<std::ptrdiff_t>(left));
+
+        m_cells = std::move(cells);
+        m_origin += static_cast<std::ptrdiff_t>(left);
+    }
+
+    std::vector<TapeSymbol> m_cells;
+    std::ptrdiff_t m_origin = 0;
+    std::size_t m_inputSize = 0;
+    TapeSymbol m_blank;
+};
+
+}
@@ -0,0 +1,14 @@
+#include "CodeGenerator.h"
+#include "Machines.h"
+
+int main(int argc, char** argv)
+{
+    return trmch::InterpreterGenerator("BenchMachines", "generated")
+        .add("busyBeaver4", bench::busyBeaver4())
+        .add("busyBeaver5", bench::busyBeaver5())
+        .add("binaryIncrement", bench::binaryIncrement())
+        .add("unaryAddition", bench::unaryAddition())
+        .add("palindrome", bench::palindrome())
+        .add("zerosThenOnes", bench::zerosThenOnes())
+        .main(argc, argv);
+}
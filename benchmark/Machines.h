@@ -0,0 +1,178 @@
+#pragma once
+
+#include "TuringMachine.h"
+#include "StaticTuringMachine.h"
+
+/// Reference machines of the benchmark
+namespace bench {
+
+using trmch::LEFT;
+using trmch::RIGHT;
+
+/// 4-state busy beaver champion: halts after 107 steps with 13 ones on the tape, ' ' standing for 0
+inline trmch::TuringMachine<> busyBeaver4()
+{
+    return {0, 4, -1, {
+        {0, ' ', 1, '1', RIGHT},
+        {0, '1', 1, '1', LEFT},
+        {1, ' ', 0, '1', LEFT},
+        {1, '1', 2, ' ', LEFT},
+        {2, ' ', 4, '1', RIGHT},
+        {2, '1', 3, '1', LEFT},
+        {3, ' ', 3, '1', RIGHT},
+        {3, '1', 0, ' ', RIGHT},
+    }};
+}
+
+/// 5-state busy beaver champion (Marxen and Buntrock): halts after 47,176,870 steps with 4098 ones on the tape
+inline trmch::TuringMachine<> busyBeaver5()
+{
+    return {0, 5, -1, {
+        {0, ' ', 1, '1', RIGHT},
+        {0, '1', 2, '1', LEFT},
+        {1, ' ', 2, '1', RIGHT},
+        {1, '1', 1, '1', RIGHT},
+        {2, ' ', 3, '1', RIGHT},
+        {2, '1', 4, ' ', LEFT},
+        {3, ' ', 0, '1', LEFT},
+        {3, '1', 3, '1', LEFT},
+        {4, ' ', 5, '1', RIGHT},
+        {4, '1', 0, ' ', LEFT},
+    }};
+}
+
+/// Adds one to a binary number, most significant bit first
+inline trmch::TuringMachine<> binaryIncrement()
+{
+    return {0, 10, -1, {
+        {0, '0', 0, '0', RIGHT},
+        {0, '1', 0, '1', RIGHT},
+        {0, ' ', 1, ' ', LEFT},
+        {1, '1', 1, '0', LEFT},
+        {1, '0', 2, '1', LEFT},
+        {1, ' ', 10, '1', RIGHT},
+        {2, '0', 2, '0', LEFT},
+        {2, '1', 2, '1', LEFT},
+        {2, ' ', 10, ' ', RIGHT},
+    }};
+}
+
+/// Turns 1^a+1^b into 1^(a+b)
+inline trmch::TuringMachine<> unaryAddition()
+{
+    return {0, 10, -1, {
+        {0, '1', 0, '1', RIGHT},
+        {0, '+', 1, '1', RIGHT},
+        {1, '1', 1, '1', RIGHT},
+        {1, ' ', 2, ' ', LEFT},
+        {2, '1', 10, ' ', LEFT},
+    }};
+}
+
+/// Accepts the palindromes over {a, b} by erasing the outermost symbols at each pass
+inline trmch::TuringMachine<> palindrome()
+{
+    return {0, 10, -1, {
+        {0, 'a', 1, ' ', RIGHT},
+        {0, 'b', 2, ' ', RIGHT},
+        {0, ' ', 10, ' ', RIGHT},
+        {1, 'a', 1, 'a', RIGHT},
+        {1, 'b', 1, 'b', RIGHT},
+        {1, ' ', 3, ' ', LEFT},
+        {2, 'a', 2, 'a', RIGHT},
+        {2, 'b', 2, 'b', RIGHT},
+        {2, ' ', 4, ' ', LEFT},
+        {3, 'a', 5, ' ', LEFT},
+        {3, ' ', 10, ' ', RIGHT},
+        {4, 'b', 5, ' ', LEFT},
+        {4, ' ', 10, ' ', RIGHT},
+        {5, 'a', 5, 'a', LEFT},
+        {5, 'b', 5, 'b', LEFT},
+        {5, ' ', 0, ' ', RIGHT},
+    }};
+}
+
+/// Accepts { 0^n1^n | n > 0 }, same transitions as AnBn
+inline trmch::TuringMachine<> zerosThenOnes()
+{
+    return {0, 4, -1, {
+        {0, '0', 1, 'X', RIGHT},
+        {0, 'Y', 3, 'Y', RIGHT},
+        {1, '0', 1, '0', RIGHT},
+        {1, 'Y', 1, 'Y', RIGHT},
+        {1, '1', 2, 'Y', LEFT},
+        {2, '0', 2, '0', LEFT},
+        {2, 'Y', 2, 'Y', LEFT},
+        {2, 'X', 0, 'X', RIGHT},
+        {3, 'Y', 3, 'Y', RIGHT},
+        {3, ' ', 4, ' ', RIGHT},
+    }};
+}
+
+/// Accept { 0^n1^n | n > 0 }
+/// Marks the first 0 with X and the first 1 with Y at each pass, then checks that only Ys remain.
+class AnBn : public trmch::BasicTuringMachine<AnBn>
+{
+public:
+    AnBn() : BasicTuringMachine(0, 4, -1) {}
+
+protected:
+    void oneStep(int currentState, char currentSymbol, NextStep &nextStep) const
+    {
+        switch(currentState)
+        {
+            case 0: /* Mark the leftmost 0, or check the Ys once they are all marked */
+                if(currentSymbol == '0') {
+                    nextStep = {1, 'X', RIGHT};
+                }
+                else if(currentSymbol == 'Y') {
+                    nextStep = {3, 'Y', RIGHT};
+                }
+                break;
+
+            case 1: /* Find the leftmost 1 */
+                if(currentSymbol == '0' || currentSymbol == 'Y') {
+                    nextStep = {1, currentSymbol, RIGHT};
+                }
+                else if(currentSymbol == '1') {
+                    nextStep = {2, 'Y', LEFT};
+                }
+                break;
+
+            case 2: /* Go back to the last X */
+                if(currentSymbol == '0' || currentSymbol == 'Y') {
+                    nextStep = {2, currentSymbol, LEFT};
+                }
+                else if(currentSymbol == 'X') {
+                    nextStep = {0, 'X', RIGHT};
+                }
+                break;
+
+            case 3: /* Only Ys may remain */
+                if(currentSymbol == 'Y') {
+                    nextStep = {3, 'Y', RIGHT};
+                }
+                else if(currentSymbol == ' ') {
+                    nextStep = {4, ' ', RIGHT};
+                }
+                break;
+        }
+    }
+};
+
+/// Accept { 0^n1^n | n > 0 }, same transitions as AnBn in a table built at compile time
+using StaticZerosThenOnes = trmch::StaticTuringMachine<
+    4, -1, 0,
+    trmch::MetaTransition<0, '0', 1, 'X', RIGHT>,
+    trmch::MetaTransition<0, 'Y', 3, 'Y', RIGHT>,
+    trmch::MetaTransition<1, '0', 1, '0', RIGHT>,
+    trmch::MetaTransition<1, 'Y', 1, 'Y', RIGHT>,
+    trmch::MetaTransition<1, '1', 2, 'Y', LEFT>,
+    trmch::MetaTransition<2, '0', 2, '0', LEFT>,
+    trmch::MetaTransition<2, 'Y', 2, 'Y', LEFT>,
+    trmch::MetaTransition<2, 'X', 0, 'X', RIGHT>,
+    trmch::MetaTransition<3, 'Y', 3, 'Y', RIGHT>,
+    trmch::MetaTransition<3, ' ', 4, ' ', RIGHT>
+>;
+
+}
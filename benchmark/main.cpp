@@ -0,0 +1,278 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <functional>
+#include "AbstractTuringMachine.h"
+#include "Machines.h"
+#include "BenchMachines.h"
+
+/// Measures each engine on the reference machines of Machines.h across input sizes
+///
+/// Usage: CppTM_Bench [--json <file>] [--min-time <seconds>] [--filter <machine>]
+///
+/// Each case is run again until min-time has elapsed, and reported as steps per second, nanoseconds per step and
+/// peak tape memory (the final capacity of the tape, which only grows). The generated interpreters don't expose
+/// their tape, so their peak memory is not reported.
+namespace {
+
+using namespace trmch;
+
+/// Runs one input, setting peakTape to the bytes of tape allocated if the engine can tell
+using Engine = std::function<RunResult(const std::string& input, std::optional<std::size_t>& peakTape)>;
+
+struct Benchmark {
+    std::string machine;
+    std::vector<std::size_t> sizes;
+    std::function<std::string(std::size_t)> input;
+    std::vector<std::pair<std::string, Engine>> engines;
+};
+
+struct Measurement {
+    std::string machine;
+    std::string engine;
+    std::size_t inputSize;
+    std::size_t steps;      ///< Of one run
+    std::size_t runs;
+    double seconds;         ///< Of all the runs
+    std::optional<std::size_t> peakTape;
+    Verdict verdict;
+
+    double stepsPerSecond() const { return double(steps) * double(runs) / seconds; }
+    double nsPerStep() const { return seconds * 1e9 / (double(steps) * double(runs)); }
+};
+
+struct Options {
+    double minTime = 0.2;
+    std::string json;
+    std::string filter;
+};
+
+template<class Machine>
+Engine interpreted(const Machine& machine)
+{
+    return [&machine](const std::string& input, std::optional<std::size_t>& peakTape) {
+        auto configuration = machine.start(input);
+        const RunResult result = machine.resume(configuration, {});
+        peakTape = configuration.tape.capacity() * sizeof(typename Machine::TapeSymbolType);
+        return result;
+    };
+}
+
+/// TuringMachine::runPacked(), on a tape of 1, 2 or 4 bits per cell
+Engine packed(const TuringMachine<>& machine)
+{
+    return [&machine](const std::string& input, std::optional<std::size_t>& peakTape) {
+        std::size_t bytes = 0;
+        const RunResult result = machine.runPacked(input, {}, nullptr, &bytes);
+        peakTape = bytes;
+        return result;
+    };
+}
+
+Engine compiled(RunResult (*function)(std::string_view, const RunLimits&, std::string*))
+{
+    return [function](const std::string& input, std::optional<std::size_t>&) {
+        return function(input, {}, nullptr);
+    };
+}
+
+Measurement measure(const Benchmark& benchmark, const std::string& engineName, const Engine& engine,
+                    std::size_t size, double minTime)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const std::string input = benchmark.input(size);
+    Measurement measurement{benchmark.machine, engineName, size, 0, 0, 0.0, std::nullopt, Verdict::Rejected};
+
+    const Clock::time_point begin = Clock::now();
+
+    do {
+        const RunResult result = engine(input, measurement.peakTape);
+        measurement.steps = result.steps;
+        measurement.verdict = result.verdict;
+        ++measurement.runs;
+        measurement.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    } while(measurement.seconds < minTime);
+
+    return measurement;
+}
+
+void writeJson(std::ostream& out, const std::vector<Measurement>& measurements)
+{
+    out.precision(10);
+    out << "{\n  \"benchmarks\": [\n";
+
+    for(std::size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+
+        out << "    {\"machine\": \"" << m.machine << "\", \"engine\": \"" << m.engine << "\""
+            << ", \"inputSize\": " << m.inputSize
+            << ", \"steps\": " << m.steps
+            << ", \"runs\": " << m.runs
+            << ", \"seconds\": " << m.seconds
+            << ", \"stepsPerSecond\": " << m.stepsPerSecond()
+            << ", \"nsPerStep\": " << m.nsPerStep()
+            << ", \"peakTapeBytes\": ";
+
+        if(m.peakTape) {
+            out << *m.peakTape;
+        } else {
+            out << "null";
+        }
+
+        out << ", \"verdict\": \"" << toString(m.verdict) << "\"}" << (i + 1 < measurements.size() ? "," : "") << "\n";
+    }
+
+    out << "  ]\n}\n";
+}
+
+std::optional<Options> parse(int argc, char** argv)
+{
+    Options options;
+
+    for(int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+
+        if(i + 1 == argc) {
+            return std::nullopt;
+        }
+
+        if(argument == "--json") {
+            options.json = argv[++i];
+        } else if(argument == "--min-time") {
+            options.minTime = std::stod(argv[++i]);
+        } else if(argument == "--filter") {
+            options.filter = argv[++i];
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const std::optional<Options> options = parse(argc, argv);
+
+    if(!options) {
+        std::cerr << "Usage: " << argv[0] << " [--json <file>] [--min-time <seconds>] [--filter <machine>]" << std::endl;
+        return 1;
+    }
+
+    const auto busyBeaver4 = bench::busyBeaver4();
+    const auto busyBeaver5 = bench::busyBeaver5();
+    const auto binaryIncrement = bench::binaryIncrement();
+    const auto unaryAddition = bench::unaryAddition();
+    const auto palindrome = bench::palindrome();
+    const auto zerosThenOnes = bench::zerosThenOnes();
+    const bench::AnBn anbn;
+    const bench::StaticZerosThenOnes staticZerosThenOnes;
+
+    const VirtualTuringMachine virtualBusyBeaver4(busyBeaver4);
+    const VirtualTuringMachine virtualBusyBeaver5(busyBeaver5);
+    const VirtualTuringMachine virtualBinaryIncrement(binaryIncrement);
+    const VirtualTuringMachine virtualUnaryAddition(unaryAddition);
+    const VirtualTuringMachine virtualPalindrome(palindrome);
+    const VirtualTuringMachine virtualZerosThenOnes(zerosThenOnes);
+
+    const std::vector<Benchmark> benchmarks{
+        {"busyBeaver4", {0}, [](std::size_t) { return std::string(); }, {
+            {"table", interpreted(busyBeaver4)},
+            {"packed", packed(busyBeaver4)},
+            {"virtual", interpreted(virtualBusyBeaver4)},
+            {"generated", compiled(generated::busyBeaver4)},
+        }},
+        {"busyBeaver5", {0}, [](std::size_t) { return std::string(); }, {
+            {"table", interpreted(busyBeaver5)},
+            {"packed", packed(busyBeaver5)},
+            {"virtual", interpreted(virtualBusyBeaver5)},
+            {"generated", compiled(generated::busyBeaver5)},
+        }},
+        {"binaryIncrement", {1 << 10, 1 << 16, 1 << 20}, [](std::size_t n) { return std::string(n, '1'); }, {
+            {"table", interpreted(binaryIncrement)},
+            {"packed", packed(binaryIncrement)},
+            {"virtual", interpreted(virtualBinaryIncrement)},
+            {"generated", compiled(generated::binaryIncrement)},
+        }},
+        {"unaryAddition", {1 << 10, 1 << 16, 1 << 20}, [](std::size_t n) {
+            return std::string(n / 2, '1') + "+" + std::string(n / 2, '1');
+        }, {
+            {"table", interpreted(unaryAddition)},
+            {"packed", packed(unaryAddition)},
+            {"virtual", interpreted(virtualUnaryAddition)},
+            {"generated", compiled(generated::unaryAddition)},
+        }},
+        {"palindrome", {1 << 8, 1 << 10, 1 << 12}, [](std::size_t n) {
+            std::string half;
+
+            for(std::size_t i = 0; i < n / 2; ++i) {
+                half += (i * 7 % 3) ? 'a' : 'b';
+            }
+
+            return half + std::string(half.rbegin(), half.rend());
+        }, {
+            {"table", interpreted(palindrome)},
+            {"packed", packed(palindrome)},
+            {"virtual", interpreted(virtualPalindrome)},
+            {"generated", compiled(generated::palindrome)},
+        }},
+        {"zerosThenOnes", {1 << 8, 1 << 10, 1 << 12}, [](std::size_t n) {
+            return std::string(n / 2, '0') + std::string(n / 2, '1');
+        }, {
+            {"table", interpreted(zerosThenOnes)},
+            {"packed", packed(zerosThenOnes)},
+            {"virtual", interpreted(virtualZerosThenOnes)},
+            {"generated", compiled(generated::zerosThenOnes)},
+            {"switch", interpreted(anbn)},
+            {"static", interpreted(staticZerosThenOnes)},
+        }},
+    };
+
+    std::vector<Measurement> measurements;
+    bool failed = false;
+
+    std::printf("%-16s %-10s %9s %12s %8s %14s %10s %12s\n",
+                "machine", "engine", "input", "steps", "runs", "steps/s", "ns/step", "peak tape");
+
+    for(const Benchmark& benchmark : benchmarks) {
+        if(benchmark.machine.find(options->filter) == std::string::npos) {
+            continue;
+        }
+
+        for(std::size_t size : benchmark.sizes) {
+            for(const auto& [engineName, engine] : benchmark.engines) {
+                const Measurement m = measure(benchmark, engineName, engine, size, options->minTime);
+
+                std::printf("%-16s %-10s %9zu %12zu %8zu %14.4g %10.3f %12s\n",
+                            m.machine.c_str(), m.engine.c_str(), m.inputSize, m.steps, m.runs,
+                            m.stepsPerSecond(), m.nsPerStep(),
+                            m.peakTape ? std::to_string(*m.peakTape).c_str() : "-");
+
+                /* Every reference input is accepted */
+                if(m.verdict != Verdict::Accepted) {
+                    std::fprintf(stderr, "%s rejected its input with the %s engine\n", m.machine.c_str(), m.engine.c_str());
+                    failed = true;
+                }
+
+                measurements.push_back(m);
+            }
+        }
+    }
+
+    if(!options->json.empty()) {
+        std::ofstream out(options->json);
+        writeJson(out, measurements);
+
+        if(!out) {
+            std::cerr << "Cannot write " << options->json << std::endl;
+            return 1;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
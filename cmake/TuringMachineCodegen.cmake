@@ -0,0 +1,28 @@
+# trmch_add_generated_machine(<target> GENERATOR <source> NAME <name>)
+#
+# Builds the generator program <source>, which writes <name>.h and <name>.cpp with trmch::InterpreterGenerator
+# in the directory given as its first argument, runs it at build time and compiles the generated interpreters
+# into the static library <target>. Include "<name>.h" after linking <target>.
+function(trmch_add_generated_machine target)
+    cmake_parse_arguments(ARG "" "GENERATOR;NAME" "" ${ARGN})
+
+    if(NOT ARG_GENERATOR OR NOT ARG_NAME)
+        message(FATAL_ERROR "trmch_add_generated_machine: GENERATOR and NAME are required")
+    endif()
+
+    set(generator ${target}_Generator)
+    set(directory ${CMAKE_CURRENT_BINARY_DIR}/${target})
+
+    add_executable(${generator} ${ARG_GENERATOR})
+    target_include_directories(${generator} PRIVATE ${PROJECT_SOURCE_DIR})
+    target_link_libraries(${generator} PRIVATE Threads::Threads)
+
+    add_custom_command(
+            OUTPUT ${directory}/${ARG_NAME}.h ${directory}/${ARG_NAME}.cpp
+            COMMAND ${generator} ${directory}
+            DEPENDS ${generator}
+            COMMENT "Generating the ${ARG_NAME} interpreters")
+
+    add_library(${target} STATIC ${directory}/${ARG_NAME}.cpp ${directory}/${ARG_NAME}.h)
+    target_include_directories(${target} PUBLIC ${directory} ${PROJECT_SOURCE_DIR})
+endfunction()
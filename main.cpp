@@ -1,39 +1,13 @@
 #include "TuringMachine.h"
+#include "benchmark/Machines.h"
 
-/// Accept { 0^n1^n | n > 0 }
-class AnBn : public trmch::AbstractTuringMachine<>
+class Test : public trmch::BasicTuringMachine<Test>
 {
 public:
-    AnBn() : AbstractTuringMachine(0, 4, -1) {}
+    Test() : BasicTuringMachine(0, 5, -1) {}
 
 protected:
-    void oneStep(int currentState, char currentSymbol, NextStep &nextStep) const override
-    {
-        switch(currentState)
-        {
-            case 0:
-                break;
-
-            case 1:
-                break;
-
-            case 2:
-                break;
-
-            case 3:
-
-                break;
-        }
-    }
-};
-
-class Test : public trmch::AbstractTuringMachine<>
-{
-public:
-    Test() : AbstractTuringMachine(0, 5, -1) {}
-
-protected:
-    void oneStep(int currentState, char currentSymbol, NextStep &nextStep) const override
+    void oneStep(int currentState, char /* currentSymbol */, NextStep &nextStep) const
     {
         nextStep.nextState = currentState + 1;
         nextStep.whereToMove = trmch::RIGHT;
@@ -51,5 +25,9 @@ int main()
 
     m.debug("a");
 
+    bench::AnBn anbn;
+    anbn.debug("000111");
+    anbn.debug("00111");
+
     return 0;
 }
@@ -0,0 +1,48 @@
+#include <catch2/catch.hpp>
+
+#include "benchmark/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("Benchmark reference machines") {
+
+    SECTION("The 4-state busy beaver halts after 107 steps with 13 ones") {
+
+        string finalTape;
+        const RunResult result = bench::busyBeaver4().run("", {}, &finalTape);
+
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.steps == 107);
+        REQUIRE(count(finalTape.begin(), finalTape.end(), '1') == 13);
+    }
+
+    SECTION("AnBn and its transition table agree") {
+
+        const bench::AnBn anbn;
+        const auto zerosThenOnes = bench::zerosThenOnes();
+
+        for(const string input : {"", "0", "1", "01", "10", "0011", "0101", "000111", "00111", "0001111", "000111000"}) {
+            const RunResult expected = zerosThenOnes.run(input, {});
+            const RunResult result = anbn.run(input, {});
+
+            REQUIRE(result.verdict == expected.verdict);
+            REQUIRE(result.steps == expected.steps);
+        }
+
+        REQUIRE(anbn.accept("000111"));
+        REQUIRE(anbn.reject("00111"));
+    }
+
+    SECTION("Unary addition and palindromes") {
+
+        string finalTape;
+        REQUIRE(bench::unaryAddition().accept("111+11", &finalTape));
+        REQUIRE(finalTape == "11111 ");
+
+        const auto palindrome = bench::palindrome();
+        REQUIRE(palindrome.accept("abba"));
+        REQUIRE(palindrome.accept("aba"));
+        REQUIRE(palindrome.reject("abab"));
+    }
+}
@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+
+#include "BusyBeaver.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("BusyBeaver") {
+
+    ThreadPool pool(4);
+
+    SECTION("The 2-state and 3-state busy beavers are found") {
+
+        BusyBeaverOptions options;
+        options.pool = &pool;
+
+        options.states = 2;
+        const BusyBeaverResult two = BusyBeaverSearch(options).run();
+        REQUIRE(two.maxSteps == 6);
+        REQUIRE(two.maxOnes == 4);
+        REQUIRE(two.holdouts == 0);
+        REQUIRE(two.machines == two.halting + two.nonHalting);
+
+        options.states = 3;
+        const BusyBeaverResult three = BusyBeaverSearch(options).run();
+        REQUIRE(three.maxSteps == 21);
+        REQUIRE(three.maxOnes == 6);
+
+        /* Champions run the same on the runtime engine */
+        for(const EnumeratedMachine& champion : three.stepsChampions) {
+            string finalTape;
+            const RunResult result = champion.toTuringMachine().run("", {}, &finalTape);
+            REQUIRE(result.verdict == Verdict::Accepted);
+            REQUIRE(result.steps == 21);
+        }
+    }
+
+    SECTION("Machines with more symbols") {
+
+        BusyBeaverOptions options;
+        options.pool = &pool;
+        options.states = 2;
+        options.symbols = 3;
+
+        const BusyBeaverResult result = BusyBeaverSearch(options).run();
+        REQUIRE(result.maxSteps == 38);
+        REQUIRE(result.maxOnes == 9);
+    }
+
+    SECTION("Machines are written in the standard text form") {
+
+        EnumeratedMachine machine(2, 2);
+        machine(0, 0) = {1, 1, 1};
+        machine(0, 1) = {1, -1, 1};
+        machine(1, 0) = {1, -1, 0};
+        machine(1, 1) = {1, 1, EnumeratedMachine::halt};
+
+        REQUIRE(machine.toString() == "1RB1LB_1LA1RZ");
+        REQUIRE(machine.toTuringMachine().run("", {}).steps == 6);
+        REQUIRE_THROWS_AS(EnumeratedMachine(9, 2), invalid_argument);
+    }
+}
@@ -0,0 +1,170 @@
+#include <catch2/catch.hpp>
+
+#include "TuringMachine.h"
+#include "Checkpoint.h"
+#include "testing/TemporaryPath.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("Checkpoint and resume") {
+
+    const filesystem::path file = temporaryPath("checkpoint.bin");
+
+    /// Binary counter, least significant bit first
+    TuringMachine<> counter(0, 5, -1, {
+        {0, '1', 0, '0', RIGHT},
+        {0, '0', 1, '1', LEFT},
+        {0, ' ', 1, '1', LEFT},
+        {1, '0', 1, '0', LEFT},
+        {1, '1', 1, '1', LEFT},
+        {1, ' ', 0, ' ', RIGHT},
+    });
+
+    RunLimits limits;
+    limits.maxSteps = 50000;
+
+    string expectedTape;
+    const RunResult expected = counter.run("0", limits, &expectedTape);
+
+    SECTION("A paused run resumes from its saved configuration") {
+
+        auto configuration = counter.start("0");
+
+        limits.maxSteps = 20000;
+        REQUIRE(counter.resume(configuration, limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(configuration.steps == 20000);
+
+        saveConfiguration(file, configuration);
+        auto loaded = loadConfiguration<int, char>(file);
+
+        limits.maxSteps = 50000;
+        string finalTape;
+        const RunResult result = counter.resume(loaded, limits, &finalTape);
+
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == expected.steps);
+        REQUIRE(result.head == expected.head);
+        REQUIRE(finalTape == expectedTape);
+    }
+
+    SECTION("A run resumed past its budget stops at once") {
+
+        auto configuration = counter.start("0");
+
+        limits.maxSteps = 100;
+        REQUIRE(counter.resume(configuration, limits).verdict == Verdict::OutOfFuel);
+
+        limits.maxSteps = 50;
+        const RunResult result = counter.resume(configuration, limits);
+
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == 100);
+        REQUIRE(configuration.steps == 100);
+    }
+
+    SECTION("Blank areas are run-length encoded") {
+
+        vector<TuringMachine<>::Transition> delta{{0, 'a', 1, 'x', RIGHT}};
+
+        for(int i = 1; i < 10000; ++i) {
+            delta.push_back({i, ' ', i + 1, ' ', RIGHT});
+        }
+
+        delta.push_back({10000, ' ', 10001, 'y', LEFT});
+        TuringMachine<> m(0, 10001, -1, delta);
+
+        auto configuration = m.start("a");
+        limits.maxSteps = 10000;
+        REQUIRE(m.resume(configuration, limits).verdict == Verdict::OutOfFuel);
+
+        ostringstream out;
+        saveConfiguration(out, configuration);
+        REQUIRE(out.str().size() < 128);
+
+        istringstream in(out.str());
+        auto loaded = loadConfiguration<int, char>(in);
+
+        string finalTape;
+        REQUIRE(m.resume(loaded, {}, &finalTape).accepted());
+        REQUIRE(finalTape == "x" + string(9999, ' ') + "y");
+    }
+
+    SECTION("Checkpoints are written periodically in the background") {
+
+        {
+            Checkpointer<int, char> checkpointer(file, 10000);
+            auto configuration = counter.start("0");
+
+            REQUIRE(counter.resumeObserved(configuration, limits, checkpointer).verdict == Verdict::OutOfFuel);
+            checkpointer.wait();
+            REQUIRE(checkpointer.saved() >= 1);
+        }
+
+        auto loaded = loadConfiguration<int, char>(file);
+        REQUIRE(loaded.steps >= 10000);
+        REQUIRE(loaded.steps <= 50000);
+
+        string finalTape;
+        REQUIRE(counter.resume(loaded, limits, &finalTape).steps == expected.steps);
+        REQUIRE(finalTape == expectedTape);
+    }
+
+    SECTION("A failed background write is reported by wait() only") {
+
+        Checkpointer<int, char> checkpointer(file.parent_path() / "CppTM_Tests_missing_directory" / "checkpoint.bin", 10000);
+        auto configuration = counter.start("0");
+
+        REQUIRE(counter.resumeObserved(configuration, limits, checkpointer).verdict == Verdict::OutOfFuel);
+        REQUIRE(configuration.steps == expected.steps);
+        REQUIRE_THROWS_AS(checkpointer.wait(), std::runtime_error);
+        REQUIRE_NOTHROW(checkpointer.wait());
+    }
+
+    SECTION("Files that are not checkpoints are refused") {
+
+        istringstream in("TRMCHTR1 not a checkpoint");
+        REQUIRE_THROWS_AS((loadConfiguration<int, char>(in)), std::runtime_error);
+    }
+
+    SECTION("Corrupt lengths are refused before allocating the tape") {
+
+        /// A checkpoint of an empty tape followed by one run, and the head at head
+        const auto corrupt = [](int64_t head, uint8_t kind, uint64_t length) {
+            ostringstream out;
+            const auto write = [&out](const auto& value) {
+                out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            };
+
+            out.write(checkpoint::magic.data(), checkpoint::magic.size());
+            write(uint32_t(sizeof(int)));
+            write(uint32_t(sizeof(char)));
+            write(int(0));
+            write(head);
+            write(uint64_t(0));
+            write(' ');
+            write(uint64_t(0));
+            write(int64_t(0));
+            write(uint64_t(1));
+            write(kind);
+            write(length);
+            out << "abc";
+
+            return out.str();
+        };
+
+        istringstream longBlankRun(corrupt(0, 0, uint64_t(1) << 62));
+        REQUIRE_THROWS_AS((loadConfiguration<int, char>(longBlankRun)), std::runtime_error);
+
+        istringstream longStoredRun(corrupt(0, 1, uint64_t(1) << 27));
+        REQUIRE_THROWS_AS((loadConfiguration<int, char>(longStoredRun)), std::runtime_error);
+
+        istringstream farHead(corrupt(int64_t(1) << 62, 1, 3));
+        REQUIRE_THROWS_AS((loadConfiguration<int, char>(farHead)), std::runtime_error);
+
+        istringstream valid(corrupt(0, 1, 3));
+        REQUIRE(loadConfiguration<int, char>(valid).tape.contents<string>() == "abc");
+    }
+
+    filesystem::remove(file);
+}
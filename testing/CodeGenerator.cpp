@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+
+#include "ReferenceMachines.h"
+#include "codegen/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+
+using Generated = RunResult (*)(string_view, const RunLimits&, string*);
+
+void requireSameRun(const TuringMachine<>& machine, Generated generated, const string& input, const RunLimits& limits)
+{
+    string expectedTape, generatedTape;
+
+    const RunResult expected = machine.run(input, limits, &expectedTape);
+    const RunResult result = generated(input, limits, &generatedTape);
+
+    INFO("Input " << quote(input) << ", budget " << limits.maxSteps);
+    REQUIRE(result.verdict == expected.verdict);
+    REQUIRE(result.steps == expected.steps);
+    REQUIRE(result.head == expected.head);
+    REQUIRE(generatedTape == expectedTape);
+}
+
+}
+
+TEST_CASE("Generated interpreters") {
+
+    SECTION("Binary increment") {
+
+        const auto machine = reference::binaryIncrement();
+
+        for(const string input : {"", "0", "1", "1011", "111111", "10x1", "1000000000000000000000"}) {
+            requireSameRun(machine, generated::binaryIncrement, input, {});
+        }
+    }
+
+    SECTION("0^n1^n") {
+
+        const auto machine = reference::zerosThenOnes();
+
+        for(int zeros = 0; zeros < 30; ++zeros) {
+            for(int ones : {zeros - 1, zeros, zeros + 1}) {
+                if(ones >= 0) {
+                    requireSameRun(machine, generated::zerosThenOnes, string(zeros, '0') + string(ones, '1'), {});
+                }
+            }
+        }
+
+        requireSameRun(machine, generated::zerosThenOnes, "0101", {});
+    }
+
+    SECTION("Step budgets stop both at the same step") {
+
+        for(std::size_t budget : {0, 1, 2, 100, 4095, 4096, 4097, 100000}) {
+            RunLimits limits;
+            limits.maxSteps = budget;
+
+            requireSameRun(reference::leftForever(), generated::leftForever, "aaa", limits);
+            requireSameRun(reference::zerosThenOnes(), generated::zerosThenOnes, string(200, '0') + string(200, '1'), limits);
+        }
+    }
+}
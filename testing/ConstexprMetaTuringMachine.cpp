@@ -0,0 +1,46 @@
+#include <catch2/catch.hpp>
+
+#include "MetaTuringMachine.h"
+#include "TuringMachine.h"
+#include "testing/MetaTuringMachineCases.h"
+
+using namespace trmch;
+
+TEST_CASE("ConstexprMetaTuringMachine") {
+
+    MetaTuringMachineCases<MetaEngine<ConstexprMetaTuringMachine>>::run();
+
+    SECTION("Long runs") {
+
+        /// Binary counter on 14 bits, least significant bit first after a '#' marker, accepting when it overflows
+        using Counter = ConstexprMetaTuringMachine<
+            INPUT("#00000000000000"),
+            3, -1, 2,
+            MetaTransition<2, '#', 0, '#', RIGHT>,
+            MetaTransition<0, '1', 0, '0', RIGHT>,
+            MetaTransition<0, '0', 1, '1', LEFT>,
+            MetaTransition<0, ' ', 3, ' ', RIGHT>,
+            MetaTransition<1, '0', 1, '0', LEFT>,
+            MetaTransition<1, '1', 1, '1', LEFT>,
+            MetaTransition<1, '#', 0, '#', RIGHT>
+        >;
+
+        static_assert(Counter::accept);
+        static_assert(Counter::steps > 50000, "Tens of thousands of steps are evaluated at compile time");
+
+        /* The head never moves left of the marker, so the runtime engine runs the same steps */
+        TuringMachine<> counter(2, 3, -1, {
+            {2, '#', 0, '#', RIGHT},
+            {0, '1', 0, '0', RIGHT},
+            {0, '0', 1, '1', LEFT},
+            {0, ' ', 3, ' ', RIGHT},
+            {1, '0', 1, '0', LEFT},
+            {1, '1', 1, '1', LEFT},
+            {1, '#', 0, '#', RIGHT},
+        });
+
+        RunResult result = counter.run("#00000000000000", {});
+        REQUIRE(result.accepted());
+        REQUIRE(result.steps == Counter::steps);
+    }
+}
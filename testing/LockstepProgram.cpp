@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include "benchmark/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+
+/// Random words over alphabet, of lengths up to maxLength
+vector<string> randomWords(const string& alphabet, size_t count, size_t maxLength)
+{
+    mt19937 random(42);
+    vector<string> words(count);
+
+    for(string& word : words) {
+        word.resize(random() % (maxLength + 1));
+
+        for(char& symbol : word) {
+            symbol = alphabet[random() % alphabet.size()];
+        }
+    }
+
+    return words;
+}
+
+void requireSameResults(const vector<RunResult>& results, const vector<RunResult>& expected)
+{
+    REQUIRE(results.size() == expected.size());
+
+    for(size_t i = 0; i < results.size(); ++i) {
+        INFO("Input " << i);
+        REQUIRE(results[i].verdict == expected[i].verdict);
+        REQUIRE(results[i].steps == expected[i].steps);
+        REQUIRE(results[i].head == expected[i].head);
+    }
+}
+
+}
+
+TEST_CASE("TuringMachine::acceptLockstep") {
+
+    BatchOptions options;
+    options.threads = 2;
+
+    SECTION("Lockstep runs agree with acceptBatch()") {
+
+        const vector<string> palindromes = randomWords("ab", 2000, 20);
+        requireSameResults(bench::palindrome().acceptLockstep(palindromes, options),
+                           bench::palindrome().acceptBatch(palindromes, options));
+
+        /* '2' is outside of the alphabet of the machine */
+        const vector<string> numbers = randomWords("0112", 500, 40);
+        requireSameResults(bench::binaryIncrement().acceptLockstep(numbers, options),
+                           bench::binaryIncrement().acceptBatch(numbers, options));
+
+        const vector<string> words = randomWords("01", 3000, 12);
+        requireSameResults(bench::zerosThenOnes().acceptLockstep(words, options),
+                           bench::zerosThenOnes().acceptBatch(words, options));
+    }
+
+    SECTION("Long inputs go through run() without widening the window of the short ones") {
+
+        const size_t longLength = LockstepProgram<int, char>::maxLaneInput + 1;
+        vector<string> words = randomWords("01", 300, 12);
+
+        for(size_t i = 0; i < words.size(); i += 50) {
+            words[i] = string(longLength / 2, '0') + string(longLength - longLength / 2, '1');
+        }
+
+        requireSameResults(bench::zerosThenOnes().acceptLockstep(words, options),
+                           bench::zerosThenOnes().acceptBatch(words, options));
+    }
+
+    SECTION("The first step applies even if the initial state halts") {
+
+        const vector<string> words = randomWords("ab", 100, 4);
+
+        /* No transition: the first step rejects */
+        const TuringMachine<> acceptAtOnce(0, 0, 1, {{2, 'a', 0, 'a', RIGHT}});
+        requireSameResults(acceptAtOnce.acceptLockstep(words, options), acceptAtOnce.acceptBatch(words, options));
+
+        /// q0 is qR, but its transitions apply on the first step
+        const TuringMachine<> fromReject(0, 1, 0, {
+            {0, 'a', 1, 'a', RIGHT},
+            {0, 'b', 2, 'b', RIGHT},
+            {2, 'a', 1, 'a', RIGHT},
+        });
+        requireSameResults(fromReject.acceptLockstep(words, options), fromReject.acceptBatch(words, options));
+    }
+
+    SECTION("Each input has its own step budget") {
+
+        const vector<string> palindromes = randomWords("ab", 1000, 30);
+        vector<size_t> budgets(palindromes.size());
+
+        for(size_t i = 0; i < budgets.size(); ++i) {
+            budgets[i] = i % 50;
+        }
+
+        options.maxSteps = budgets;
+        const vector<RunResult> results = bench::palindrome().acceptLockstep(palindromes, options);
+        requireSameResults(results, bench::palindrome().acceptBatch(palindromes, options));
+
+        REQUIRE(results[0].verdict == Verdict::OutOfFuel);
+        REQUIRE(results[0].steps == 0);
+    }
+
+    SECTION("Runs leaving their window go through run()") {
+
+        /// Writes 1 to the right forever, and accepts the words starting with a
+        TuringMachine<> runaway(0, 2, -1, {
+            {0, 'a', 2, 'a', RIGHT},
+            {0, 'b', 1, 'b', RIGHT},
+            {1, 'b', 1, 'b', RIGHT},
+            {1, ' ', 1, '1', RIGHT},
+        });
+
+        const vector<string> inputs = randomWords("ab", 200, 8);
+        options.limits.maxSteps = 5000;
+
+        const vector<RunResult> results = runaway.acceptLockstep(inputs, options);
+        requireSameResults(results, runaway.acceptBatch(inputs, options));
+
+        const auto outOfFuel = count_if(results.begin(), results.end(), [](const RunResult& result) {
+            return result.verdict == Verdict::OutOfFuel && result.head > 4000;
+        });
+
+        REQUIRE(outOfFuel > 0);
+    }
+
+    SECTION("A stop request cancels the runs") {
+
+        stop_source stop;
+        stop.request_stop();
+        options.limits.stopToken = stop.get_token();
+
+        const vector<string> inputs = randomWords("ab", 100, 10);
+
+        for(const RunResult& result : bench::palindrome().acceptLockstep(inputs, options)) {
+            REQUIRE(result.verdict == Verdict::Cancelled);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include "MachineFile.h"
+#include "testing/TemporaryPath.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("MachineFile") {
+
+    /// Accepts the words made only of a
+    const string description =
+        "# Only a\n"
+        "initial 0\n"
+        "accept 1\n"
+        "reject -1\n"
+        "\n"
+        "0 'a' -> 0 'a' R   # skip the a\n"
+        "0 ' ' -> 1 ' ' L\n"
+        "0 b -> -1 b R\n";
+
+    SECTION("Text descriptions are parsed, written and parsed back") {
+
+        TuringMachine<> m = parseMachine(description);
+        REQUIRE(m.q0() == 0);
+        REQUIRE(m.qA() == 1);
+        REQUIRE(m.accept("aaa"));
+        REQUIRE_FALSE(m.accept("aba"));
+
+        ostringstream text;
+        writeMachineText(text, m);
+
+        TuringMachine<> copy = parseMachine(text.str());
+        REQUIRE(copy.deltaFunction().size() == 3);
+        REQUIRE(copy.accept("aaa"));
+        REQUIRE_FALSE(copy.accept("ab"));
+    }
+
+    SECTION("Quoted symbols support escapes") {
+
+        TuringMachine<> m = parseMachine("initial 0\naccept 1\nreject 2\n0 '\\'' -> 0 '\\\\' R\n0 ' ' -> 1 '\\n' R\n");
+        const auto transitions = m.deltaFunction();
+        REQUIRE(transitions.size() == 2);
+        REQUIRE(transitions[0].symbolOriginal == ' ');
+        REQUIRE(transitions[0].nextStep.writeSymbol == '\n');
+        REQUIRE(transitions[1].symbolOriginal == '\'');
+        REQUIRE(transitions[1].nextStep.writeSymbol == '\\');
+    }
+
+    SECTION("Errors locate the faulty line") {
+
+        const auto lineOf = [](const string& text) -> size_t {
+            try {
+                parseMachine(text, "test.tm");
+            }
+            catch(const MachineFormatError& e) {
+                REQUIRE(e.source() == "test.tm");
+                return e.line();
+            }
+
+            FAIL("No error");
+            return 0;
+        };
+
+        REQUIRE(lineOf("initial 0\naccept 1\nreject 2\n0 'a' -> 0 'a' X\n") == 4);
+        REQUIRE(lineOf("initial 0\naccept 1\nreject 2\n0 'a' 0 'a' R\n") == 4);
+        REQUIRE(lineOf("initial 0\naccept 1\nreject 2\n0 'ab' -> 0 'a' R\n") == 4);
+        REQUIRE(lineOf("initial 0\ninitial 1\n") == 2);
+        REQUIRE(lineOf("initial x\n") == 1);
+        REQUIRE(lineOf("initial 0\naccept 1\n0 'a' -> 0 'a' R\n") == 0);
+
+        /* Conflicting transitions report the second one and mention the first */
+        try {
+            parseMachine("initial 0\naccept 1\nreject 2\n0 'a' -> 0 'a' R\n\n0 'a' -> 1 'a' R\n", "test.tm");
+            FAIL("No error");
+        }
+        catch(const MachineFormatError& e) {
+            REQUIRE(e.line() == 6);
+            REQUIRE(string(e.what()).find("line 4") != string::npos);
+        }
+    }
+
+    SECTION("Binary descriptions are loaded from mapped files and directories") {
+
+        const filesystem::path directory = temporaryPath("machines");
+        filesystem::remove_all(directory);
+        filesystem::create_directories(directory);
+
+        TuringMachine<> m = parseMachine(description);
+
+        {
+            ofstream binary(directory / "b.tmb", ios::binary);
+            writeMachineBinary(binary, m);
+            ofstream text(directory / "a.tm");
+            text << description;
+            ofstream ignored(directory / "notes.txt");
+            ignored << "not a machine";
+        }
+
+        TuringMachine<> loaded = loadMachine(directory / "b.tmb");
+        REQUIRE(loaded.q0() == 0);
+        REQUIRE(loaded.qR() == -1);
+        REQUIRE(loaded.deltaFunction().size() == 3);
+        REQUIRE(loaded.accept("aa"));
+        REQUIRE_FALSE(loaded.accept("ab"));
+
+        ThreadPool pool(2);
+
+        for(ThreadPool* used : {static_cast<ThreadPool*>(nullptr), &pool}) {
+            const auto machines = loadMachines(directory, used);
+            REQUIRE(machines.size() == 2);
+            REQUIRE(machines[0].first == "a");
+            REQUIRE(machines[1].first == "b");
+            REQUIRE(machines[1].second.accept("aaaa"));
+        }
+
+        /* Truncated binary files are rejected */
+        {
+            ofstream broken(directory / "c.tmb", ios::binary);
+            ostringstream bytes;
+            writeMachineBinary(bytes, m);
+            broken << bytes.str().substr(0, bytes.str().size() - 1);
+        }
+
+        REQUIRE_THROWS_AS(loadMachine(directory / "c.tmb"), MachineFormatError);
+        REQUIRE_THROWS_AS(loadMachines(directory, &pool), MachineFormatError);
+
+        filesystem::remove_all(directory);
+    }
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include "MachineOptimizer.h"
+#include "benchmark/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("optimize") {
+
+    /// Accepts the words of a's. A b leads to a dead end that erases the rest of the word first,
+    /// and a c to a state looping forever. States 7 and 8 are never entered.
+    TuringMachine<> m(0, 2, -1, {
+        {0, 'a', 0, 'a', RIGHT},
+        {0, ' ', 2, ' ', RIGHT},
+        {0, 'b', 5, 'b', RIGHT},
+        {0, 'c', 6, 'c', RIGHT},
+        {5, 'a', 5, ' ', RIGHT},
+        {5, 'b', 5, ' ', RIGHT},
+        {6, ' ', 6, ' ', RIGHT},
+        {6, 'a', 6, 'a', LEFT},
+        {7, 'a', 8, 'a', RIGHT},
+        {8, 'a', 2, 'a', RIGHT},
+    });
+
+    SECTION("Unreachable states are removed and doomed states reject at once") {
+
+        const auto [optimized, report] = optimize(m);
+
+        REQUIRE(report.unreachableStates == vector<int>{7, 8});
+        REQUIRE(report.doomedStates == vector<int>{5, 6});
+        REQUIRE(report.redirectedTransitions == 2);
+        REQUIRE(report.removedTransitions == 6);
+        REQUIRE(report.statesBefore == 5);
+        REQUIRE(report.statesAfter == 1);
+        REQUIRE(report.transitionsAfter == 4);
+        REQUIRE(report.changed());
+
+        for(const string input : {"", "a", "aaa"}) {
+            REQUIRE(optimized.run(input, {}).accepted());
+            REQUIRE(optimized.run(input, {}).steps == m.run(input, {}).steps);
+        }
+
+        RunLimits limits;
+        limits.maxSteps = 1000;
+
+        REQUIRE(m.run("aabaaaa", limits).verdict == Verdict::Rejected);
+        REQUIRE(m.run("aabaaaa", limits).steps == 8);
+        REQUIRE(optimized.run("aabaaaa", limits).verdict == Verdict::Rejected);
+        REQUIRE(optimized.run("aabaaaa", limits).steps == 3);
+
+        /* The accepted inputs are the same, but a run looping in a doomed state now rejects */
+        REQUIRE(m.run("ac", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(optimized.run("ac", limits).verdict == Verdict::Rejected);
+    }
+
+    SECTION("Each pass can be turned off") {
+
+        OptimizeOptions options;
+        options.rejectDoomed = false;
+        options.renumber = false;
+
+        const auto [optimized, report] = optimize(m, options);
+        REQUIRE(report.doomedStates.empty());
+        REQUIRE(report.renumbered.empty());
+        REQUIRE(report.transitionsAfter == 8);
+
+        options.removeUnreachable = false;
+        REQUIRE(!optimize(m, options).report.changed());
+    }
+
+    SECTION("A machine that can never accept rejects on its first step") {
+
+        TuringMachine<> never(0, 2, -1, {
+            {0, 'a', 1, 'a', RIGHT},
+            {1, 'a', 0, 'a', LEFT},
+        });
+
+        const auto [optimized, report] = optimize(never);
+        REQUIRE(report.doomedStates == vector<int>{0, 1});
+        REQUIRE(report.transitionsAfter == 0);
+        REQUIRE(optimized.run("aa", {}).verdict == Verdict::Rejected);
+        REQUIRE(optimized.run("aa", {}).steps == 1);
+    }
+
+    SECTION("States are renumbered hottest first, around the halting states") {
+
+        /// Scans to the end of the input in state 9, then accepts: state 9 is the hottest
+        TuringMachine<> scan(4, 0, 1, {
+            {4, 'a', 9, 'a', RIGHT},
+            {9, 'a', 9, 'a', RIGHT},
+            {9, ' ', 0, ' ', RIGHT},
+        });
+
+        Profiler<int, char> profiler(scan);
+        REQUIRE(scan.runObserved("aaaaa", {}, profiler).accepted());
+
+        const auto [optimized, report] = optimize(scan, {}, &profiler);
+        REQUIRE(report.renumbered == vector<pair<int, int>>{{9, 2}, {4, 3}});
+        REQUIRE(optimized.q0() == 3);
+        REQUIRE(optimized.run("aaaaa", {}).steps == scan.run("aaaaa", {}).steps);
+
+        /* Without a profile, in breadth-first order */
+        REQUIRE(optimize(scan).report.renumbered == vector<pair<int, int>>{{4, 2}, {9, 3}});
+
+        ostringstream out;
+        report.write(out);
+        REQUIRE(out.str().find("Renumbered states (2): 9->2 4->3") != string::npos);
+    }
+
+    SECTION("Optimized machines agree with the originals") {
+
+        for(const auto& machine : {bench::palindrome(), bench::zerosThenOnes(), bench::binaryIncrement()}) {
+            const auto optimized = optimize(machine).machine;
+
+            for(const string input : {"", "ab", "abba", "0011", "0101", "1011", "aab"}) {
+                REQUIRE(optimized.run(input, {}).verdict == machine.run(input, {}).verdict);
+            }
+        }
+    }
+}
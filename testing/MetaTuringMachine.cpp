@@ -1,93 +1,14 @@
 #include <catch2/catch.hpp>
 
 #include "MetaTuringMachine.h"
+#include "testing/MetaTuringMachineCases.h"
 
 using namespace trmch;
 using namespace std;
 
 TEST_CASE("MetaTuringMachine") {
 
-    SECTION("No transition found should reject") {
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<>,
-            -1, -2, 0
-        >::accept, "[empty transitions][empty input][no transition used]");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<'a', 'b', 'c'>,
-            -1, -2, 0
-        >::accept, "[empty transitions][non-empty input][no transition used]");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<>,
-            -1, -2, 0,
-            MetaTransition<100, 'x', 101, 'y', RIGHT>
-        >::accept, "[non-empty transitions][empty input][no transition used]");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<'a', 'b', 'c'>,
-            -1, -2, 0,
-            MetaTransition<100, 'x', 101, 'y', RIGHT>
-        >::accept, "[non-empty transitions][non-empty input][no transition used]");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<>,
-            -1, -2, 0,
-            MetaTransition<0, ' ', 1, 'x', RIGHT>
-        >::accept, "[non-empty transitions][empty input (replaced by blank)][some transitions used]");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<'a', 'b', 'c'>,
-            -1, -2, 0,
-            MetaTransition<0, 'a', 1, 'x', RIGHT>
-        >::accept, "[non-empty transitions][non-empty input][some transitions used]");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<'0'>,
-            -1, -2, 100,
-            MetaTransition<0, '0', 1, 'x', RIGHT>,
-            MetaTransition<1, ' ', 2, 'y', RIGHT>,
-            MetaTransition<2, ' ', 3, 'z', RIGHT>
-        >::accept, "There are some transitions, none are used");
-
-        static_assert(!MetaTuringMachine<
-            MetaInput<'0'>,
-            -1, -2, 0,
-            MetaTransition<0, '0', 1, 'x', RIGHT>,
-            MetaTransition<1, ' ', 2, 'y', RIGHT>,
-            MetaTransition<2, ' ', 3, 'z', RIGHT>
-        >::accept, "Some transitions are used");
-    }
-
-    SECTION("Simple machines that should accept the input") {
-
-        static_assert(MetaTuringMachine<
-            MetaInput<>,
-            -1, -2, 0,
-            MetaTransition<0, ' ', -1, 'x', RIGHT>
-        >::accept);
-
-        static_assert(MetaTuringMachine<
-            MetaInput<'a'>,
-            5, -2, 0,
-            MetaTransition<0, 'a', 1, 'x', RIGHT>,
-            MetaTransition<0, 'x', 100, 'x', RIGHT>, // unused
-            MetaTransition<1, ' ', 2, 'x', LEFT>,
-            MetaTransition<2, ' ', 100, 'x', LEFT>, // unused
-            MetaTransition<2, 'x', 3, 'y', LEFT>, // Do not move
-            MetaTransition<3, 'y', 4, 'z', LEFT>, // Do not move
-            MetaTransition<4, 'z', 5, 'z', RIGHT>
-        >::accept);
-
-        static_assert(MetaTuringMachine<
-            MetaInput<'0', '0'>,
-            1, -1, 0,
-            MetaTransition<0, '0', 1, '#', RIGHT>,
-            MetaTransition<0, '1', 2, '_', RIGHT>,
-            MetaTransition<2, ' ', 1, '~', RIGHT>
-        >::accept);
-    }
+    MetaTuringMachineCases<MetaEngine<MetaTuringMachine>>::run();
 
     SECTION("Internal implementation") {
 
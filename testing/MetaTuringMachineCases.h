@@ -0,0 +1,108 @@
+#pragma once
+
+#include <catch2/catch.hpp>
+
+#include "MetaTuringMachine.h"
+
+/// Engine of MetaTuringMachineCases, Engine being MetaTuringMachine or ConstexprMetaTuringMachine
+/// The states are taken as int and converted here: GCC can't convert them inside a template template parameter.
+template<template<class, trmch::AcceptState, trmch::RejectState, trmch::InitialState, class...> class Engine>
+struct MetaEngine {
+    template<class Input, int acceptState, int rejectState, int initialState, class... Transitions>
+    using Machine = Engine<Input, trmch::AcceptState(acceptState), trmch::RejectState(rejectState), trmch::InitialState(initialState), Transitions...>;
+};
+
+/// Cases of the compile-time engines, run by the test of each engine: the same machines must give the same verdicts
+template<class Engine>
+struct MetaTuringMachineCases {
+    template<class Input, int acceptState, int rejectState, int initialState, class... Transitions>
+    using Machine = typename Engine::template Machine<Input, acceptState, rejectState, initialState, Transitions...>;
+
+    /// Runs the cases, as sections of the calling test case
+    static void run()
+    {
+        using namespace trmch;
+
+        SECTION("No transition found should reject") {
+
+            static_assert(!Machine<
+                MetaInput<>,
+                -1, -2, 0
+            >::accept, "[empty transitions][empty input][no transition used]");
+
+            static_assert(!Machine<
+                MetaInput<'a', 'b', 'c'>,
+                -1, -2, 0
+            >::accept, "[empty transitions][non-empty input][no transition used]");
+
+            static_assert(!Machine<
+                MetaInput<>,
+                -1, -2, 0,
+                MetaTransition<100, 'x', 101, 'y', RIGHT>
+            >::accept, "[non-empty transitions][empty input][no transition used]");
+
+            static_assert(!Machine<
+                MetaInput<'a', 'b', 'c'>,
+                -1, -2, 0,
+                MetaTransition<100, 'x', 101, 'y', RIGHT>
+            >::accept, "[non-empty transitions][non-empty input][no transition used]");
+
+            static_assert(!Machine<
+                MetaInput<>,
+                -1, -2, 0,
+                MetaTransition<0, ' ', 1, 'x', RIGHT>
+            >::accept, "[non-empty transitions][empty input (replaced by blank)][some transitions used]");
+
+            static_assert(!Machine<
+                MetaInput<'a', 'b', 'c'>,
+                -1, -2, 0,
+                MetaTransition<0, 'a', 1, 'x', RIGHT>
+            >::accept, "[non-empty transitions][non-empty input][some transitions used]");
+
+            static_assert(!Machine<
+                MetaInput<'0'>,
+                -1, -2, 100,
+                MetaTransition<0, '0', 1, 'x', RIGHT>,
+                MetaTransition<1, ' ', 2, 'y', RIGHT>,
+                MetaTransition<2, ' ', 3, 'z', RIGHT>
+            >::accept, "There are some transitions, none are used");
+
+            static_assert(!Machine<
+                MetaInput<'0'>,
+                -1, -2, 0,
+                MetaTransition<0, '0', 1, 'x', RIGHT>,
+                MetaTransition<1, ' ', 2, 'y', RIGHT>,
+                MetaTransition<2, ' ', 3, 'z', RIGHT>
+            >::accept, "Some transitions are used");
+        }
+
+        SECTION("Simple machines that should accept the input") {
+
+            static_assert(Machine<
+                MetaInput<>,
+                -1, -2, 0,
+                MetaTransition<0, ' ', -1, 'x', RIGHT>
+            >::accept);
+
+            static_assert(Machine<
+                MetaInput<'a'>,
+                5, -2, 0,
+                MetaTransition<0, 'a', 1, 'x', RIGHT>,
+                MetaTransition<0, 'x', 100, 'x', RIGHT>, // unused
+                MetaTransition<1, ' ', 2, 'x', LEFT>,
+                MetaTransition<2, ' ', 100, 'x', LEFT>, // unused
+                MetaTransition<2, 'x', 3, 'y', LEFT>, // Do not move
+                MetaTransition<3, 'y', 4, 'z', LEFT>, // Do not move
+                MetaTransition<4, 'z', 5, 'z', RIGHT>
+            >::accept);
+
+            static_assert(Machine<
+                MetaInput<'0', '0'>,
+                1, -1, 0,
+                MetaTransition<0, '0', 1, '#', RIGHT>,
+                MetaTransition<0, '1', 2, '_', RIGHT>,
+                MetaTransition<2, ' ', 1, '~', RIGHT>
+            >::accept);
+        }
+    }
+};
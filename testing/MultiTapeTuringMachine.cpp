@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+
+#include "MultiTapeTuringMachine.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+
+/// Recognizes palindromes over {0, 1} in O(n) steps: copies the input on the second tape,
+/// rewinds the first head, then compares the input forward with the copy backward
+MultiTapeTuringMachine<2> palindromes()
+{
+    vector<MultiTapeTuringMachine<2>::Transition> delta;
+
+    for(char a : {'0', '1'}) {
+        delta.push_back({0, {a, ' '}, 0, {a, a}, {RIGHT, RIGHT}});
+        delta.push_back({1, {a, ' '}, 1, {a, ' '}, {LEFT, STAY}});
+        delta.push_back({2, {a, a}, 2, {a, a}, {RIGHT, LEFT}});
+
+        for(char b : {'0', '1'}) {
+            delta.push_back({1, {a, b}, 1, {a, b}, {LEFT, STAY}});
+            delta.push_back({1, {' ', b}, 2, {' ', b}, {RIGHT, STAY}});
+        }
+    }
+
+    delta.push_back({0, {' ', ' '}, 1, {' ', ' '}, {LEFT, LEFT}});
+    delta.push_back({1, {' ', ' '}, 2, {' ', ' '}, {RIGHT, STAY}});
+    delta.push_back({2, {' ', ' '}, 10, {' ', ' '}, {STAY, STAY}});
+
+    return MultiTapeTuringMachine<2>(0, 10, -1, delta);
+}
+
+}
+
+TEST_CASE("MultiTapeTuringMachine") {
+
+    SECTION("Palindromes are recognized in linear time") {
+
+        const auto m = palindromes();
+
+        for(size_t length = 0; length <= 10; ++length) {
+            for(size_t bits = 0; bits < (size_t(1) << length); ++bits) {
+                string input;
+
+                for(size_t i = 0; i < length; ++i) {
+                    input += (bits >> i) & 1 ? '1' : '0';
+                }
+
+                const bool palindrome = equal(input.begin(), input.end(), input.rbegin());
+                const RunResult result = m.run(input, {});
+
+                REQUIRE(result.accepted() == palindrome);
+                REQUIRE(result.steps <= 3 * length + 3);
+            }
+        }
+    }
+
+    SECTION("Each tape keeps its own contents") {
+
+        array<string, 2> finalTapes;
+        REQUIRE(palindromes().accept("0110", &finalTapes));
+        REQUIRE(finalTapes[0] == "0110");
+        REQUIRE(finalTapes[1] == "0110");
+    }
+
+    SECTION("The heads can leave the input on both sides") {
+
+        /* Writes x left of the input on the first tape and y right of it on the second one */
+        MultiTapeTuringMachine<2> m(0, 3, -1, {
+            {0, {'a', ' '}, 1, {'a', ' '}, {LEFT, RIGHT}},
+            {1, {' ', ' '}, 2, {'x', 'y'}, {STAY, STAY}},
+            {2, {'x', 'y'}, 3, {'x', 'y'}, {RIGHT, LEFT}},
+        });
+
+        array<string, 2> finalTapes;
+        const RunResult result = m.run("a", {}, &finalTapes);
+
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.head == 0);
+        REQUIRE(finalTapes[0] == "xa");
+        REQUIRE(finalTapes[1] == " y");
+    }
+
+    SECTION("A missing transition rejects, a step budget stops a looping machine") {
+
+        MultiTapeTuringMachine<3> m(0, 1, -1, {
+            {0, {'a', ' ', ' '}, 0, {'a', 'b', 'c'}, {STAY, RIGHT, LEFT}},
+        });
+
+        REQUIRE(m.run("b", {}).verdict == Verdict::Rejected);
+
+        RunLimits limits;
+        limits.maxSteps = 100000;
+
+        const RunResult result = m.run("a", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == 100000);
+    }
+
+    SECTION("Large alphabets fall back to a hashed table") {
+
+        vector<MultiTapeTuringMachine<4>::Transition> delta;
+
+        for(char c = 'a'; c <= 'z'; ++c) {
+            delta.push_back({0, {c, ' ', ' ', ' '}, 0, {c, c, c, c}, {RIGHT, RIGHT, RIGHT, RIGHT}});
+        }
+
+        delta.push_back({0, {' ', ' ', ' ', ' '}, 1, {' ', ' ', ' ', ' '}, {STAY, STAY, STAY, STAY}});
+
+        array<string, 4> finalTapes;
+        REQUIRE(MultiTapeTuringMachine<4>(0, 1, -1, delta).accept("hello", &finalTapes));
+        REQUIRE(finalTapes[3] == "hello");
+    }
+
+    SECTION("Conflicting transitions are rejected when the table is built") {
+
+        REQUIRE_THROWS_AS(MultiTapeTuringMachine<2>(0, 1, -1, {
+            {0, {'a', ' '}, 1, {'a', 'a'}, {RIGHT, RIGHT}},
+            {0, {'a', ' '}, 1, {'a', 'b'}, {RIGHT, RIGHT}},
+        }), std::invalid_argument);
+    }
+
+    SECTION("Machines whose transitions don't fit in a 64-bit key are rejected") {
+
+        /* 64 symbols and the code of the others need 7 bits per tape, 84 bits for 12 tapes */
+        vector<MultiTapeTuringMachine<12>::Transition> delta;
+        MultiTapeTuringMachine<12>::Symbols read;
+        read.fill(' ');
+        const MultiTapeTuringMachine<12>::Moves moves{RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT, RIGHT};
+
+        for(char c = '0'; c < '0' + 64; ++c) {
+            read[0] = c;
+            delta.push_back({0, read, 1, read, moves});
+        }
+
+        REQUIRE_THROWS_AS(MultiTapeTuringMachine<12>(0, 1, -1, delta), std::invalid_argument);
+    }
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+
+#include "TuringMachine.h"
+#include "NondeterministicTuringMachine.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("NondeterministicTuringMachine") {
+
+    SECTION("An input is accepted if one branch accepts") {
+
+        /* Guesses where "11" starts */
+        NondeterministicTuringMachine<> m(0, 2, -1, {
+            {0, '0', 0, '0', RIGHT},
+            {0, '1', 0, '1', RIGHT},
+            {0, '1', 1, '1', RIGHT},
+            {1, '1', 2, '1', RIGHT},
+        });
+
+        const SearchResult result = m.search("0101101", {});
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.depth == 5);
+
+        REQUIRE(m.search("010101", {}).verdict == Verdict::Rejected);
+        REQUIRE(!m.accept(""));
+    }
+
+    SECTION("The first step applies the transitions of q0 even if it is qA, like the deterministic machines") {
+
+        NondeterministicTuringMachine<> m(0, 0, 1, {
+            {0, 'a', 2, 'a', RIGHT},
+            {2, ' ', 0, ' ', LEFT},
+            {0, 'b', 1, 'b', RIGHT},
+        });
+        TuringMachine<> deterministic(0, 0, 1, {
+            {0, 'a', 2, 'a', RIGHT},
+            {2, ' ', 0, ' ', LEFT},
+            {0, 'b', 1, 'b', RIGHT},
+        });
+
+        const SearchResult result = m.search("a", {});
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.depth == 2);
+        REQUIRE(deterministic.run("a", {}).steps == 2);
+
+        REQUIRE_FALSE(m.accept("b"));
+        REQUIRE_FALSE(deterministic.accept("b"));
+    }
+
+    SECTION("Configurations seen before are not explored again, so looping branches don't prevent rejection") {
+
+        NondeterministicTuringMachine<> m(0, 3, -1, {
+            {0, 'a', 1, 'a', RIGHT},
+            {0, 'a', 2, 'a', RIGHT},
+            {1, ' ', 0, ' ', LEFT},
+            {2, 'b', 3, 'b', RIGHT},
+        });
+
+        const SearchResult result = m.search("a", {});
+        REQUIRE(result.verdict == Verdict::Rejected);
+        REQUIRE(result.configurations == 3);
+
+        REQUIRE(m.accept("ab"));
+    }
+
+    SECTION("Depth, frontier and memory limits stop an infinite search") {
+
+        /* Writes a growing string of guessed symbols */
+        NondeterministicTuringMachine<> m(0, 1, -1, {
+            {0, ' ', 0, 'x', RIGHT},
+            {0, ' ', 0, 'y', RIGHT},
+        });
+
+        SearchLimits limits;
+        limits.run.maxSteps = 8;
+        SearchResult result = m.search("", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.depth == 8);
+        REQUIRE(result.peakFrontier == 256);
+
+        limits = {};
+        limits.maxFrontier = 1000;
+        result = m.search("", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.peakFrontier == 1024);
+
+        limits = {};
+        limits.maxMemory = 1 << 20;
+        result = m.search("", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.memory > limits.maxMemory);
+    }
+
+    SECTION("Large levels are expanded in parallel") {
+
+        /* Guesses 12 bits over the input, then checks them against a pattern from right to left */
+        const string pattern = "101100111000";
+        vector<NondeterministicTuringMachine<>::Transition> delta;
+
+        for(int i = 0; i < 12; ++i) {
+            delta.push_back({i, '0', i + 1, '0', RIGHT});
+            delta.push_back({i, '0', i + 1, '1', RIGHT});
+            delta.push_back({100 + i, pattern[i], i == 0 ? 1000 : 100 + i - 1, pattern[i], LEFT});
+        }
+
+        delta.push_back({12, ' ', 111, ' ', LEFT});
+
+        NondeterministicTuringMachine<> m(0, 1000, -1, delta);
+
+        ThreadPool pool(4);
+        SearchLimits limits;
+        limits.pool = &pool;
+
+        string finalTape;
+        const SearchResult result = m.search("000000000000", limits, &finalTape);
+
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.depth == 25);
+        REQUIRE(result.peakFrontier == 4096);
+        REQUIRE(finalTape == pattern);
+    }
+}
+
+TEST_CASE("SharedTape") {
+
+    const string input = "abc";
+    SharedTape<char> a(' ');
+    a.assign(input.begin(), input.end());
+
+    SharedTape<char> b = a;
+    b.write(-100, 'x');
+    b.write(1, 'y');
+
+    REQUIRE(a[1] == 'b');
+    REQUIRE(b[1] == 'y');
+    REQUIRE(b[-100] == 'x');
+    REQUIRE(!(a == b));
+
+    b.write(-100, ' ');
+    b.write(1, 'b');
+
+    REQUIRE(a == b);
+    REQUIRE(a.hash() == b.hash());
+    REQUIRE(b.contents<string>() == "abc");
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch.hpp>
+
+#include <thread>
+
+#include "PackedTape.h"
+#include "benchmark/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("PackedTape") {
+
+    SECTION("The alphabet gives code 0 to blank and an extra code to other symbols") {
+
+        TapeAlphabet<char> alphabet(' ', {'1', 'a', '1', 'b'});
+        REQUIRE(alphabet.size() == 4);
+        REQUIRE(alphabet.code(' ') == 0);
+        REQUIRE(alphabet.code('z') == alphabet.other());
+        REQUIRE(alphabet.symbol(alphabet.code('b')) == 'b');
+        REQUIRE(TapeAlphabet<char>::bitsPerCell(alphabet.size()) == 2);
+        REQUIRE(TapeAlphabet<char>::bitsPerCell(alphabet.size() + 1) == 4);
+        REQUIRE(TapeAlphabet<char>::bitsPerCell(17) == 0);
+    }
+
+    SECTION("Cells are read, written and scanned across words") {
+
+        const string input(300, 'a');
+        PackedTape<2> tape;
+        tape.assign(input.begin(), input.end(), [](char c) { return c == 'a' ? 1u : 0u; });
+
+        REQUIRE(tape[0] == 1);
+        REQUIRE(tape[299] == 1);
+        REQUIRE(tape[300] == 0);
+        REQUIRE(tape[-1] == 0);
+
+        const auto cell = [&](ptrdiff_t position) { return static_cast<size_t>(tape.origin() + position); };
+
+        tape.set(cell(200), 2);
+        REQUIRE(tape.scan(cell(0), 1, 1, 1000) == 200);
+        REQUIRE(tape.scan(cell(10), 1, 1, 50) == 50);
+        REQUIRE(tape.scan(cell(299), -1, 1, 1000) == 99);
+        REQUIRE(tape.scan(cell(199), -1, 1, 1000) == 200);
+        REQUIRE(tape.scan(cell(-1), -1, 0, cell(-1) + 1) == cell(-1) + 1);
+
+        tape.reserve(tape.last() + 5);
+        tape.reserve(tape.first() - 5);
+        REQUIRE(tape[200] == 2);
+        REQUIRE(tape.contentBounds() == pair<ptrdiff_t, ptrdiff_t>(0, 300));
+
+        tape.set(cell(-3), 3);
+        REQUIRE(tape.contentBounds() == pair<ptrdiff_t, ptrdiff_t>(-3, 300));
+    }
+
+    SECTION("Packed runs agree with plain runs") {
+
+        const auto agree = [](const TuringMachine<>& machine, const string& input, const RunLimits& limits = {}) {
+            string expectedTape, packedTape;
+            const RunResult expected = machine.run(input, limits, &expectedTape);
+            const RunResult packed = machine.runPacked(input, limits, &packedTape);
+
+            REQUIRE(packed.verdict == expected.verdict);
+            REQUIRE(packed.steps == expected.steps);
+            REQUIRE(packed.head == expected.head);
+            REQUIRE(packedTape == expectedTape);
+        };
+
+        RunLimits busyBeaver5Limits;
+        busyBeaver5Limits.maxSteps = 1'000'000;
+
+        agree(bench::busyBeaver4(), "");
+        agree(bench::busyBeaver5(), "", busyBeaver5Limits);
+        agree(bench::binaryIncrement(), "1011");
+        agree(bench::binaryIncrement(), "111111");
+        agree(bench::unaryAddition(), "111+11");
+        agree(bench::palindrome(), "abbaabba");
+        agree(bench::palindrome(), "abbaab");
+        agree(bench::zerosThenOnes(), "000111");
+
+        /* Symbols the machine doesn't know reject when read, and stay on the final tape */
+        agree(bench::palindrome(), "abzba");
+        agree(bench::binaryIncrement(), "10x");
+    }
+
+    SECTION("The packed program is built once, on the first packed run of any copy of the machine") {
+
+        const TuringMachine<> machine = bench::binaryIncrement();
+        const TuringMachine<> copy = machine;
+
+        string expectedTape;
+        const RunResult expected = machine.run("1011", {}, &expectedTape);
+
+        vector<thread> threads;
+        vector<string> tapes(4);
+        vector<RunResult> results(tapes.size());
+
+        for(size_t i = 0; i < tapes.size(); ++i) {
+            threads.emplace_back([&, i] { results[i] = (i % 2 ? copy : machine).runPacked("1011", {}, &tapes[i]); });
+        }
+
+        for(thread& t : threads) {
+            t.join();
+        }
+
+        for(size_t i = 0; i < tapes.size(); ++i) {
+            REQUIRE(results[i].verdict == expected.verdict);
+            REQUIRE(results[i].steps == expected.steps);
+            REQUIRE(tapes[i] == expectedTape);
+        }
+
+        REQUIRE(copy.fingerprint() == machine.fingerprint());
+    }
+
+    SECTION("Binary machines use one bit per cell") {
+
+        size_t bytes = 0;
+        const RunResult result = bench::busyBeaver5().runPacked("", {}, nullptr, &bytes);
+
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.steps == 47'176'870);
+        REQUIRE(bytes <= 4 * 1024);
+    }
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include "PagedTape.h"
+#include "benchmark/Machines.h"
+#include "testing/TemporaryPath.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+    /// Runs machine on input from each kind of source, and checks that the runs agree with run()
+    void checkSources(const TuringMachine<>& machine, const string& input, const filesystem::path& file)
+    {
+        string expectedTape;
+        const RunResult expected = machine.run(input, {}, &expectedTape);
+
+        const auto check = [&](InputSource<char>& source) {
+            PagedTape<char> tape(source, machine.blank(), 16);
+            const RunResult result = runPaged(machine, tape);
+
+            REQUIRE(result.verdict == expected.verdict);
+            REQUIRE(result.steps == expected.steps);
+            REQUIRE(result.head == expected.head);
+            REQUIRE(tape.contents<string>() == expectedTape);
+        };
+
+        istringstream stream(input);
+        StreamInput<char> streamInput(stream);
+        check(streamInput);
+
+        size_t position = 0;
+        GeneratorInput<char> generatorInput([&](span<char> out) {
+            const size_t count = min(out.size(), input.size() - position);
+            copy_n(input.begin() + static_cast<ptrdiff_t>(position), count, out.begin());
+            position += count;
+            return count;
+        });
+        check(generatorInput);
+
+        ofstream(file, ios::binary) << input;
+        MappedInput<char> mappedInput(file);
+        check(mappedInput);
+    }
+}
+
+TEST_CASE("Paged tapes") {
+
+    const filesystem::path file = temporaryPath("paged.txt");
+
+    SECTION("Paged runs agree with run()") {
+
+        const TuringMachine<> palindrome = bench::palindrome();
+        const TuringMachine<> increment = bench::binaryIncrement();
+        const TuringMachine<> addition = bench::unaryAddition();
+
+        for(const string input : {"", "a", "abba", "abaaba", "abab"}) {
+            checkSources(palindrome, input, file);
+        }
+
+        /* Crosses many pages both ways, and sweeps across their boundaries */
+        checkSources(palindrome, string(40, 'a') + "b" + string(40, 'a'), file);
+        checkSources(palindrome, string(40, 'a') + "ab" + string(40, 'a'), file);
+
+        /* Grows to the left of the input, on blank pages */
+        checkSources(increment, string(50, '1'), file);
+        checkSources(increment, "1011", file);
+        checkSources(addition, string(30, '1') + "+" + string(20, '1'), file);
+        checkSources(bench::busyBeaver4(), "", file);
+    }
+
+    SECTION("Only the pages reached are read") {
+
+        /// Accepts the inputs starting with "ab", writing X over the a
+        TuringMachine<> prefix(0, 2, 3, {
+            {0, 'a', 1, 'X', RIGHT},
+            {1, 'b', 2, 'b', RIGHT},
+        });
+
+        /* An endless input */
+        size_t generated = 0;
+        GeneratorInput<char> endless([&](span<char> out) {
+            for(char& symbol : out) {
+                symbol = generated++ % 2 ? 'b' : 'a';
+            }
+
+            return out.size();
+        });
+
+        PagedTape<char> tape(endless, prefix.blank(), 64);
+        REQUIRE(runPaged(prefix, tape).accepted());
+        REQUIRE(generated == 64);
+        REQUIRE(tape.residentBytes() == 64);
+        REQUIRE(tape[0] == 'X');
+        REQUIRE(tape[1] == 'b');
+    }
+
+    SECTION("A mapped input is copied on write only") {
+
+        const string input = string(1 << 20, 'a') + "b";
+        ofstream(file, ios::binary) << input;
+
+        MappedInput<char> source(file);
+
+        /// Accepts the inputs whose first cell is an a
+        TuringMachine<> reader(0, 1, 2, {
+            {0, 'a', 1, 'a', RIGHT},
+        });
+
+        PagedTape<char> read(source, reader.blank());
+        REQUIRE(runPaged(reader, read).accepted());
+        REQUIRE(read.residentBytes() == 0);
+
+        /// Turns the first a into a b
+        TuringMachine<> writer(0, 1, 2, {
+            {0, 'a', 1, 'b', RIGHT},
+        });
+
+        PagedTape<char> written(source, writer.blank());
+        REQUIRE(runPaged(writer, written).accepted());
+        REQUIRE(written.residentBytes() == written.pageSize());
+        REQUIRE(written[0] == 'b');
+        REQUIRE(read[0] == 'a');
+        REQUIRE(source.mapped()[0] == 'a');
+
+        /* Sweeps the whole input to its end, without copying it */
+        TuringMachine<> sweeper(0, 1, 2, {
+            {0, 'a', 0, 'a', RIGHT},
+            {0, 'b', 1, 'b', RIGHT},
+        });
+
+        PagedTape<char> swept(source, sweeper.blank());
+        const RunResult result = runPaged(sweeper, swept);
+        REQUIRE(result.accepted());
+        REQUIRE(result.steps == input.size());
+        REQUIRE(swept.residentBytes() == swept.pageSize());    /* The last page, completed with blanks */
+        REQUIRE(swept.inputRead() == input.size());
+
+        PagedTape<char> otherBlank(source, '_');
+        REQUIRE_THROWS_AS(runPaged(sweeper, otherBlank), invalid_argument);
+    }
+
+    filesystem::remove(file);
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include "TuringMachine.h"
+#include "Profiler.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("Profiler") {
+
+    /// Replaces each a by x, then comes back to the start
+    TuringMachine<> m(0, 3, -1, {
+        {0, 'a', 0, 'x', RIGHT},
+        {0, ' ', 1, ' ', LEFT},
+        {1, 'x', 1, 'x', LEFT},
+        {1, ' ', 3, ' ', RIGHT},
+    });
+
+    Profiler<int, char> profiler(m);
+
+    SECTION("Transitions, states, head positions and tape extent are counted") {
+
+        const RunResult result = m.runObserved("aaa", {}, profiler);
+        REQUIRE(result.accepted());
+        REQUIRE(profiler.steps() == result.steps);
+        REQUIRE(profiler.runs() == 1);
+
+        const auto transitions = profiler.transitionHits();
+        REQUIRE(transitions.size() == 4);
+        REQUIRE(transitions[0].hits == 3);
+        REQUIRE(transitions[3].hits == 1);
+
+        const auto states = profiler.stateSteps();
+        REQUIRE(states.size() == 2);
+        REQUIRE(states[0].steps == 4);
+        REQUIRE(states[1].steps == 4);
+
+        REQUIRE(profiler.histogramFirst() == -1);
+        REQUIRE(profiler.headVisits(-1) == 1);
+        REQUIRE(profiler.headVisits(0) == 2);
+        REQUIRE(profiler.headVisits(3) == 1);
+        REQUIRE(profiler.maxExtent() == 5);
+    }
+
+    SECTION("A run growing to the left keeps one count per position") {
+
+        TuringMachine<> left(0, 1, -1, {
+            {0, ' ', 0, ' ', LEFT},
+            {0, 'a', 0, 'a', LEFT},
+        });
+
+        Profiler<int, char> leftProfiler(left);
+        RunLimits limits;
+        limits.maxSteps = 200000;
+
+        REQUIRE(left.runObserved("a", limits, leftProfiler).verdict == Verdict::OutOfFuel);
+        REQUIRE(leftProfiler.histogramFirst() == -199999);
+        REQUIRE(leftProfiler.headHistogram().size() == 200000);
+        REQUIRE(leftProfiler.headVisits(-199999) == 1);
+        REQUIRE(leftProfiler.headVisits(0) == 1);
+        REQUIRE(leftProfiler.headVisits(1) == 0);
+    }
+
+    SECTION("Steps without transition are counted in the state totals only") {
+
+        REQUIRE(m.runObserved("ab", {}, profiler).verdict == Verdict::Rejected);
+        REQUIRE(profiler.steps() == 2);
+        REQUIRE(profiler.transitionHits().size() == 1);
+        REQUIRE(profiler.stateSteps()[0].steps == 2);
+    }
+
+    SECTION("Results accumulate over runs and export to JSON and CSV") {
+
+        REQUIRE(m.runObserved("a", {}, profiler).accepted());
+        REQUIRE(m.runObserved("aa", {}, profiler).accepted());
+        REQUIRE(profiler.runs() == 2);
+        REQUIRE(profiler.transitionHits()[0].hits == 3);
+
+        ostringstream csv;
+        profiler.writeCsv(csv);
+        REQUIRE(csv.str().find("state,symbol,hits\n0,a,3\n") == 0);
+        REQUIRE(csv.str().find("1,\" \",2\n") != string::npos);
+
+        ostringstream json;
+        profiler.writeJson(json);
+        REQUIRE(json.str().find("{\"state\": \"0\", \"symbol\": \"a\", \"hits\": 3}") != string::npos);
+
+        profiler.reset();
+        REQUIRE(profiler.steps() == 0);
+        REQUIRE(profiler.transitionHits().empty());
+    }
+}
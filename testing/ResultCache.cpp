@@ -0,0 +1,167 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include "TuringMachine.h"
+#include "ResultCache.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("ResultCache") {
+
+    /// Accepts the words made only of a
+    TuringMachine<> onlyA(0, 1, -1, {
+        {0, 'a', 0, 'a', RIGHT},
+        {0, ' ', 1, ' ', LEFT},
+    });
+
+    ResultCache<> cache(2, true);
+
+    SECTION("Results are reused for the same machine and input") {
+
+        REQUIRE(cache.accept(onlyA, "aaa"));
+        REQUIRE(cache.accept(onlyA, "aaa"));
+        REQUIRE_FALSE(cache.accept(onlyA, "aba"));
+
+        string finalTape;
+        REQUIRE(cache.run(onlyA, "aaa", {}, &finalTape).steps == 4);
+        REQUIRE(finalTape == "aaa");
+
+        const auto statistics = cache.statistics();
+        REQUIRE(statistics.hits == 2);
+        REQUIRE(statistics.misses == 2);
+        REQUIRE(statistics.size == 2);
+    }
+
+    SECTION("The fingerprint follows the transitions") {
+
+        TuringMachine<> same(0, 1, -1, {
+            {0, ' ', 1, ' ', LEFT},
+            {0, 'a', 0, 'a', RIGHT},
+            {0, 'a', 0, 'a', RIGHT},
+        });
+
+        TuringMachine<> onlyB(0, 1, -1, {
+            {0, 'b', 0, 'b', RIGHT},
+            {0, ' ', 1, ' ', LEFT},
+        });
+
+        REQUIRE(same.fingerprint() == onlyA.fingerprint());
+        REQUIRE(onlyB.fingerprint() != onlyA.fingerprint());
+
+        REQUIRE(cache.accept(onlyA, "aa"));
+        REQUIRE(cache.accept(same, "aa"));
+        REQUIRE_FALSE(cache.accept(onlyB, "aa"));
+        REQUIRE(cache.statistics().hits == 1);
+    }
+
+    SECTION("Results are only reused under limits giving the same result") {
+
+        RunLimits limits;
+        limits.maxSteps = 3;
+        REQUIRE(cache.run(onlyA, "aaaa", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(cache.run(onlyA, "aaaa", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(cache.statistics().hits == 1);
+
+        limits.maxSteps = 10;
+        REQUIRE(cache.run(onlyA, "aaaa", limits).accepted());
+        limits.maxSteps = 5;
+        REQUIRE(cache.run(onlyA, "aaaa", limits).accepted());
+        limits.maxSteps = 4;
+        REQUIRE(cache.run(onlyA, "aaaa", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(cache.statistics().hits == 2);
+    }
+
+    SECTION("A run out of fuel without loop detection may hide a loop") {
+
+        TuringMachine<> loop(0, 5, -1, {
+            {0, 'a', 1, 'a', RIGHT},
+            {1, ' ', 0, ' ', LEFT},
+        });
+
+        RunLimits limits;
+        limits.maxSteps = 1000;
+        REQUIRE(cache.run(loop, "a", limits).verdict == Verdict::OutOfFuel);
+
+        limits.detectLoops = true;
+        REQUIRE(cache.run(loop, "a", limits).verdict == Verdict::Loops);
+        REQUIRE(cache.statistics().hits == 0);
+
+        /* The loop is kept over the runs out of fuel, which it doesn't answer */
+        limits.detectLoops = false;
+        REQUIRE(cache.run(loop, "a", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(cache.run(loop, "a", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(cache.statistics().hits == 0);
+
+        limits.detectLoops = true;
+        REQUIRE(cache.run(loop, "a", limits).verdict == Verdict::Loops);
+        REQUIRE(cache.statistics().hits == 1);
+    }
+
+    SECTION("A halting result is not replaced by a run out of fuel") {
+
+        RunLimits limits;
+        limits.maxSteps = 100;
+        REQUIRE(cache.run(onlyA, "aaaa", limits).accepted());
+
+        limits.maxSteps = 2;
+        REQUIRE(cache.run(onlyA, "aaaa", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(cache.statistics().misses == 2);
+
+        REQUIRE(cache.accept(onlyA, "aaaa"));
+        REQUIRE(cache.statistics().hits == 1);
+        REQUIRE(cache.statistics().misses == 2);
+    }
+
+    SECTION("The least recently used result is evicted") {
+
+        REQUIRE(cache.accept(onlyA, "a"));
+        REQUIRE(cache.accept(onlyA, "aa"));
+        REQUIRE(cache.accept(onlyA, "a"));
+        REQUIRE(cache.accept(onlyA, "aaa"));
+
+        REQUIRE(cache.statistics().evictions == 1);
+        REQUIRE(cache.accept(onlyA, "a"));
+        REQUIRE(cache.statistics().hits == 2);
+    }
+
+    SECTION("Batches only run the inputs without result") {
+
+        ResultCache<> large(100);
+        const vector<string> inputs{"a", "ab", "aa", "b"};
+
+        REQUIRE(large.accept(onlyA, "ab") == false);
+
+        BatchOptions options;
+        options.threads = 2;
+        const auto results = large.acceptBatch(onlyA, span<const string>(inputs), options);
+        REQUIRE(results[0].accepted());
+        REQUIRE_FALSE(results[1].accepted());
+        REQUIRE(results[2].accepted());
+        REQUIRE_FALSE(results[3].accepted());
+        REQUIRE(large.statistics().hits == 1);
+
+        large.acceptBatch(onlyA, span<const string>(inputs), options);
+        REQUIRE(large.statistics().hits == 5);
+
+        /* Concurrent users */
+        atomic<int> rejected = 0;
+        vector<thread> threads;
+
+        for(int t = 0; t < 4; ++t) {
+            threads.emplace_back([&] {
+                for(int i = 0; i < 200; ++i) {
+                    rejected += !large.accept(onlyA, string(i % 20, 'a'));
+                }
+            });
+        }
+
+        for(thread& t : threads) {
+            t.join();
+        }
+
+        REQUIRE(rejected == 0);
+        REQUIRE(large.statistics().size <= 100);
+    }
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include "RunScheduler.h"
+#include "benchmark/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("Resumable runs and their scheduler") {
+
+    /// Binary counter, least significant bit first: never halts
+    TuringMachine<> counter(0, 5, -1, {
+        {0, '1', 0, '0', RIGHT},
+        {0, '0', 1, '1', LEFT},
+        {0, ' ', 1, '1', LEFT},
+        {1, '0', 1, '0', LEFT},
+        {1, '1', 1, '1', LEFT},
+        {1, ' ', 0, ' ', RIGHT},
+    });
+
+    const TuringMachine<> beaver = bench::busyBeaver4();
+
+    SECTION("A resumable run pauses after each slice and ends like run()") {
+
+        string expectedTape, finalTape;
+        const RunResult expected = beaver.run("", {}, &expectedTape);
+
+        ResumableRun run = runResumable(beaver, "", {}, 10, &finalTape);
+        REQUIRE(!run.done());
+        REQUIRE_THROWS_AS(run.result(), logic_error);
+
+        size_t slices = 0;
+
+        while(!run.resume()) {
+            ++slices;
+            REQUIRE(run.steps() == slices * 10);
+        }
+
+        REQUIRE(slices == expected.steps / 10);
+        REQUIRE(run.result().verdict == expected.verdict);
+        REQUIRE(run.result().steps == expected.steps);
+        REQUIRE(run.result().head == expected.head);
+        REQUIRE(finalTape == expectedTape);
+    }
+
+    SECTION("The budget bounds the whole run") {
+
+        RunLimits limits;
+        limits.maxSteps = 95;
+
+        ResumableRun run = runResumable(counter, "0", limits, 10);
+        while(!run.resume()) {}
+
+        REQUIRE(run.result().verdict == Verdict::OutOfFuel);
+        REQUIRE(run.result().steps == 95);
+    }
+
+    SECTION("The deadline bounds the whole run") {
+
+        RunLimits limits;
+        limits.deadline = RunLimits::Clock::now() + chrono::milliseconds(20);
+
+        ResumableRun run = runResumable(counter, "0", limits, 1000);
+        while(!run.resume()) {}
+
+        REQUIRE(run.result().verdict == Verdict::OutOfFuel);
+        REQUIRE(RunLimits::Clock::now() >= *limits.deadline);
+
+        RunScheduler scheduler(1);
+        REQUIRE(scheduler.submit(counter, string("0"), limits, 0, 1000).get().verdict == Verdict::OutOfFuel);
+    }
+
+    SECTION("Loops are detected across slices") {
+
+        RunLimits limits;
+        limits.detectLoops = true;
+
+        TuringMachine<> loop(0, 5, -1, {
+            {0, 'a', 1, 'b', RIGHT},
+            {1, ' ', 2, ' ', LEFT},
+            {2, 'b', 1, 'b', RIGHT},
+        });
+
+        ResumableRun run = runResumable(loop, "a", limits, 1);
+        while(!run.resume()) {}
+        REQUIRE(run.result().verdict == Verdict::Loops);
+
+        run = runResumable(beaver, "", limits, 10);
+        while(!run.resume()) {}
+        REQUIRE(run.result().accepted());
+        REQUIRE(run.result().steps == 107);
+    }
+
+    SECTION("Short runs finish while a long run holds the only worker") {
+
+        RunScheduler scheduler(1);
+        RunScheduler::Job endless = scheduler.submit(counter, string("0"), {}, 0, 1000);
+
+        vector<RunScheduler::Job> jobs;
+
+        for(int i = 0; i < 100; ++i) {
+            jobs.push_back(scheduler.submit(beaver, string(), {}, 0, 1000));
+        }
+
+        for(RunScheduler::Job& job : jobs) {
+            const RunResult result = job.get();
+            REQUIRE(result.accepted());
+            REQUIRE(result.steps == 107);
+        }
+
+        REQUIRE(!endless.ready());
+        REQUIRE(scheduler.pending() == 1);
+
+        endless.cancel();
+        const RunResult result = endless.get();
+        REQUIRE(result.verdict == Verdict::Cancelled);
+        REQUIRE(result.steps > 0);
+        REQUIRE(scheduler.pending() == 0);
+    }
+
+    SECTION("Budgets and stop tokens apply to scheduled runs") {
+
+        RunScheduler scheduler(2, SchedulingPolicy::Priority);
+
+        RunLimits limits;
+        limits.maxSteps = 12345;
+        RunScheduler::Job bounded = scheduler.submit(counter, string("0"), limits, 1, 100);
+
+        stop_source stop;
+        limits = {};
+        limits.stopToken = stop.get_token();
+        RunScheduler::Job stopped = scheduler.submit(counter, string("0"), limits, 0, 100);
+
+        const RunResult result = bounded.get();
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == 12345);
+
+        stop.request_stop();
+        REQUIRE(stopped.get().verdict == Verdict::Cancelled);
+    }
+
+    SECTION("A default-constructed job refers to no run") {
+
+        RunScheduler::Job job;
+        REQUIRE_FALSE(job.valid());
+        REQUIRE_FALSE(job.ready());
+        REQUIRE_NOTHROW(job.cancel());
+
+        RunScheduler scheduler(1);
+        job = scheduler.submit(counter, string("0"), {}, 0, 100);
+        REQUIRE(job.valid());
+        job.cancel();
+        REQUIRE(job.get().verdict == Verdict::Cancelled);
+    }
+
+    SECTION("Runs left are cancelled when the scheduler is destroyed") {
+
+        RunScheduler::Job endless;
+
+        {
+            RunScheduler scheduler(2);
+            endless = scheduler.submit(counter, string("0"));
+        }
+
+        REQUIRE(endless.get().verdict == Verdict::Cancelled);
+    }
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <new>
+#include <cstdlib>
+#include "benchmark/Machines.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+    thread_local size_t allocations = 0;
+}
+
+/* Counts the allocations of each thread. Built into its own test program: every form of the global allocation
+   functions but the aligned ones is replaced, so each allocation is freed by the matching function */
+void* operator new(size_t size)
+{
+    ++allocations;
+
+    if(void* memory = malloc(size ? size : 1)) {
+        return memory;
+    }
+
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    ++allocations;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete(void* memory, const nothrow_t&) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, const nothrow_t&) noexcept { free(memory); }
+
+TEST_CASE("RunWorkspace") {
+
+    const TuringMachine<> palindrome = bench::palindrome();
+    const TuringMachine<> increment = bench::binaryIncrement();
+
+    vector<string> inputs;
+
+    for(size_t size = 0; size < 200; ++size) {
+        inputs.push_back(string(size, 'a') + string(size % 3, 'b') + string(size, 'a'));
+    }
+
+    SECTION("Runs in a workspace agree with run()") {
+
+        RunWorkspace<int, char> workspace;
+        string expectedTape;
+
+        for(const string& input : inputs) {
+            const RunResult expected = palindrome.run(input, {}, &expectedTape);
+            const RunResult result = palindrome.run(workspace, input);
+
+            REQUIRE(result.verdict == expected.verdict);
+            REQUIRE(result.steps == expected.steps);
+            REQUIRE(result.head == expected.head);
+            REQUIRE(string(workspace.finalTape().begin(), workspace.finalTape().end()) == expectedTape);
+        }
+
+        /* The tape grows to the left of its storage */
+        REQUIRE(increment.run(workspace, string_view("1111111111")).accepted());
+        REQUIRE(string(workspace.finalTape().begin(), workspace.finalTape().end()) == "10000000000");
+    }
+
+    SECTION("A warmed-up workspace runs without allocating") {
+
+        RunWorkspace<int, char> workspace;
+        string finalTape;
+
+        /* Catch2 assertions may allocate: check the results after counting */
+        const auto runAll = [&] {
+            size_t halted = 0;
+
+            for(const string& input : inputs) {
+                halted += palindrome.run(workspace, input).halted();
+                workspace.copyFinalTape(finalTape);
+                halted += increment.run(workspace, string_view(input).substr(0, 40)).halted();
+            }
+
+            return halted;
+        };
+
+        REQUIRE(runAll() == 2 * inputs.size());
+        const size_t capacity = workspace.capacity();
+
+        const size_t before = allocations;
+        const size_t halted = runAll();
+        const size_t after = allocations;
+
+        REQUIRE(halted == 2 * inputs.size());
+        REQUIRE(after == before);
+        REQUIRE(workspace.capacity() >= capacity);
+    }
+
+    SECTION("The final tape reuses the storage of the string it is written to") {
+
+        string finalTape;
+        REQUIRE(palindrome.run(inputs.back(), {}, &finalTape).halted());
+
+        const size_t before = allocations;
+        const RunResult result = increment.run("1011", {}, &finalTape);
+        const size_t runAllocations = allocations - before;
+
+        REQUIRE(result.accepted());
+        REQUIRE(finalTape == "1100");
+
+        /* Only the tape of the run itself */
+        REQUIRE(runAllocations == 1);
+    }
+}
@@ -0,0 +1,165 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include "StaticTuringMachine.h"
+#include "TuringMachine.h"
+#include "PagedTape.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+    /// Accept { 0^n1^n | n > 0 }
+    /// Marks the first 0 with X and the first 1 with Y at each pass, then checks that only Ys remain.
+    using ZerosThenOnes = StaticTuringMachine<
+        5, -1, 0,
+        MetaTransition<0, '0', 1, 'X', RIGHT>,
+        MetaTransition<0, 'Y', 3, 'Y', RIGHT>,
+        MetaTransition<1, '0', 1, '0', RIGHT>,
+        MetaTransition<1, 'Y', 1, 'Y', RIGHT>,
+        MetaTransition<1, '1', 2, 'Y', LEFT>,
+        MetaTransition<2, '0', 2, '0', LEFT>,
+        MetaTransition<2, 'Y', 2, 'Y', LEFT>,
+        MetaTransition<2, 'X', 0, 'X', RIGHT>,
+        MetaTransition<3, 'Y', 3, 'Y', RIGHT>,
+        MetaTransition<3, ' ', 5, ' ', RIGHT>
+    >;
+
+    /* The same definition, proven at compile time */
+    static_assert(ZerosThenOnes::Meta<INPUT("0011")>::accept);
+    static_assert(!ZerosThenOnes::Meta<INPUT("0010")>::accept);
+    static_assert(ZerosThenOnes::ConstexprMeta<INPUT("000111")>::accept);
+    static_assert(ZerosThenOnes::rows == 4);
+}
+
+TEST_CASE("StaticTuringMachine") {
+
+    const ZerosThenOnes machine;
+
+    SECTION("Runs agree with TuringMachine") {
+
+        const TuringMachine<> reference(0, 5, -1, {
+            {0, '0', 1, 'X', RIGHT},
+            {0, 'Y', 3, 'Y', RIGHT},
+            {1, '0', 1, '0', RIGHT},
+            {1, 'Y', 1, 'Y', RIGHT},
+            {1, '1', 2, 'Y', LEFT},
+            {2, '0', 2, '0', LEFT},
+            {2, 'Y', 2, 'Y', LEFT},
+            {2, 'X', 0, 'X', RIGHT},
+            {3, 'Y', 3, 'Y', RIGHT},
+            {3, ' ', 5, ' ', RIGHT},
+        });
+
+        for(const string& input : vector<string>{"", "0", "1", "01", "0011", "0101", "0001111", string(300, '0') + string(300, '1')}) {
+            string expectedTape;
+            string tape;
+            const RunResult expected = reference.run(input, {}, &expectedTape);
+            const RunResult result = machine.run(input, {}, &tape);
+
+            REQUIRE(result.verdict == expected.verdict);
+            REQUIRE(result.steps == expected.steps);
+            REQUIRE(result.head == expected.head);
+            REQUIRE(tape == expectedTape);
+        }
+
+    }
+
+    SECTION("Streamed inputs") {
+
+        istringstream stream(string(50, '0') + string(50, '1'));
+        StreamInput<char> input(stream);
+        PagedTape<char> tape(input, machine.blank(), 16);
+
+        REQUIRE(runPaged(machine, tape).accepted());
+        REQUIRE(tape.contents<string>() == string(50, 'X') + string(50, 'Y'));
+    }
+
+    SECTION("The first matching transition applies") {
+
+        using FirstMatch = StaticTuringMachine<
+            1, 2, 0,
+            MetaTransition<0, 'a', 1, 'a', RIGHT>,
+            MetaTransition<0, 'a', 2, 'a', RIGHT>
+        >;
+
+        static_assert(FirstMatch::Meta<INPUT("a")>::accept);
+        REQUIRE(FirstMatch().accept("a"));
+        REQUIRE(FirstMatch().reject("b"));
+    }
+
+    SECTION("runMeta() runs like MetaTuringMachine") {
+
+        /// Moves left of the first cell: MetaTuringMachine stays on it, the runtime engine reaches a blank cell
+        using LeftOfInput = StaticTuringMachine<
+            5, -2, 0,
+            MetaTransition<0, 'a', 1, 'x', RIGHT>,
+            MetaTransition<1, ' ', 2, 'x', LEFT>,
+            MetaTransition<2, 'x', 3, 'y', LEFT>,
+            MetaTransition<3, 'y', 4, 'z', LEFT>,
+            MetaTransition<4, 'z', 5, 'z', RIGHT>
+        >;
+
+        static_assert(LeftOfInput::Meta<INPUT("a")>::accept);
+        REQUIRE(LeftOfInput().reject("a"));
+
+        string tape;
+        const RunResult result = LeftOfInput().runMeta("a", {}, &tape);
+        REQUIRE(result.accepted());
+        REQUIRE(result.steps == LeftOfInput::ConstexprMeta<INPUT("a")>::steps);
+        REQUIRE(tape == "zx");
+
+        /* A missing transition rejects without a step */
+        static_assert(!ZerosThenOnes::Meta<INPUT("0010")>::accept);
+        REQUIRE(machine.runMeta("0010").verdict == Verdict::Rejected);
+        REQUIRE(machine.runMeta("0010").steps == ZerosThenOnes::ConstexprMeta<INPUT("0010")>::steps);
+        REQUIRE(machine.run("0010", {}).steps == ZerosThenOnes::ConstexprMeta<INPUT("0010")>::steps + 1);
+
+        REQUIRE(machine.runMeta("000111").accepted());
+        REQUIRE(machine.runMeta("000111").steps == ZerosThenOnes::ConstexprMeta<INPUT("000111")>::steps);
+        REQUIRE(machine.runMeta("").verdict == Verdict::Rejected);
+
+        RunLimits limits;
+        limits.maxSteps = 5;
+        REQUIRE(machine.runMeta("000111", limits).verdict == Verdict::OutOfFuel);
+        REQUIRE(machine.runMeta("000111", limits).steps == 5);
+    }
+
+    SECTION("States are numbered densely whatever their numbers") {
+
+        /// Accepts the words made only of a, with states far apart
+        using Sparse = StaticTuringMachine<
+            -7, -1, 100000,
+            MetaTransition<100000, 'a', 100000, 'a', RIGHT>,
+            MetaTransition<100000, ' ', 3, ' ', LEFT>,
+            MetaTransition<3, 'a', -7, 'a', RIGHT>
+        >;
+
+        static_assert(Sparse::rows == 2);
+        static_assert(Sparse::Meta<INPUT("aa")>::accept);
+        REQUIRE(Sparse().accept("aaaa"));
+        REQUIRE(Sparse().reject("aba"));
+        REQUIRE(Sparse().runMeta("aaaa").accepted());
+
+        /// A few gaps between the numbers of the states
+        using Gaps = StaticTuringMachine<
+            9, -1, 0,
+            MetaTransition<0, 'a', 4, 'a', RIGHT>,
+            MetaTransition<4, 'a', 8, 'a', RIGHT>,
+            MetaTransition<8, ' ', 9, ' ', RIGHT>
+        >;
+
+        static_assert(Gaps::rows == 3);
+        REQUIRE(Gaps().accept("aa"));
+        REQUIRE(Gaps().reject("a"));
+        REQUIRE(Gaps().reject("aaa"));
+    }
+
+    SECTION("Machines without transitions") {
+
+        using Empty = StaticTuringMachine<1, 2, 0>;
+
+        static_assert(Empty::rows == 1, "The initial state, rejecting every symbol");
+        REQUIRE(Empty().run("abc", {}).verdict == Verdict::Rejected);
+    }
+}
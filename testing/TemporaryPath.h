@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <random>
+#include <filesystem>
+
+/// Path of a file named after name in the temporary directory, unique to this process
+/// Test programs running in parallel, e.g. with ctest -j, then never share their files.
+inline std::filesystem::path temporaryPath(const std::string& name)
+{
+    static const std::string suffix = std::to_string(std::random_device{}());
+    return std::filesystem::temp_directory_path() / ("CppTM_Tests_" + suffix + "_" + name);
+}
@@ -0,0 +1,159 @@
+#include <catch2/catch.hpp>
+
+#include "TuringMachine.h"
+#include "TraceReader.h"
+#include "testing/TemporaryPath.h"
+
+using namespace trmch;
+using namespace std;
+
+namespace {
+
+/// Cells of a snapshot from the first to the last non-blank one, including the input cells as TwoWayTape::contents does
+string contents(const TraceReader<int, char>::Snapshot& snapshot, size_t inputSize)
+{
+    ptrdiff_t first = 0;
+    ptrdiff_t last = static_cast<ptrdiff_t>(inputSize);
+
+    for(size_t i = 0; i < snapshot.cells.size(); ++i) {
+        if(snapshot.cells[i] != snapshot.blank) {
+            first = min(first, snapshot.first + ptrdiff_t(i));
+            last = max(last, snapshot.first + ptrdiff_t(i) + 1);
+        }
+    }
+
+    string tape;
+
+    for(ptrdiff_t position = first; position < last; ++position) {
+        tape += snapshot[position];
+    }
+
+    return tape;
+}
+
+}
+
+TEST_CASE("Execution traces") {
+
+    const filesystem::path file = temporaryPath("trace.bin");
+
+    /// Binary counter, least significant bit first
+    TuringMachine<> counter(0, 5, -1, {
+        {0, '1', 0, '0', RIGHT},
+        {0, '0', 1, '1', LEFT},
+        {0, ' ', 1, '1', LEFT},
+        {1, '0', 1, '0', LEFT},
+        {1, '1', 1, '1', LEFT},
+        {1, ' ', 0, ' ', RIGHT},
+    });
+
+    SECTION("Any step can be restored from the trace") {
+
+        RunLimits limits;
+        limits.maxSteps = 20000;
+
+        const RunResult traced = recordTrace(counter, "0", file, limits, nullptr, 1000);
+        REQUIRE(traced.verdict == Verdict::OutOfFuel);
+
+        const TraceReader<int, char> reader(file);
+        REQUIRE(reader.steps() == 20000);
+        REQUIRE(reader.verdict() == Verdict::OutOfFuel);
+        REQUIRE(reader.keyframes() == 21);
+
+        for(size_t step : {0, 1, 2, 999, 1000, 1001, 12345, 19999, 20000}) {
+            limits.maxSteps = step;
+
+            string expected;
+            const RunResult result = counter.run("0", limits, &expected);
+            const auto snapshot = reader.at(step);
+
+            REQUIRE(snapshot.step == step);
+            REQUIRE(snapshot.head == result.head);
+            REQUIRE(contents(snapshot, 1) == expected);
+        }
+
+        REQUIRE(reader.delta(1).state == 1);
+        REQUIRE(reader.delta(1).written == '1');
+        REQUIRE(reader.delta(1).move == -1);
+        REQUIRE_THROWS_AS(reader.at(20001), std::out_of_range);
+    }
+
+    SECTION("The halting step is recorded") {
+
+        TuringMachine<> m(0, 1, -1, {
+            {0, 'a', 0, 'b', RIGHT},
+            {0, ' ', 1, 'c', LEFT},
+        });
+
+        string finalTape;
+        REQUIRE(recordTrace(m, "aaa", file, {}, &finalTape).accepted());
+
+        const TraceReader<int, char> reader(file);
+        REQUIRE(reader.verdict() == Verdict::Accepted);
+        REQUIRE(reader.steps() == 4);
+
+        const auto snapshot = reader.at(4);
+        REQUIRE(snapshot.state == 1);
+        REQUIRE(snapshot.head == 2);
+        REQUIRE(contents(snapshot, 3) == finalTape);
+        REQUIRE(reader.at(2).state == 0);
+    }
+
+    SECTION("Incomplete files are refused") {
+
+        {
+            ofstream truncated(file, ios::binary | ios::trunc);
+            truncated << "TRMCHTR1";
+        }
+
+        REQUIRE_THROWS_AS((TraceReader<int, char>(file)), std::runtime_error);
+    }
+
+    SECTION("Corrupted indexes and keyframes are refused") {
+
+        RunLimits limits;
+        limits.maxSteps = 5000;
+        REQUIRE(recordTrace(counter, "0", file, limits, nullptr, 1000).verdict == Verdict::OutOfFuel);
+
+        const auto size = static_cast<streamoff>(filesystem::file_size(file));
+        const streamoff footer = size - static_cast<streamoff>(trace::footerSize);
+
+        uint64_t indexOffset = 0;
+        {
+            ifstream in(file, ios::binary);
+            in.seekg(footer);
+            in.read(reinterpret_cast<char*>(&indexOffset), sizeof(indexOffset));
+        }
+
+        /// Overwrites the 8 bytes at position with value in a copy of the trace, and opens the copy
+        const auto corrupted = [&](streamoff position, uint64_t value) {
+            const filesystem::path copy = temporaryPath("corrupted_trace.bin");
+            filesystem::copy_file(file, copy, filesystem::copy_options::overwrite_existing);
+
+            {
+                fstream out(copy, ios::binary | ios::in | ios::out);
+                out.seekp(position);
+                out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+
+            const auto open = [copy] { TraceReader<int, char> reader(copy); };
+            REQUIRE_THROWS_AS(open(), std::runtime_error);
+            filesystem::remove(copy);
+        };
+
+        REQUIRE_NOTHROW(TraceReader<int, char>(file));
+
+        /* A keyframe count whose index would wrap around */
+        corrupted(footer + 8, uint64_t(1) << 60);
+        /* A keyframe past the end of the file */
+        corrupted(static_cast<streamoff>(indexOffset) + 8, uint64_t(1) << 40);
+        /* More steps than the deltas after the last keyframe */
+        corrupted(footer + 16, 1000000);
+
+        /* A cell count past the end of the file, in the first keyframe */
+        const streamoff header = 8 + 2 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(char);
+        corrupted(header + trace::keyframeHeaderSize<int> - sizeof(uint64_t), uint64_t(1) << 40);
+    }
+
+    filesystem::remove(file);
+}
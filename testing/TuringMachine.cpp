@@ -0,0 +1,481 @@
+#include <catch2/catch.hpp>
+
+#include "TuringMachine.h"
+
+using namespace trmch;
+using namespace std;
+
+TEST_CASE("TuringMachine") {
+
+    SECTION("Transitions are looked up whatever their order in the delta function") {
+
+        TuringMachine<> m(0, 2, -1, {
+            {0, 'b', -1, 'b', RIGHT},
+            {1, 'x', 2, 'x', RIGHT},
+            {0, 'a', 0, 'x', RIGHT},
+            {0, ' ', 1, ' ', LEFT},
+        });
+
+        string finalTape;
+        REQUIRE(m.accept("aaa", &finalTape));
+        REQUIRE(finalTape.substr(0, 3) == "xxx");
+
+        REQUIRE(m.reject("aba"));
+        REQUIRE(m.reject("c"));
+    }
+
+    SECTION("Sparse state numbers are remapped") {
+
+        TuringMachine<> m(-1000, 1000000, -7, {
+            {-1000, 'a', 500000, 'a', RIGHT},
+            {500000, 'b', 1000000, 'b', RIGHT},
+        });
+
+        REQUIRE(m.accept("ab"));
+        REQUIRE(m.reject("aa"));
+    }
+
+    SECTION("Identical duplicate transitions are allowed") {
+
+        REQUIRE_NOTHROW(TuringMachine<>(0, 1, -1, {
+            {0, 'a', 1, 'a', RIGHT},
+            {0, 'a', 1, 'a', RIGHT},
+        }));
+    }
+
+    SECTION("Conflicting duplicate transitions are rejected when the table is built") {
+
+        REQUIRE_THROWS_AS(TuringMachine<>(0, 1, -1, {
+            {0, 'a', 1, 'a', RIGHT},
+            {0, 'a', 1, 'b', RIGHT},
+        }), std::invalid_argument);
+    }
+}
+
+TEST_CASE("TuringMachine::run limits") {
+
+    TuringMachine<> loop(0, 1, -1, {
+        {0, ' ', 0, ' ', RIGHT},
+        {0, 'a', 0, 'a', RIGHT},
+        {0, 'b', 1, 'b', RIGHT},
+    });
+
+    SECTION("A halting machine reports its verdict, step count and head") {
+
+        RunResult result = loop.run("aab", {});
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.steps == 3);
+        REQUIRE(result.head == 3);
+    }
+
+    SECTION("A step budget stops a looping machine") {
+
+        RunLimits limits;
+        limits.maxSteps = 10000;
+
+        RunResult result = loop.run("a", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == 10000);
+        REQUIRE(result.head == 10000);
+    }
+
+    SECTION("An expired deadline stops a looping machine") {
+
+        RunLimits limits;
+        limits.deadline = RunLimits::Clock::now() + std::chrono::milliseconds(10);
+
+        REQUIRE(loop.run("a", limits).verdict == Verdict::OutOfFuel);
+    }
+
+    SECTION("A stop request cancels the run") {
+
+        std::stop_source source;
+        source.request_stop();
+
+        RunLimits limits;
+        limits.stopToken = source.get_token();
+
+        RunResult result = loop.run("a", limits);
+        REQUIRE(result.verdict == Verdict::Cancelled);
+        REQUIRE(result.steps == 0);
+    }
+}
+
+TEST_CASE("TuringMachine::acceptBatch") {
+
+    /// Accept words of a's with an even length
+    TuringMachine<> even(0, 2, -1, {
+        {0, 'a', 1, 'a', RIGHT},
+        {1, 'a', 0, 'a', RIGHT},
+        {0, ' ', 2, ' ', RIGHT},
+    });
+
+    vector<string> inputs;
+    for(int i = 0; i < 1000; ++i) {
+        inputs.push_back(string(i, 'a'));
+    }
+
+    SECTION("Results are returned in input order") {
+
+        BatchOptions options;
+        options.threads = 4;
+
+        vector<RunResult> results = even.acceptBatch(inputs, options);
+        REQUIRE(results.size() == inputs.size());
+
+        for(std::size_t i = 0; i < inputs.size(); ++i) {
+            REQUIRE(results[i].accepted() == (i % 2 == 0));
+            REQUIRE(results[i].steps == i + 1);
+        }
+    }
+
+    SECTION("Each input has its own step budget") {
+
+        vector<std::size_t> budgets(inputs.size(), 10);
+
+        BatchOptions options;
+        options.maxSteps = budgets;
+
+        vector<RunResult> results = even.acceptBatch(inputs, options);
+        REQUIRE(results[8].verdict == Verdict::Accepted);
+        REQUIRE(results[10].verdict == Verdict::OutOfFuel);
+        REQUIRE(results[10].steps == 10);
+    }
+
+    SECTION("A batch can run from a task of the pool it uses") {
+
+        ThreadPool pool(2);
+        BatchOptions options;
+        options.pool = &pool;
+
+        vector<size_t> accepted(8);
+
+        pool.parallelFor(accepted.size(), [&](size_t i) {
+            for(const RunResult& result : even.acceptBatch(inputs, options)) {
+                accepted[i] += result.accepted();
+            }
+        });
+
+        REQUIRE(accepted == vector<size_t>(8, inputs.size() / 2));
+    }
+
+    SECTION("checkAccept reports the inputs with an unexpected verdict") {
+
+        auto report = even.checkAccept({"", "aa", "a"}, {"aaa", "aaaa"});
+        REQUIRE(report.checked == 5);
+        REQUIRE(!report.passed());
+        REQUIRE(report.failures.size() == 2);
+        REQUIRE(report.failures[0].input == "a");
+        REQUIRE(report.failures[0].expected == Verdict::Accepted);
+        REQUIRE(report.failures[1].input == "aaaa");
+        REQUIRE(report.failures[1].result.verdict == Verdict::Accepted);
+
+        REQUIRE(even.checkAccept({"", "aa"}, {"a", "aaa"}).passed());
+    }
+}
+
+TEST_CASE("TuringMachine two-way infinite tape") {
+
+    SECTION("Moving left of the input reaches blank cells instead of being clamped") {
+
+        TuringMachine<> m(0, 2, -1, {
+            {0, 'a', 1, 'a', LEFT},
+            {1, ' ', 2, 'b', RIGHT},
+        });
+
+        string finalTape;
+        RunResult result = m.run("a", {}, &finalTape);
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.head == 0);
+        REQUIRE(finalTape == "ba");
+    }
+
+    SECTION("The tape grows in both directions") {
+
+        /// Write 1000 x on the left of the input, then 1000 y on its right
+        vector<TuringMachine<>::Transition> delta;
+        for(int i = 0; i < 1000; ++i) {
+            delta.push_back({i, ' ', i + 1, 'x', LEFT});
+            delta.push_back({2000 + i, ' ', 2000 + i + 1, 'y', RIGHT});
+        }
+        delta.push_back({0, 'a', 0, 'a', LEFT});
+        delta.push_back({1000, ' ', 1001, ' ', RIGHT});
+        delta.push_back({1001, 'x', 1001, 'x', RIGHT});
+        delta.push_back({1001, 'a', 2000, 'a', RIGHT});
+
+        TuringMachine<> m(0, 3000, -1, delta);
+
+        string finalTape;
+        RunResult result = m.run("a", {}, &finalTape);
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.head == 1001);
+        REQUIRE(finalTape == string(1000, 'x') + "a" + string(1000, 'y'));
+    }
+
+    SECTION("Untouched blank cells are trimmed from the final tape but the input is kept") {
+
+        TuringMachine<> m(0, 1, -1, {
+            {0, ' ', 1, ' ', LEFT},
+        });
+
+        string finalTape;
+        REQUIRE(m.accept("", &finalTape));
+        REQUIRE(finalTape.empty());
+
+        REQUIRE(m.reject("a  ", &finalTape));
+        REQUIRE(finalTape == "a  ");
+    }
+}
+
+/// Handwritten machine accepting words of a's with an odd length, dispatched without virtual call
+class Odd : public BasicTuringMachine<Odd>
+{
+public:
+    Odd() : BasicTuringMachine(0, 2, -1) {}
+
+protected:
+    void oneStep(int currentState, char currentSymbol, NextStep &nextStep) const
+    {
+        if(currentSymbol == 'a') {
+            nextStep = {1 - currentState, 'a', RIGHT};
+        }
+        else if(currentSymbol == ' ' && currentState == 1) {
+            nextStep = {2, ' ', RIGHT};
+        }
+    }
+};
+
+/// The same machine behind the virtual interface
+class VirtualOdd : public AbstractTuringMachine<>
+{
+public:
+    VirtualOdd() : AbstractTuringMachine(0, 2, -1) {}
+
+protected:
+    void oneStep(int currentState, char currentSymbol, NextStep &nextStep) const override
+    {
+        if(currentSymbol == 'a') {
+            nextStep = {1 - currentState, 'a', RIGHT};
+        }
+        else if(currentSymbol == ' ' && currentState == 1) {
+            nextStep = {2, ' ', RIGHT};
+        }
+    }
+};
+
+TEST_CASE("Compile-time and virtual dispatch") {
+
+    Odd odd;
+    VirtualOdd virtualOdd;
+    VirtualTuringMachine<Odd> adaptedOdd(odd);
+    VirtualTuringMachine<TuringMachine<>> adaptedTable(TuringMachine<>(0, 2, -1, {
+        {0, 'a', 1, 'a', RIGHT},
+        {1, 'a', 0, 'a', RIGHT},
+        {1, ' ', 2, ' ', RIGHT},
+    }));
+
+    const AbstractTuringMachine<>* machines[] = {&virtualOdd, &adaptedOdd, &adaptedTable};
+
+    for(std::size_t length = 0; length < 10; ++length) {
+        const string input(length, 'a');
+        const RunResult expected = odd.run(input, {});
+
+        REQUIRE(expected.accepted() == (length % 2 == 1));
+
+        for(const AbstractTuringMachine<>* machine : machines) {
+            const RunResult result = machine->run(input, {});
+            REQUIRE(result.verdict == expected.verdict);
+            REQUIRE(result.steps == expected.steps);
+        }
+    }
+}
+
+TEST_CASE("TuringMachine sweeps") {
+
+    /// Unary addition: "1^a+1^b" becomes "1^(a+b)" by sweeping to the end, and back to the start
+    TuringMachine<> addition(0, 4, -1, {
+        {0, '1', 0, '1', RIGHT},
+        {0, '+', 0, '1', RIGHT},
+        {0, ' ', 1, ' ', LEFT},
+        {1, '1', 2, ' ', LEFT},
+        {2, '1', 2, '1', LEFT},
+        {2, ' ', 4, ' ', RIGHT},
+    });
+
+    /// The same machine alternating between two copies of each sweeping state, so nothing can be skipped
+    TuringMachine<> stepped(0, 4, -1, {
+        {0, '1', 10, '1', RIGHT},
+        {10, '1', 0, '1', RIGHT},
+        {0, '+', 10, '1', RIGHT},
+        {10, '+', 0, '1', RIGHT},
+        {0, ' ', 1, ' ', LEFT},
+        {10, ' ', 1, ' ', LEFT},
+        {1, '1', 2, ' ', LEFT},
+        {2, '1', 20, '1', LEFT},
+        {20, '1', 2, '1', LEFT},
+        {2, ' ', 4, ' ', RIGHT},
+        {20, ' ', 4, ' ', RIGHT},
+    });
+
+    SECTION("Step counts and tapes are exact") {
+
+        for(int a = 0; a < 40; ++a) {
+            const string input = string(a, '1') + "+" + string(a / 2 + 1, '1');
+            string finalTape;
+
+            RunResult result = addition.run(input, {}, &finalTape);
+            REQUIRE(result.verdict == Verdict::Accepted);
+            REQUIRE(finalTape == string(a + a / 2 + 1, '1') + " ");
+
+            /* Each cell is read once going right, the last one is erased, then each is read once going left */
+            const auto n = static_cast<std::size_t>(input.size());
+            REQUIRE(result.steps == (n + 1) + 1 + (n - 1) + 1);
+            REQUIRE(result.head == 0);
+        }
+    }
+
+    SECTION("A swept run is cut by the step budget at the exact step") {
+
+        const string input = string(10000, '1') + "+1";
+
+        for(std::size_t budget : {1, 7, 8, 9, 4095, 4096, 4097, 9999, 10001}) {
+            RunLimits limits;
+            limits.maxSteps = budget;
+
+            RunResult result = addition.run(input, limits);
+            REQUIRE(result.verdict == Verdict::OutOfFuel);
+            REQUIRE(result.steps == budget);
+            REQUIRE(result.head == static_cast<std::ptrdiff_t>(budget));
+        }
+    }
+
+    SECTION("A sweep over blank cells toward the left grows the tape") {
+
+        TuringMachine<> m(0, 1, -1, {
+            {0, ' ', 0, ' ', LEFT},
+            {0, 'a', 0, 'a', LEFT},
+        });
+
+        RunLimits limits;
+        limits.maxSteps = 100000;
+
+        RunResult result = m.run("aaaa", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == 100000);
+        REQUIRE(result.head == -100000);
+    }
+
+    SECTION("Sweeping and stepping machines agree") {
+
+        const string input = string(100, '1') + "+" + string(30, '1');
+        string sweptTape, steppedTape;
+
+        REQUIRE(addition.accept(input, &sweptTape));
+        REQUIRE(stepped.accept(input, &steppedTape));
+        REQUIRE(sweptTape == steppedTape);
+    }
+}
+
+TEST_CASE("TuringMachine loop detection") {
+
+    RunLimits limits;
+    limits.detectLoops = true;
+    limits.maxSteps = 1000000;
+
+    SECTION("A repeated configuration is reported as a loop") {
+
+        TuringMachine<> m(0, 5, -1, {
+            {0, 'a', 1, 'b', RIGHT},
+            {1, ' ', 2, ' ', LEFT},
+            {2, 'b', 1, 'b', RIGHT},
+        });
+
+        RunResult result = m.run("a", limits);
+        REQUIRE(result.verdict == Verdict::Loops);
+        REQUIRE(result.steps < 10);
+    }
+
+    SECTION("Drifting over blank cells forever is reported as a loop") {
+
+        TuringMachine<> drift(0, 5, -1, {
+            {0, 'a', 0, 'a', RIGHT},
+            {0, ' ', 0, ' ', RIGHT},
+        });
+
+        RunResult result = drift.run("aaaa", limits);
+        REQUIRE(result.verdict == Verdict::Loops);
+        REQUIRE(result.steps < 10);
+
+        /// Leaves a trail of x every other cell toward the left, stepping back over its last x each time
+        TuringMachine<> trail(0, 5, -1, {
+            {0, ' ', 1, 'x', LEFT},
+            {1, ' ', 2, ' ', RIGHT},
+            {2, 'x', 3, 'x', LEFT},
+            {3, ' ', 0, ' ', LEFT},
+        });
+
+        result = trail.run("", limits);
+        REQUIRE(result.verdict == Verdict::Loops);
+        REQUIRE(result.steps < 100);
+    }
+
+    SECTION("Halting machines are not affected") {
+
+        TuringMachine<> m(0, 1, -1, {
+            {0, 'a', 0, 'a', RIGHT},
+            {0, ' ', 1, ' ', RIGHT},
+        });
+
+        RunResult result = m.run("aaaa", limits);
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.steps == 5);
+    }
+
+    SECTION("A resumed run is not mistaken for a loop over the cells it wrote") {
+
+        /// Writes 11111111X, goes back to its left end, then sweeps right over the 1s and accepts on the X
+        vector<TuringMachine<>::Transition> transitions;
+
+        for(int state = 0; state < 8; ++state) {
+            transitions.push_back({state, ' ', {state + 1, '1', RIGHT}});
+        }
+
+        transitions.push_back({8, ' ', {9, 'X', LEFT}});
+        transitions.push_back({9, '1', {9, '1', LEFT}});
+        transitions.push_back({9, ' ', {10, ' ', RIGHT}});
+        transitions.push_back({10, '1', {10, '1', RIGHT}});
+        transitions.push_back({10, 'X', {11, 'X', RIGHT}});
+
+        const TuringMachine<> m(0, 11, -1, transitions);
+        const RunResult expected = m.run("", {});
+        REQUIRE(expected.accepted());
+
+        RunLimits pause;
+        pause.maxSteps = 19;
+        auto configuration = m.start("");
+        REQUIRE(m.resume(configuration, pause).verdict == Verdict::OutOfFuel);
+
+        const RunResult result = m.resume(configuration, limits);
+        REQUIRE(result.verdict == Verdict::Accepted);
+        REQUIRE(result.steps == expected.steps);
+    }
+
+    SECTION("A machine that never repeats itself runs out of fuel") {
+
+        /// Binary counter, least significant bit first
+        TuringMachine<> counter(0, 5, -1, {
+            {0, '1', 0, '0', RIGHT},
+            {0, '0', 1, '1', LEFT},
+            {0, ' ', 1, '1', LEFT},
+            {1, '0', 1, '0', LEFT},
+            {1, '1', 1, '1', LEFT},
+            {1, ' ', 0, ' ', RIGHT},
+        });
+
+        limits.maxSteps = 100000;
+
+        RunResult result = counter.run("0", limits);
+        REQUIRE(result.verdict == Verdict::OutOfFuel);
+        REQUIRE(result.steps == 100000);
+    }
+}
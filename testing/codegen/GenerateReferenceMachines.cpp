@@ -0,0 +1,11 @@
+#include "CodeGenerator.h"
+#include "Machines.h"
+
+int main(int argc, char** argv)
+{
+    return trmch::InterpreterGenerator("ReferenceMachines", "generated")
+        .add("binaryIncrement", reference::binaryIncrement())
+        .add("zerosThenOnes", reference::zerosThenOnes())
+        .add("leftForever", reference::leftForever())
+        .main(argc, argv);
+}
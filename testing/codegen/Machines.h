@@ -0,0 +1,55 @@
+#pragma once
+
+#include "TuringMachine.h"
+
+/// Machines compiled by the generator and checked against the interpreter
+namespace reference {
+
+using trmch::LEFT;
+using trmch::RIGHT;
+
+/// Adds one to a binary number, most significant bit first, and accepts
+inline trmch::TuringMachine<> binaryIncrement()
+{
+    return {0, 10, -1, {
+        {0, '0', 0, '0', RIGHT},
+        {0, '1', 0, '1', RIGHT},
+        {0, ' ', 1, ' ', LEFT},
+        {1, '1', 1, '0', LEFT},
+        {1, '0', 2, '1', LEFT},
+        {1, ' ', 10, '1', RIGHT},
+        {2, '0', 2, '0', LEFT},
+        {2, '1', 2, '1', LEFT},
+        {2, ' ', 10, ' ', RIGHT},
+    }};
+}
+
+/// Accepts { 0^n1^n | n > 0 } by crossing out the outermost 0 and 1 at each pass
+inline trmch::TuringMachine<> zerosThenOnes()
+{
+    return {0, 10, -1, {
+        {0, '0', 1, 'x', RIGHT},
+        {1, '0', 1, '0', RIGHT},
+        {1, '1', 1, '1', RIGHT},
+        {1, 'y', 2, 'y', LEFT},
+        {1, ' ', 2, ' ', LEFT},
+        {2, '1', 3, 'y', LEFT},
+        {3, '0', 3, '0', LEFT},
+        {3, '1', 3, '1', LEFT},
+        {3, 'x', 0, 'x', RIGHT},
+        {0, 'y', 4, 'y', RIGHT},
+        {4, 'y', 4, 'y', RIGHT},
+        {4, ' ', 10, ' ', RIGHT},
+    }};
+}
+
+/// Writes x forever toward the left, for step budgets
+inline trmch::TuringMachine<> leftForever()
+{
+    return {0, 10, -1, {
+        {0, ' ', 0, 'x', LEFT},
+        {0, 'a', 0, '\'', LEFT},
+    }};
+}
+
+}